@@ -0,0 +1,127 @@
+/*
+    Allocators of the containers:
+    - short-lived list/deque on std::allocator against Farebl::pmr with pool_resource and with
+      monotonic_arena (the arena variant drops the container by release(), without walking it);
+    - random indexing of the large deque on std::allocator against hugepage_allocator
+      (dependent loads, so the time per item is the latency of the TLB miss + the cache miss).
+*/
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <memory>       // for allocator
+#include <new>          // for placement new
+#include <type_traits>  // for is_same
+
+#include "bench_common.hpp"
+#include "perf_counters.hpp"
+#include "deque.hpp"
+#include "hugepage_allocator.hpp"
+#include "list.hpp"
+#include "pmr.hpp"
+
+namespace {
+
+using namespace Farebl::bench;
+
+void request_sizes(benchmark::internal::Benchmark* b){
+    b->RangeMultiplier(8)->Range(1 << 6, 1 << 15);
+}
+
+template <typename Container>
+void fill(Container& c, size_t size){
+    for (size_t i = 0; i < size; ++i) {c.push_back(static_cast<uint64_t>(i));}
+}
+
+
+template <typename Container>
+void BM_std_allocator(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    for (auto _ : state){
+        Container c;
+        fill(c, size);
+        benchmark::DoNotOptimize(c.back());
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+template <typename Container>
+Farebl::pmr::pool_resource make_pool(){
+    if constexpr (std::is_same<Container, Farebl::pmr::list<uint64_t>>::value){
+        return Farebl::pmr::make_list_pool<uint64_t>();
+    }
+    else{
+        return Farebl::pmr::make_deque_pool<uint64_t>();
+    }
+}
+
+// the pool lives across the iterations, so the freed nodes/buckets are reused
+template <typename Container>
+void BM_pool_resource(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    Farebl::pmr::pool_resource pool = make_pool<Container>();
+    for (auto _ : state){
+        Container c(&pool);
+        fill(c, size);
+        benchmark::DoNotOptimize(c.back());
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+// the request-scoped container: it is never destroyed, the arena is released instead
+template <typename Container>
+void BM_monotonic_arena(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    Farebl::pmr::monotonic_arena arena;
+    for (auto _ : state){
+        alignas(Container) unsigned char storage[sizeof(Container)];
+        Container* c = ::new (static_cast<void*>(storage)) Container(&arena);
+        fill(*c, size);
+        benchmark::DoNotOptimize(c->back());
+        arena.release();
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+
+// the elements form one random cycle: every element is the index of the next one
+template <typename Deque>
+void fill_random_cycle(Deque& d, size_t size){
+    for (size_t i = 0; i < size; ++i) {d.push_back(static_cast<uint64_t>(i));}
+    for (size_t i = size - 1; i > 0; --i){
+        size_t j = scramble(i) % i;
+        uint64_t temp = d[i];
+        d[i] = d[j];
+        d[j] = temp;
+    }
+}
+
+template <typename Deque>
+void BM_random_indexing(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    constexpr size_t steps = 1 << 20;
+    Deque d;
+    fill_random_cycle(d, size);
+    uint64_t index = 0;
+    perf_counters perf;
+    perf.start();
+    for (auto _ : state){
+        for (size_t i = 0; i < steps; ++i) {index = d[index];}
+        benchmark::DoNotOptimize(index);
+    }
+    perf.stop();
+    state.SetItemsProcessed(state.iterations() * steps);
+    perf.report(state, static_cast<double>(state.iterations() * steps));
+    state.SetBytesProcessed(state.iterations() * steps * sizeof(uint64_t));
+}
+
+} // end namespace
+
+BENCHMARK_TEMPLATE(BM_std_allocator, Farebl::list<uint64_t>)->Apply(request_sizes);
+BENCHMARK_TEMPLATE(BM_pool_resource, Farebl::pmr::list<uint64_t>)->Apply(request_sizes);
+BENCHMARK_TEMPLATE(BM_monotonic_arena, Farebl::pmr::list<uint64_t>)->Apply(request_sizes);
+BENCHMARK_TEMPLATE(BM_std_allocator, Farebl::deque<uint64_t>)->Apply(request_sizes);
+BENCHMARK_TEMPLATE(BM_pool_resource, Farebl::pmr::deque<uint64_t>)->Apply(request_sizes);
+BENCHMARK_TEMPLATE(BM_monotonic_arena, Farebl::pmr::deque<uint64_t>)->Apply(request_sizes);
+
+// 32 MiB and 512 MiB of elements
+BENCHMARK_TEMPLATE(BM_random_indexing, Farebl::deque<uint64_t>)->Arg(1 << 22)->Arg(1 << 26);
+BENCHMARK_TEMPLATE(BM_random_indexing, Farebl::deque<uint64_t, Farebl::hugepage_allocator<uint64_t>>)->Arg(1 << 22)->Arg(1 << 26);
@@ -0,0 +1,63 @@
+#ifndef FAREBL_BENCH_COMMON_H
+#define FAREBL_BENCH_COMMON_H
+
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <string>       // for string, to_string
+
+#include <benchmark/benchmark.h>
+
+namespace Farebl {
+namespace bench {
+
+// element, which is copied by memcpy, but is too large for the registers
+struct Payload64{
+    uint64_t key;
+    char padding[56];
+
+    bool operator<(const Payload64& other) const {return key < other.key;}
+    bool operator==(const Payload64& other) const {return key == other.key;}
+};
+
+// reproducible pseudo-random sequence (splitmix64), the same for all the compared containers
+inline uint64_t scramble(uint64_t value){
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+template <typename T>
+T make_value(uint64_t key);
+
+template <>
+inline int make_value<int>(uint64_t key) {return static_cast<int>(key);}
+
+template <>
+inline Payload64 make_value<Payload64>(uint64_t key) {return Payload64{key, {}};}
+
+// longer than the small string buffer, so every element owns the heap block
+template <>
+inline std::string make_value<std::string>(uint64_t key) {return "farebl-benchmark-value-" + std::to_string(key);}
+
+inline uint64_t key_of(int value) {return static_cast<uint64_t>(value);}
+inline uint64_t key_of(const Payload64& value) {return value.key;}
+inline uint64_t key_of(const std::string& value) {return value.size() + static_cast<unsigned char>(value.back());}
+
+template <typename Container>
+Container make_container(size_t size){
+    Container result;
+    for (size_t i = 0; i < size; ++i){
+        result.push_back(make_value<typename Container::value_type>(scramble(i)));
+    }
+    return result;
+}
+
+// count of the elements: 1K .. 256K
+inline void container_sizes(benchmark::internal::Benchmark* b){
+    b->RangeMultiplier(8)->Range(1 << 10, 1 << 18);
+}
+
+} // end namespace bench
+} // end namespace Farebl
+#endif // FAREBL_BENCH_COMMON_H
@@ -0,0 +1,152 @@
+#ifndef FAREBL_PERF_COUNTERS_H
+#define FAREBL_PERF_COUNTERS_H
+
+#include <cstdint>      // for uint64_t
+#include <cstring>      // for memset
+
+#include <linux/perf_event.h>   // for perf_event_attr, PERF_*
+#include <sys/ioctl.h>          // for ioctl
+#include <sys/syscall.h>        // for SYS_perf_event_open
+#include <unistd.h>             // for syscall, read, close
+
+#include <benchmark/benchmark.h>
+
+namespace Farebl {
+namespace bench {
+
+namespace perf_detail{
+    // config of the PERF_TYPE_HW_CACHE event: the read misses of the (cache)
+    constexpr uint64_t cache_read_miss(uint64_t cache){
+        return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+}
+
+/*
+    Hardware counters of the measured region (perf_event_open, user space only):
+    cycles, instructions, L1d read misses, LLC read misses, dTLB read misses and branch misses.
+
+    Every event has its own descriptor (not a group), so the kernel multiplexes them,
+    when the PMU has fewer counters than the events, and the values are scaled
+    by time_enabled / time_running. The events, which can't be opened (no PMU in the VM,
+    perf_event_paranoid > 2), are skipped and not reported.
+
+    Usage around the benchmark loop:
+        perf_counters perf;
+        perf.start();
+        for (auto _ : state){ ... perf.pause(); (setup) perf.resume(); ... }
+        perf.stop();
+        perf.report(state, items);   // the counters per item, e.g. "cycles" and "dTLB_misses"
+*/
+class perf_counters{
+public:
+    static constexpr int events_count = 6;
+
+private:
+    struct Event{
+        const char* name;
+        uint32_t type;
+        uint64_t config;
+    };
+
+    static constexpr Event events_[events_count] = {
+        {"cycles",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {"instructions",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {"L1d_misses",    PERF_TYPE_HW_CACHE, perf_detail::cache_read_miss(PERF_COUNT_HW_CACHE_L1D)},
+        {"LLC_misses",    PERF_TYPE_HW_CACHE, perf_detail::cache_read_miss(PERF_COUNT_HW_CACHE_LL)},
+        {"dTLB_misses",   PERF_TYPE_HW_CACHE, perf_detail::cache_read_miss(PERF_COUNT_HW_CACHE_DTLB)},
+        {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+    };
+
+    // layout of read() with PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING
+    struct ReadFormat{
+        uint64_t value;
+        uint64_t time_enabled;
+        uint64_t time_running;
+    };
+
+    int m_fds[events_count];
+    double m_values[events_count];
+
+    static int open_event_(const Event& event){
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = event.type;
+        attr.config = event.config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    void for_each_fd_(unsigned long request){
+        for (int fd: m_fds){
+            if (fd >= 0) {ioctl(fd, request, 0);}
+        }
+    }
+
+public:
+    perf_counters(){
+        for (int i = 0; i < events_count; ++i){
+            m_fds[i] = open_event_(events_[i]);
+            m_values[i] = 0.0;
+        }
+    }
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    ~perf_counters(){
+        for (int fd: m_fds){
+            if (fd >= 0) {close(fd);}
+        }
+    }
+
+    // false, if no event could be opened
+    bool available() const {
+        for (int fd: m_fds){
+            if (fd >= 0) {return true;}
+        }
+        return false;
+    }
+
+    void start(){
+        for_each_fd_(PERF_EVENT_IOC_RESET);
+        for_each_fd_(PERF_EVENT_IOC_ENABLE);
+    }
+
+    // pause/resume exclude the setup inside the loop (state.PauseTiming/ResumeTiming)
+    void pause() {for_each_fd_(PERF_EVENT_IOC_DISABLE);}
+    void resume() {for_each_fd_(PERF_EVENT_IOC_ENABLE);}
+
+    void stop(){
+        for_each_fd_(PERF_EVENT_IOC_DISABLE);
+        for (int i = 0; i < events_count; ++i){
+            ReadFormat data;
+            if (m_fds[i] < 0 || read(m_fds[i], &data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data.time_running == 0){
+                m_values[i] = -1.0;
+                continue;
+            }
+            m_values[i] = static_cast<double>(data.value) * static_cast<double>(data.time_enabled) / static_cast<double>(data.time_running);
+        }
+    }
+
+    // the counted value of the event (after stop()); negative - the event isn't available
+    double value(int event) const {return m_values[event];}
+
+    static const char* name(int event) {return events_[event].name;}
+
+    // the values per item (items - count of the processed items over all the iterations)
+    void report(benchmark::State& state, double items) const {
+        if (items <= 0.0) {return;}
+        for (int i = 0; i < events_count; ++i){
+            if (m_values[i] >= 0.0) {state.counters[events_[i].name] = m_values[i] / items;}
+        }
+        if (m_values[0] > 0.0 && m_values[1] >= 0.0) {state.counters["IPC"] = m_values[1] / m_values[0];}
+    }
+};
+
+} // end namespace bench
+} // end namespace Farebl
+#endif // FAREBL_PERF_COUNTERS_H
@@ -0,0 +1,272 @@
+/*
+    Hot paths of Farebl::list and Farebl::deque side by side with std::list and std::deque:
+    push/pop at both ends, iteration, random access, range insert/erase in the middle,
+    sort, remove_if and the queue workload. Every benchmark is instantiated for int,
+    Payload64 and std::string and reports items_per_second for the elements processed.
+*/
+#include <algorithm>    // for sort, remove_if
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <deque>        // for deque
+#include <iterator>     // for next
+#include <list>         // for list
+#include <string>       // for string
+#include <vector>       // for vector
+
+#include "bench_common.hpp"
+#include "perf_counters.hpp"
+#include "deque.hpp"
+#include "list.hpp"
+
+namespace {
+
+using namespace Farebl::bench;
+
+template <typename T>
+void sort_container(std::list<T>& c) {c.sort();}
+
+template <typename T, typename Allocator>
+void sort_container(Farebl::list<T, Allocator>& c) {c.sort();}
+
+template <typename Container>
+void sort_container(Container& c) {std::sort(c.begin(), c.end());}
+
+template <typename T, typename Predicate>
+void remove_if_container(std::list<T>& c, Predicate p) {c.remove_if(p);}
+
+template <typename T, typename Allocator, typename Predicate>
+void remove_if_container(Farebl::list<T, Allocator>& c, Predicate p) {c.remove_if(p);}
+
+template <typename Container, typename Predicate>
+void remove_if_container(Container& c, Predicate p) {c.erase(std::remove_if(c.begin(), c.end(), p), c.end());}
+
+template <typename Container>
+std::vector<typename Container::value_type> make_values(size_t size){
+    std::vector<typename Container::value_type> result;
+    result.reserve(size);
+    for (size_t i = 0; i < size; ++i){
+        result.push_back(make_value<typename Container::value_type>(scramble(i)));
+    }
+    return result;
+}
+
+
+template <typename Container>
+void BM_push_back(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    auto values = make_values<Container>(size);
+    perf_counters perf;
+    perf.start();
+    for (auto _ : state){
+        Container c;
+        for (const auto& value: values) {c.push_back(value);}
+        benchmark::DoNotOptimize(c.back());
+    }
+    perf.stop();
+    state.SetItemsProcessed(state.iterations() * size);
+    perf.report(state, static_cast<double>(state.iterations() * size));
+}
+
+template <typename Container>
+void BM_push_front(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    auto values = make_values<Container>(size);
+    perf_counters perf;
+    perf.start();
+    for (auto _ : state){
+        Container c;
+        for (const auto& value: values) {c.push_front(value);}
+        benchmark::DoNotOptimize(c.front());
+    }
+    perf.stop();
+    state.SetItemsProcessed(state.iterations() * size);
+    perf.report(state, static_cast<double>(state.iterations() * size));
+}
+
+template <typename Container>
+void BM_pop_back(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    perf_counters perf;
+    perf.start();
+    for (auto _ : state){
+        state.PauseTiming();
+        perf.pause();
+        Container c = make_container<Container>(size);
+        perf.resume();
+        state.ResumeTiming();
+        while (!c.empty()) {c.pop_back();}
+        benchmark::ClobberMemory();
+    }
+    perf.stop();
+    state.SetItemsProcessed(state.iterations() * size);
+    perf.report(state, static_cast<double>(state.iterations() * size));
+}
+
+template <typename Container>
+void BM_pop_front(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    perf_counters perf;
+    perf.start();
+    for (auto _ : state){
+        state.PauseTiming();
+        perf.pause();
+        Container c = make_container<Container>(size);
+        perf.resume();
+        state.ResumeTiming();
+        while (!c.empty()) {c.pop_front();}
+        benchmark::ClobberMemory();
+    }
+    perf.stop();
+    state.SetItemsProcessed(state.iterations() * size);
+    perf.report(state, static_cast<double>(state.iterations() * size));
+}
+
+template <typename Container>
+void BM_iterate(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    Container c = make_container<Container>(size);
+    perf_counters perf;
+    perf.start();
+    for (auto _ : state){
+        uint64_t sum = 0;
+        for (const auto& value: c) {sum += key_of(value);}
+        benchmark::DoNotOptimize(sum);
+    }
+    perf.stop();
+    state.SetItemsProcessed(state.iterations() * size);
+    perf.report(state, static_cast<double>(state.iterations() * size));
+}
+
+// deques only: operator[] at the scattered positions
+template <typename Container>
+void BM_random_access(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    Container c = make_container<Container>(size);
+    std::vector<size_t> positions(size);
+    for (size_t i = 0; i < size; ++i) {positions[i] = scramble(i + size) % size;}
+    perf_counters perf;
+    perf.start();
+    for (auto _ : state){
+        uint64_t sum = 0;
+        for (size_t pos: positions) {sum += key_of(c[pos]);}
+        benchmark::DoNotOptimize(sum);
+    }
+    perf.stop();
+    state.SetItemsProcessed(state.iterations() * size);
+    perf.report(state, static_cast<double>(state.iterations() * size));
+}
+
+// size/4 elements are inserted into the middle and erased back (the container is restored)
+template <typename Container>
+void BM_range_insert_erase(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    Container c = make_container<Container>(size);
+    auto values = make_values<Container>(size / 4);
+    perf_counters perf;
+    perf.start();
+    for (auto _ : state){
+        auto first = c.insert(std::next(c.begin(), size / 2), values.begin(), values.end());
+        auto last = std::next(first, values.size());
+        c.erase(first, last);
+        benchmark::DoNotOptimize(c.size());
+    }
+    perf.stop();
+    state.SetItemsProcessed(state.iterations() * values.size());
+    perf.report(state, static_cast<double>(state.iterations() * values.size()));
+}
+
+template <typename Container>
+void BM_sort(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    const Container source = make_container<Container>(size);
+    perf_counters perf;
+    perf.start();
+    for (auto _ : state){
+        state.PauseTiming();
+        perf.pause();
+        Container c(source);
+        perf.resume();
+        state.ResumeTiming();
+        sort_container(c);
+        benchmark::DoNotOptimize(c.front());
+    }
+    perf.stop();
+    state.SetItemsProcessed(state.iterations() * size);
+    perf.report(state, static_cast<double>(state.iterations() * size));
+}
+
+// a quarter of the elements is removed
+template <typename Container>
+void BM_remove_if(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    const Container source = make_container<Container>(size);
+    perf_counters perf;
+    perf.start();
+    for (auto _ : state){
+        state.PauseTiming();
+        perf.pause();
+        Container c(source);
+        perf.resume();
+        state.ResumeTiming();
+        remove_if_container(c, [](const typename Container::value_type& value){return key_of(value) % 4 == 0;});
+        benchmark::DoNotOptimize(c.size());
+    }
+    perf.stop();
+    state.SetItemsProcessed(state.iterations() * size);
+    perf.report(state, static_cast<double>(state.iterations() * size));
+}
+
+/*
+    Queue of (size) elements in the steady state: push_back + pop_front,
+    and every 8th round - the urgent push_front + pop_back.
+*/
+template <typename Container>
+void BM_queue_mixed(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    Container c = make_container<Container>(size);
+    auto values = make_values<Container>(size);
+    perf_counters perf;
+    perf.start();
+    for (auto _ : state){
+        for (size_t i = 0; i < size; ++i){
+            c.push_back(values[i]);
+            c.pop_front();
+            if ((i & 7) == 0){
+                c.push_front(values[i]);
+                c.pop_back();
+            }
+        }
+        benchmark::DoNotOptimize(c.front());
+    }
+    perf.stop();
+    state.SetItemsProcessed(state.iterations() * size);
+    perf.report(state, static_cast<double>(state.iterations() * size));
+}
+
+} // end namespace
+
+
+#define FAREBL_BENCHMARK_CONTAINER(Func, Container)                                  \
+    BENCHMARK_TEMPLATE(Func, Container<int>)->Apply(container_sizes);                \
+    BENCHMARK_TEMPLATE(Func, Container<Payload64>)->Apply(container_sizes);          \
+    BENCHMARK_TEMPLATE(Func, Container<std::string>)->Apply(container_sizes);
+
+#define FAREBL_BENCHMARK_DEQUES(Func)                                                \
+    FAREBL_BENCHMARK_CONTAINER(Func, Farebl::deque)                                  \
+    FAREBL_BENCHMARK_CONTAINER(Func, std::deque)
+
+#define FAREBL_BENCHMARK_ALL(Func)                                                   \
+    FAREBL_BENCHMARK_DEQUES(Func)                                                    \
+    FAREBL_BENCHMARK_CONTAINER(Func, Farebl::list)                                   \
+    FAREBL_BENCHMARK_CONTAINER(Func, std::list)
+
+FAREBL_BENCHMARK_ALL(BM_push_back)
+FAREBL_BENCHMARK_ALL(BM_push_front)
+FAREBL_BENCHMARK_ALL(BM_pop_back)
+FAREBL_BENCHMARK_ALL(BM_pop_front)
+FAREBL_BENCHMARK_ALL(BM_iterate)
+FAREBL_BENCHMARK_DEQUES(BM_random_access)
+FAREBL_BENCHMARK_ALL(BM_range_insert_erase)
+FAREBL_BENCHMARK_ALL(BM_sort)
+FAREBL_BENCHMARK_ALL(BM_remove_if)
+FAREBL_BENCHMARK_ALL(BM_queue_mixed)
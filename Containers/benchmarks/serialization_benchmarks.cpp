@@ -0,0 +1,139 @@
+/*
+    Serialization to the in-memory file (memfd): serialization::write/read of the deque
+    (writev/readv straight from/into the buckets) and of the list against the element-wise
+    iostream output (formatted operator<< and unformatted write()) and input.
+*/
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <fstream>      // for ofstream, ifstream
+#include <stdexcept>    // for runtime_error
+#include <string>       // for string, to_string
+
+#include <sys/mman.h>   // for memfd_create
+#include <unistd.h>     // for close, ftruncate, lseek
+
+#include "bench_common.hpp"
+#include "deque.hpp"
+#include "list.hpp"
+#include "serialization.hpp"
+
+namespace {
+
+using namespace Farebl::bench;
+
+// the file in memory, so the benchmark measures the copying and the syscalls, not the disk
+class memory_file{
+    int m_fd;
+
+public:
+    memory_file(): m_fd(memfd_create("farebl_benchmark", 0)){
+        if (m_fd < 0) {throw std::runtime_error("memfd_create failed");}
+    }
+    memory_file(const memory_file&) = delete;
+    memory_file& operator=(const memory_file&) = delete;
+    ~memory_file() {close(m_fd);}
+
+    int fd() const {return m_fd;}
+
+    // the path, through which the iostreams open the same file
+    std::string path() const {return "/proc/self/fd/" + std::to_string(m_fd);}
+
+    void rewind() {lseek(m_fd, 0, SEEK_SET);}
+
+    void truncate(){
+        if (ftruncate(m_fd, 0) != 0) {throw std::runtime_error("ftruncate failed");}
+        rewind();
+    }
+};
+
+template <typename Container>
+Container make_keys(size_t size){
+    Container result;
+    for (size_t i = 0; i < size; ++i) {result.push_back(scramble(i));}
+    return result;
+}
+
+
+template <typename Container>
+void BM_serialization_write(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    Container c = make_keys<Container>(size);
+    memory_file file;
+    for (auto _ : state){
+        file.truncate();
+        Farebl::serialization::write(file.fd(), c);
+    }
+    state.SetBytesProcessed(state.iterations() * size * sizeof(uint64_t));
+}
+
+template <typename Container>
+void BM_serialization_read(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    memory_file file;
+    Farebl::serialization::write(file.fd(), make_keys<Container>(size));
+    for (auto _ : state){
+        file.rewind();
+        Container c;
+        Farebl::serialization::read(file.fd(), c);
+        benchmark::DoNotOptimize(c.back());
+    }
+    state.SetBytesProcessed(state.iterations() * size * sizeof(uint64_t));
+}
+
+void BM_iostream_formatted_write(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    auto d = make_keys<Farebl::deque<uint64_t>>(size);
+    memory_file file;
+    for (auto _ : state){
+        file.truncate();
+        std::ofstream out(file.path());
+        for (uint64_t value: d) {out << value << '\n';}
+    }
+    state.SetBytesProcessed(state.iterations() * size * sizeof(uint64_t));
+}
+
+void BM_iostream_binary_write(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    auto d = make_keys<Farebl::deque<uint64_t>>(size);
+    memory_file file;
+    for (auto _ : state){
+        file.truncate();
+        std::ofstream out(file.path(), std::ios::binary);
+        for (const uint64_t& value: d) {out.write(reinterpret_cast<const char*>(&value), sizeof(value));}
+    }
+    state.SetBytesProcessed(state.iterations() * size * sizeof(uint64_t));
+}
+
+void BM_iostream_binary_read(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    memory_file file;
+    {
+        std::ofstream out(file.path(), std::ios::binary);
+        for (size_t i = 0; i < size; ++i){
+            uint64_t value = scramble(i);
+            out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+    }
+    for (auto _ : state){
+        std::ifstream in(file.path(), std::ios::binary);
+        Farebl::deque<uint64_t> d;
+        uint64_t value;
+        while (in.read(reinterpret_cast<char*>(&value), sizeof(value))) {d.push_back(value);}
+        benchmark::DoNotOptimize(d.back());
+    }
+    state.SetBytesProcessed(state.iterations() * size * sizeof(uint64_t));
+}
+
+void serialization_sizes(benchmark::internal::Benchmark* b){
+    b->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+}
+
+} // end namespace
+
+BENCHMARK_TEMPLATE(BM_serialization_write, Farebl::deque<uint64_t>)->Apply(serialization_sizes);
+BENCHMARK_TEMPLATE(BM_serialization_write, Farebl::list<uint64_t>)->Apply(serialization_sizes);
+BENCHMARK(BM_iostream_formatted_write)->Apply(serialization_sizes);
+BENCHMARK(BM_iostream_binary_write)->Apply(serialization_sizes);
+BENCHMARK_TEMPLATE(BM_serialization_read, Farebl::deque<uint64_t>)->Apply(serialization_sizes);
+BENCHMARK_TEMPLATE(BM_serialization_read, Farebl::list<uint64_t>)->Apply(serialization_sizes);
+BENCHMARK(BM_iostream_binary_read)->Apply(serialization_sizes);
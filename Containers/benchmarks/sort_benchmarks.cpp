@@ -0,0 +1,118 @@
+/*
+    Sorting of the large containers: list::parallel_sort against list::sort and against
+    copying into std::vector + std::sort (and back); parallel::sort of the deque against
+    std::sort over the deque iterators. The sizes are 1M and 10M elements
+    (and 100M with FAREBL_BENCHMARK_LARGE).
+*/
+#include <algorithm>    // for sort, copy
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <vector>       // for vector
+
+#include "bench_common.hpp"
+#include "deque.hpp"
+#include "deque_parallel.hpp"
+#include "list.hpp"
+
+namespace {
+
+using namespace Farebl::bench;
+
+void large_sizes(benchmark::internal::Benchmark* b){
+    b->Arg(1'000'000)->Arg(10'000'000);
+#ifdef FAREBL_BENCHMARK_LARGE
+    b->Arg(100'000'000);
+#endif
+    b->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+// the list is refilled by the assignment of the values, so the nodes stay where they were allocated
+template <typename Container>
+void refill(Container& c, const std::vector<uint64_t>& values){
+    auto it = c.begin();
+    for (uint64_t value: values) {*it = value; ++it;}
+}
+
+void BM_list_sort(benchmark::State& state){
+    std::vector<uint64_t> values(static_cast<size_t>(state.range(0)));
+    for (size_t i = 0; i < values.size(); ++i) {values[i] = scramble(i);}
+    Farebl::list<uint64_t> l(values.begin(), values.end());
+    for (auto _ : state){
+        state.PauseTiming();
+        refill(l, values);
+        state.ResumeTiming();
+        l.sort();
+        benchmark::DoNotOptimize(l.front());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+void BM_list_parallel_sort(benchmark::State& state){
+    std::vector<uint64_t> values(static_cast<size_t>(state.range(0)));
+    for (size_t i = 0; i < values.size(); ++i) {values[i] = scramble(i);}
+    Farebl::list<uint64_t> l(values.begin(), values.end());
+    for (auto _ : state){
+        state.PauseTiming();
+        refill(l, values);
+        state.ResumeTiming();
+        l.parallel_sort();
+        benchmark::DoNotOptimize(l.front());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+// the usual workaround: out to the vector, std::sort, back to the list
+void BM_list_via_vector_sort(benchmark::State& state){
+    std::vector<uint64_t> values(static_cast<size_t>(state.range(0)));
+    for (size_t i = 0; i < values.size(); ++i) {values[i] = scramble(i);}
+    Farebl::list<uint64_t> l(values.begin(), values.end());
+    std::vector<uint64_t> buffer;
+    for (auto _ : state){
+        state.PauseTiming();
+        refill(l, values);
+        state.ResumeTiming();
+        buffer.assign(l.begin(), l.end());
+        std::sort(buffer.begin(), buffer.end());
+        std::copy(buffer.begin(), buffer.end(), l.begin());
+        benchmark::DoNotOptimize(l.front());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+void BM_deque_std_sort(benchmark::State& state){
+    std::vector<uint64_t> values(static_cast<size_t>(state.range(0)));
+    for (size_t i = 0; i < values.size(); ++i) {values[i] = scramble(i);}
+    Farebl::deque<uint64_t> d;
+    d.push_back_n(values.data(), values.size());
+    for (auto _ : state){
+        state.PauseTiming();
+        refill(d, values);
+        state.ResumeTiming();
+        std::sort(d.begin(), d.end());
+        benchmark::DoNotOptimize(d.front());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+void BM_deque_parallel_sort(benchmark::State& state){
+    std::vector<uint64_t> values(static_cast<size_t>(state.range(0)));
+    for (size_t i = 0; i < values.size(); ++i) {values[i] = scramble(i);}
+    Farebl::deque<uint64_t> d;
+    d.push_back_n(values.data(), values.size());
+    for (auto _ : state){
+        state.PauseTiming();
+        refill(d, values);
+        state.ResumeTiming();
+        Farebl::parallel::sort(d);
+        benchmark::DoNotOptimize(d.front());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+} // end namespace
+
+BENCHMARK(BM_list_sort)->Apply(large_sizes);
+BENCHMARK(BM_list_parallel_sort)->Apply(large_sizes);
+BENCHMARK(BM_list_via_vector_sort)->Apply(large_sizes);
+BENCHMARK(BM_deque_std_sort)->Apply(large_sizes);
+BENCHMARK(BM_deque_parallel_sort)->Apply(large_sizes);
@@ -0,0 +1,117 @@
+/*
+    Farebl::static_list (the inline array of the nodes, 16-bit links, no allocator)
+    against the heap lists on the small embedded-style workloads: fill and drain,
+    the steady free-list churn (pop_front + push_back), the timer queue (the insertion
+    into the sorted position) and the iteration. The capacity is fixed at compile time,
+    so the sizes don't exceed static_capacity.
+*/
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <list>         // for list
+
+#include "bench_common.hpp"
+#include "perf_counters.hpp"
+#include "list.hpp"
+#include "static_list.hpp"
+
+namespace {
+
+using namespace Farebl::bench;
+
+constexpr size_t static_capacity = 4096;
+
+using static_list_u64 = Farebl::static_list<uint64_t, static_capacity>;
+
+void small_sizes(benchmark::internal::Benchmark* b){
+    b->RangeMultiplier(8)->Range(64, static_capacity);
+}
+
+template <typename Container>
+void BM_fill_drain(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    perf_counters perf;
+    perf.start();
+    for (auto _ : state){
+        Container c;
+        for (size_t i = 0; i < size; ++i) {c.push_back(i);}
+        while (!c.empty()) {c.pop_front();}
+        benchmark::ClobberMemory();
+    }
+    perf.stop();
+    state.SetItemsProcessed(state.iterations() * size);
+    perf.report(state, static_cast<double>(state.iterations() * size));
+}
+
+// the free-list of (size) objects: the oldest is taken and returned to the back
+template <typename Container>
+void BM_free_list_churn(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    Container c;
+    for (size_t i = 0; i < size; ++i) {c.push_back(i);}
+    perf_counters perf;
+    perf.start();
+    for (auto _ : state){
+        for (size_t i = 0; i < size; ++i){
+            uint64_t value = c.front();
+            c.pop_front();
+            c.push_back(value + 1);
+        }
+        benchmark::DoNotOptimize(c.back());
+    }
+    perf.stop();
+    state.SetItemsProcessed(state.iterations() * size);
+    perf.report(state, static_cast<double>(state.iterations() * size));
+}
+
+// (size) timers: the expired one is removed and rescheduled into its sorted position
+template <typename Container>
+void BM_timer_queue(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    Container c;
+    for (size_t i = 0; i < size; ++i) {c.push_back(i * 16);}
+    uint64_t now = 0;
+    perf_counters perf;
+    perf.start();
+    for (auto _ : state){
+        now = c.front();
+        c.pop_front();
+        uint64_t deadline = now + 1 + scramble(now) % (size * 16);
+        auto it = c.begin();
+        while (it != c.end() && *it <= deadline) {++it;}
+        c.insert(it, deadline);
+    }
+    perf.stop();
+    benchmark::DoNotOptimize(now);
+    state.SetItemsProcessed(state.iterations());
+    perf.report(state, static_cast<double>(state.iterations()));
+}
+
+template <typename Container>
+void BM_small_iterate(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    Container c;
+    for (size_t i = 0; i < size; ++i) {c.push_back(scramble(i));}
+    perf_counters perf;
+    perf.start();
+    for (auto _ : state){
+        uint64_t sum = 0;
+        for (uint64_t value: c) {sum += value;}
+        benchmark::DoNotOptimize(sum);
+    }
+    perf.stop();
+    state.SetItemsProcessed(state.iterations() * size);
+    perf.report(state, static_cast<double>(state.iterations() * size));
+}
+
+} // end namespace
+
+
+#define FAREBL_BENCHMARK_SMALL_LISTS(Func)                                           \
+    BENCHMARK_TEMPLATE(Func, static_list_u64)->Apply(small_sizes);                   \
+    BENCHMARK_TEMPLATE(Func, Farebl::list<uint64_t>)->Apply(small_sizes);            \
+    BENCHMARK_TEMPLATE(Func, std::list<uint64_t>)->Apply(small_sizes);
+
+FAREBL_BENCHMARK_SMALL_LISTS(BM_fill_drain)
+FAREBL_BENCHMARK_SMALL_LISTS(BM_free_list_churn)
+FAREBL_BENCHMARK_SMALL_LISTS(BM_timer_queue)
+FAREBL_BENCHMARK_SMALL_LISTS(BM_small_iterate)
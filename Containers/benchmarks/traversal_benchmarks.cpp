@@ -0,0 +1,158 @@
+/*
+    Cost of the traversal itself, with the hardware counters of perf_counters.hpp:
+    - the deque: iterator operator++ (the check of the bucket end on every step) against
+      the segmented loop (get_segment: the plain pointer loop inside every bucket),
+      operator[] and std::deque iterators;
+    - the list: the nodes in the allocation order against the nodes, relinked by sort()
+      into the random order (every step is the dependent load from the unpredictable address)
+      and the same list after defragment();
+    - the small elements (uint32_t): the 24-byte node of Farebl::list against the index_list nodes
+      with the 32-bit links (12 bytes doubly linked, 8 bytes xor linked);
+    - the positional access: std::next over Farebl::list against indexed_list::nth.
+*/
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <deque>        // for deque
+#include <iterator>     // for next
+#include <list>         // for list
+#include <memory>       // for allocator
+
+#include "bench_common.hpp"
+#include "perf_counters.hpp"
+#include "deque.hpp"
+#include "index_list.hpp"
+#include "indexed_list.hpp"
+#include "list.hpp"
+
+namespace {
+
+using namespace Farebl::bench;
+
+void traversal_sizes(benchmark::internal::Benchmark* b){
+    b->RangeMultiplier(16)->Range(1 << 12, 1 << 24);
+}
+
+template <typename Container>
+Container make_keys(size_t size){
+    Container result;
+    for (size_t i = 0; i < size; ++i) {result.push_back(scramble(i));}
+    return result;
+}
+
+// runs (func) in the measured loop and reports the counters per element
+template <typename Func>
+void measure(benchmark::State& state, size_t size, Func func){
+    perf_counters perf;
+    perf.start();
+    for (auto _ : state){
+        benchmark::DoNotOptimize(func());
+    }
+    perf.stop();
+    state.SetItemsProcessed(state.iterations() * size);
+    perf.report(state, static_cast<double>(state.iterations() * size));
+}
+
+
+template <typename Container>
+void BM_iterator_loop(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    Container c = make_keys<Container>(size);
+    measure(state, size, [&c](){
+        uint64_t sum = 0;
+        for (auto it = c.begin(), end_pos = c.end(); it != end_pos; ++it) {sum += *it;}
+        return sum;
+    });
+}
+
+void BM_deque_segment_loop(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    auto d = make_keys<Farebl::deque<uint64_t>>(size);
+    measure(state, size, [&d](){
+        uint64_t sum = 0;
+        for (size_t i = 0; i < d.segment_count(); ++i){
+            auto segment = d.get_segment(i);
+            for (const uint64_t* p = segment.first; p != segment.last; ++p) {sum += *p;}
+        }
+        return sum;
+    });
+}
+
+void BM_deque_index_loop(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    auto d = make_keys<Farebl::deque<uint64_t>>(size);
+    measure(state, size, [&d, size](){
+        uint64_t sum = 0;
+        for (size_t i = 0; i < size; ++i) {sum += d[i];}
+        return sum;
+    });
+}
+
+// sort() relinks the nodes: the traversal order doesn't follow the allocation order anymore
+template <typename List>
+void BM_shuffled_list_loop(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    List l = make_keys<List>(size);
+    l.sort();
+    measure(state, size, [&l](){
+        uint64_t sum = 0;
+        for (auto it = l.begin(), end_pos = l.end(); it != end_pos; ++it) {sum += *it;}
+        return sum;
+    });
+}
+
+// the shuffled list after defragment(): the nodes are contiguous in the traversal order again
+void BM_defragmented_list_loop(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    auto l = make_keys<Farebl::list<uint64_t>>(size);
+    l.sort();
+    l.defragment();
+    measure(state, size, [&l](){
+        uint64_t sum = 0;
+        for (auto it = l.begin(), end_pos = l.end(); it != end_pos; ++it) {sum += *it;}
+        return sum;
+    });
+}
+
+void positional_sizes(benchmark::internal::Benchmark* b){
+    b->RangeMultiplier(8)->Range(1 << 10, 1 << 16);
+}
+
+// the element at the scattered position (k): O(n) steps of the iterator
+void BM_list_next_access(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    auto l = make_keys<Farebl::list<uint64_t>>(size);
+    size_t i = 0;
+    measure(state, 1, [&l, &i, size](){
+        return *std::next(l.begin(), static_cast<std::ptrdiff_t>(scramble(i++) % size));
+    });
+}
+
+// the same with the order-statistic index: O(log n)
+void BM_indexed_list_nth(benchmark::State& state){
+    size_t size = static_cast<size_t>(state.range(0));
+    auto l = make_keys<Farebl::indexed_list<uint64_t>>(size);
+    size_t i = 0;
+    measure(state, 1, [&l, &i, size](){
+        return *l.nth(scramble(i++) % size);
+    });
+}
+
+template <typename T>
+using xor_index_list = Farebl::index_list<T, std::allocator<T>, Farebl::index_list_links::xor_linked>;
+
+} // end namespace
+
+BENCHMARK_TEMPLATE(BM_iterator_loop, Farebl::deque<uint64_t>)->Apply(traversal_sizes);
+BENCHMARK(BM_deque_segment_loop)->Apply(traversal_sizes);
+BENCHMARK(BM_deque_index_loop)->Apply(traversal_sizes);
+BENCHMARK_TEMPLATE(BM_iterator_loop, std::deque<uint64_t>)->Apply(traversal_sizes);
+BENCHMARK_TEMPLATE(BM_iterator_loop, Farebl::list<uint64_t>)->Apply(traversal_sizes);
+BENCHMARK_TEMPLATE(BM_shuffled_list_loop, Farebl::list<uint64_t>)->Apply(traversal_sizes);
+BENCHMARK(BM_defragmented_list_loop)->Apply(traversal_sizes);
+BENCHMARK_TEMPLATE(BM_iterator_loop, std::list<uint64_t>)->Apply(traversal_sizes);
+BENCHMARK_TEMPLATE(BM_shuffled_list_loop, std::list<uint64_t>)->Apply(traversal_sizes);
+BENCHMARK_TEMPLATE(BM_iterator_loop, Farebl::list<uint32_t>)->Apply(traversal_sizes);
+BENCHMARK_TEMPLATE(BM_iterator_loop, Farebl::index_list<uint32_t>)->Apply(traversal_sizes);
+BENCHMARK_TEMPLATE(BM_iterator_loop, xor_index_list<uint32_t>)->Apply(traversal_sizes);
+BENCHMARK(BM_list_next_access)->Apply(positional_sizes);
+BENCHMARK(BM_indexed_list_nth)->Apply(positional_sizes);
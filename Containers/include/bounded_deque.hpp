@@ -0,0 +1,199 @@
+#ifndef FAREBL_BOUNDED_DEQUE_H
+#define FAREBL_BOUNDED_DEQUE_H
+
+#include <cstddef>      // for size_t
+#include <memory>       // for allocator, allocator_traits
+#include <stdexcept>    // for out_of_range
+#include <type_traits>  // for is_trivially_destructible
+#include <utility>      // for move, forward
+
+#include "deque.hpp"    // for deque_default_bucket_size
+
+namespace Farebl {
+
+/*
+    Fixed-capacity deque (ring buffer of buckets): all the buckets are allocated by the constructor,
+    the head and the tail wrap around them, and after the construction the allocator isn't used.
+    The ring is rounded up to the whole buckets, but the deque holds at most the requested
+    capacity() elements. The position of the element is (m_head + pos) modulo the size of the ring,
+    without any bucket bookkeeping on the bucket transitions.
+
+    try_push_* return false (and don't construct anything), if the deque is full.
+*/
+template <typename T, typename Allocator = std::allocator<T>, size_t BucketSize = deque_default_bucket_size<T>>
+class bounded_deque{
+    static_assert(BucketSize > 0, "The bucket size must be 1 or greater");
+
+public:
+    using value_type      = T;
+    using allocator_type  = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+    using size_type       = size_t;
+    using reference       = T&;
+    using const_reference = const T&;
+
+    static constexpr size_type bucket_size = BucketSize;
+
+private:
+    using AllocatorPtrOnBucket = typename std::allocator_traits<allocator_type>::template rebind_alloc<T*>;
+
+    T** m_buckets_ptr;
+    size_type m_buckets_count;
+    size_type m_capacity;   // the requested bound of size()
+    size_type m_ring_size;  // cells in the buckets (m_capacity rounded up to the whole buckets)
+    size_type m_head;       // ring index of front()
+    size_type m_size;
+    allocator_type m_alloc;
+    AllocatorPtrOnBucket m_alloc_ptr_on_bucket;
+
+    static constexpr bool bucket_size_is_power_of_two_ = (BucketSize & (BucketSize - 1)) == 0;
+
+    static constexpr size_type log2_of_bucket_size_(){
+        size_type result = 0;
+        while ((size_type(1) << result) < BucketSize) {++result;}
+        return result;
+    }
+
+    T* cell_ptr_(size_type ring_index) const {
+        if constexpr (bucket_size_is_power_of_two_){
+            return m_buckets_ptr[ring_index >> log2_of_bucket_size_()] + (ring_index & (BucketSize - 1));
+        }
+        else{
+            return m_buckets_ptr[ring_index / BucketSize] + ring_index % BucketSize;
+        }
+    }
+
+    // (index < 2 * m_ring_size), so one comparison replaces the modulo
+    size_type wrap_(size_type index) const {
+        return (index >= m_ring_size) ? (index - m_ring_size) : index;
+    }
+
+    T* element_ptr_(size_type pos) const {
+        return cell_ptr_(wrap_(m_head + pos));
+    }
+
+    void free_buckets_(size_type count){
+        for (size_type i = 0; i < count; ++i){
+            std::allocator_traits<allocator_type>::deallocate(m_alloc, m_buckets_ptr[i], BucketSize);
+        }
+        std::allocator_traits<AllocatorPtrOnBucket>::deallocate(m_alloc_ptr_on_bucket, m_buckets_ptr, m_buckets_count);
+    }
+
+public:
+    explicit bounded_deque(size_type capacity, const Allocator& alloc = Allocator()):
+        m_buckets_ptr(nullptr),
+        m_buckets_count((capacity == 0) ? 1 : (capacity + BucketSize - 1) / BucketSize),
+        m_capacity(capacity),
+        m_ring_size(m_buckets_count * BucketSize),
+        m_head(0),
+        m_size(0),
+        m_alloc(alloc),
+        m_alloc_ptr_on_bucket(m_alloc)
+    {
+        m_buckets_ptr = std::allocator_traits<AllocatorPtrOnBucket>::allocate(m_alloc_ptr_on_bucket, m_buckets_count);
+        size_type allocated_count = 0;
+        try{
+            for (; allocated_count < m_buckets_count; ++allocated_count){
+                m_buckets_ptr[allocated_count] = std::allocator_traits<allocator_type>::allocate(m_alloc, BucketSize);
+            }
+        }
+        catch(...){
+            free_buckets_(allocated_count);
+            throw;
+        }
+    }
+
+    bounded_deque(const bounded_deque&) = delete;
+    bounded_deque& operator=(const bounded_deque&) = delete;
+
+    ~bounded_deque(){
+        clear();
+        free_buckets_(m_buckets_count);
+    }
+
+
+    bool empty() const {return m_size == 0;}
+
+    bool full() const {return m_size == m_capacity;}
+
+    size_type size() const {return m_size;}
+
+    size_type capacity() const {return m_capacity;}
+
+
+    reference operator[](size_type pos) {return *element_ptr_(pos);}
+    const_reference operator[](size_type pos) const {return *element_ptr_(pos);}
+
+    reference at(size_type pos){
+        if (pos >= m_size) {throw std::out_of_range("Farebl::bounded_deque::at: pos >= size()");}
+        return *element_ptr_(pos);
+    }
+    const_reference at(size_type pos) const {
+        if (pos >= m_size) {throw std::out_of_range("Farebl::bounded_deque::at: pos >= size()");}
+        return *element_ptr_(pos);
+    }
+
+    reference front() {return *cell_ptr_(m_head);}
+    const_reference front() const {return *cell_ptr_(m_head);}
+
+    reference back() {return *element_ptr_(m_size - 1);}
+    const_reference back() const {return *element_ptr_(m_size - 1);}
+
+
+    template <class... Args>
+    bool try_emplace_back(Args&&... args){
+        if (m_size == m_capacity) {return false;}
+        std::allocator_traits<allocator_type>::construct(m_alloc, element_ptr_(m_size), std::forward<Args>(args)...);
+        ++m_size;
+        return true;
+    }
+
+    bool try_push_back(const T& value) {return try_emplace_back(value);}
+    bool try_push_back(T&& value) {return try_emplace_back(std::move(value));}
+
+    template <class... Args>
+    bool try_emplace_front(Args&&... args){
+        if (m_size == m_capacity) {return false;}
+        size_type new_head = (m_head == 0) ? (m_ring_size - 1) : (m_head - 1);
+        std::allocator_traits<allocator_type>::construct(m_alloc, cell_ptr_(new_head), std::forward<Args>(args)...);
+        m_head = new_head;
+        ++m_size;
+        return true;
+    }
+
+    bool try_push_front(const T& value) {return try_emplace_front(value);}
+    bool try_push_front(T&& value) {return try_emplace_front(std::move(value));}
+
+    void pop_front(){
+        if (m_size == 0) {return;}
+        std::allocator_traits<allocator_type>::destroy(m_alloc, cell_ptr_(m_head));
+        m_head = wrap_(m_head + 1);
+        --m_size;
+    }
+
+    void pop_back(){
+        if (m_size == 0) {return;}
+        std::allocator_traits<allocator_type>::destroy(m_alloc, element_ptr_(m_size - 1));
+        --m_size;
+    }
+
+    // moves front() to (out) and pops it; false, if the deque is empty
+    bool try_pop_front(T& out){
+        if (m_size == 0) {return false;}
+        out = std::move(*cell_ptr_(m_head));
+        pop_front();
+        return true;
+    }
+
+    void clear(){
+        if constexpr (!std::is_trivially_destructible<T>::value){
+            for (size_type i = 0; i < m_size; ++i){
+                std::allocator_traits<allocator_type>::destroy(m_alloc, element_ptr_(i));
+            }
+        }
+        m_head = 0;
+        m_size = 0;
+    }
+};
+
+} // end namespace Farebl
+#endif // FAREBL_BOUNDED_DEQUE_H
@@ -0,0 +1,133 @@
+#ifndef FAREBL_CONTAINER_STATS_H
+#define FAREBL_CONTAINER_STATS_H
+
+#include <atomic>       // for atomic, memory_order_relaxed
+#include <cstddef>      // for size_t
+
+namespace Farebl {
+
+/*
+    Instrumentation of the hot paths of Farebl::list and Farebl::deque.
+    The counters are compiled in only with FAREBL_CONTAINER_STATS defined (before the first
+    include of the containers, and equally in all the translation units of the program);
+    without it the counting base of the containers is empty (and is optimized out by EBO),
+    the hooks are empty inline functions and stats() returns zeros.
+*/
+#ifdef FAREBL_CONTAINER_STATS
+inline constexpr bool container_stats_enabled = true;
+#else
+inline constexpr bool container_stats_enabled = false;
+#endif
+
+struct container_stats{
+    size_t allocator_calls = 0;    // successful allocate() calls (the nodes, the buckets, the bucket arrays)
+    size_t bytes_allocated = 0;
+    size_t map_reallocations = 0;  // reallocations of the existing bucket array (deque only)
+    size_t elements_moved = 0;     // elements, moved by erase and shrink_to_fit (deque only)
+    size_t peak_size = 0;
+};
+
+/*
+    Sum of the counters of all the containers (peak_size - the maximum over the containers),
+    updated by relaxed atomics, so it can be scraped from any thread by snapshot().
+*/
+class container_stats_aggregator{
+    std::atomic<size_t> m_allocator_calls{0};
+    std::atomic<size_t> m_bytes_allocated{0};
+    std::atomic<size_t> m_map_reallocations{0};
+    std::atomic<size_t> m_elements_moved{0};
+    std::atomic<size_t> m_peak_size{0};
+
+public:
+    container_stats snapshot() const {
+        container_stats result;
+        result.allocator_calls = m_allocator_calls.load(std::memory_order_relaxed);
+        result.bytes_allocated = m_bytes_allocated.load(std::memory_order_relaxed);
+        result.map_reallocations = m_map_reallocations.load(std::memory_order_relaxed);
+        result.elements_moved = m_elements_moved.load(std::memory_order_relaxed);
+        result.peak_size = m_peak_size.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    void reset(){
+        m_allocator_calls.store(0, std::memory_order_relaxed);
+        m_bytes_allocated.store(0, std::memory_order_relaxed);
+        m_map_reallocations.store(0, std::memory_order_relaxed);
+        m_elements_moved.store(0, std::memory_order_relaxed);
+        m_peak_size.store(0, std::memory_order_relaxed);
+    }
+
+    void add_allocation(size_t bytes){
+        m_allocator_calls.fetch_add(1, std::memory_order_relaxed);
+        m_bytes_allocated.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void add_map_reallocation() {m_map_reallocations.fetch_add(1, std::memory_order_relaxed);}
+
+    void add_moved_elements(size_t count) {m_elements_moved.fetch_add(count, std::memory_order_relaxed);}
+
+    void update_peak_size(size_t size){
+        size_t peak = m_peak_size.load(std::memory_order_relaxed);
+        while (peak < size && !m_peak_size.compare_exchange_weak(peak, size, std::memory_order_relaxed)){}
+    }
+};
+
+inline container_stats_aggregator global_container_stats;
+
+namespace stats_detail{
+
+    // private base of the containers: the hooks of the hot paths
+    template <bool Enabled = container_stats_enabled>
+    class counters{
+    protected:
+        void count_allocation_(size_t) {}
+        void count_map_reallocation_() {}
+        void count_moved_elements_(size_t) {}
+        void count_size_(size_t) {}
+        container_stats counters_snapshot_(size_t) const {return {};}
+    };
+
+    template <>
+    class counters<true>{
+        container_stats m_counters;
+
+    protected:
+        // the counters belong to the object: they are neither copied nor swapped with the elements
+        counters() = default;
+        counters(const counters&) {}
+        counters& operator=(const counters&) {return *this;}
+
+        void count_allocation_(size_t bytes){
+            ++m_counters.allocator_calls;
+            m_counters.bytes_allocated += bytes;
+            global_container_stats.add_allocation(bytes);
+        }
+
+        void count_map_reallocation_(){
+            ++m_counters.map_reallocations;
+            global_container_stats.add_map_reallocation();
+        }
+
+        void count_moved_elements_(size_t count){
+            m_counters.elements_moved += count;
+            global_container_stats.add_moved_elements(count);
+        }
+
+        // the global peak is touched only when the peak of the container grows
+        void count_size_(size_t size){
+            if (size <= m_counters.peak_size) {return;}
+            m_counters.peak_size = size;
+            global_container_stats.update_peak_size(size);
+        }
+
+        // (size) - the current size, which may exceed the counted peak (after the swap or the move)
+        container_stats counters_snapshot_(size_t size) const {
+            container_stats result = m_counters;
+            if (result.peak_size < size) {result.peak_size = size;}
+            return result;
+        }
+    };
+}
+
+} // end namespace Farebl
+#endif // FAREBL_CONTAINER_STATS_H
@@ -1,13 +1,34 @@
 #ifndef FAREBL_DEQUE_H
 #define FAREBL_DEQUE_H
 
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
 #include <memory>
 #include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "container_stats.hpp"
 
 namespace Farebl{
 
-template <typename T, typename Alloc = std::allocator<T>, size_t BucketSize = ((sizeof(T) < 256) ? 4096/sizeof(T) : 16)>
-class deque{
+namespace deque_detail{
+    constexpr size_t floor_power_of_two(size_t value){
+        size_t result = 1;
+        while (result <= value / 2) {result *= 2;}
+        return result;
+    }
+}
+
+// rounded down to the power of two, so the iterators arithmetic compiles to the shifts and the masks
+template <typename T>
+inline constexpr size_t deque_default_bucket_size = deque_detail::floor_power_of_two((sizeof(T) < 256) ? 4096/sizeof(T) : 16);
+
+template <typename T, typename Alloc = std::allocator<T>, size_t BucketSize = deque_default_bucket_size<T>>
+class deque: private stats_detail::counters<>{
 
     static_assert(BucketSize > 0, "The bucket size must be 1 or greater");
     static_assert(BucketSize <= 104'857'600/sizeof(T), "The bucket size cannot exceed 100 MB");
@@ -25,6 +46,9 @@ private:
 
     private:
         friend class deque;
+        template <bool OtherIsConst>
+        friend class base_iterator;
+
         T** m_buckets_ptr;
         size_t m_buckets_capacity;
         difference_type m_pseudo_cell_index; 
@@ -48,6 +72,33 @@ private:
             m_pseudo_cell_index(-1),
             m_bucket_ptr(bucket_ptr), 
             m_ptr(ptr){}
+
+        /*
+            Position of the iterator, counted in cells from the begin of the bucket array
+            (for the power-of-two BucketSize path of the arithmetic).
+        */
+        difference_type linear_index_() const {
+            difference_type index_in_bucket = (m_pseudo_cell_index == -1) ? (const_cast<T*>(m_ptr) - *m_bucket_ptr) : m_pseudo_cell_index;
+            return (m_bucket_ptr - m_buckets_ptr) * static_cast<difference_type>(BucketSize) + index_in_bucket;
+        }
+
+        void set_linear_index_(difference_type index){
+            // the arithmetic shift and the mask round towards minus infinity, so the negative indexes are correct too
+            m_bucket_ptr = m_buckets_ptr + (index >> static_cast<difference_type>(log2_of_bucket_size_()));
+            difference_type index_in_bucket = index & static_cast<difference_type>(BucketSize - 1);
+            if (
+                (m_bucket_ptr >= m_buckets_ptr)
+                    &&
+                (m_bucket_ptr < (m_buckets_ptr + m_buckets_capacity))
+            ){
+                m_ptr = *m_bucket_ptr + index_in_bucket;
+                m_pseudo_cell_index = -1;
+            }
+            else{
+                m_ptr = nullptr;
+                m_pseudo_cell_index = index_in_bucket;
+            }
+        }
     public:
 
         reference operator*() const {return *m_ptr; }
@@ -56,7 +107,7 @@ private:
 
         base_iterator& operator++(){
             if (m_buckets_ptr != nullptr){
-                if (m_ptr != nullptr){
+                if (m_pseudo_cell_index == -1){
                     if(((const_cast<T*>(m_ptr) - *m_bucket_ptr) + 1) == static_cast<difference_type>(BucketSize)){
                         ++m_bucket_ptr;
                         if (
@@ -107,7 +158,7 @@ private:
 
         base_iterator& operator--(){
             if (m_buckets_ptr != nullptr){
-                if (m_ptr != nullptr){
+                if (m_pseudo_cell_index == -1){
                     if (m_ptr == *m_bucket_ptr){
                         --m_bucket_ptr;
                         if (
@@ -157,9 +208,13 @@ private:
         
         
         base_iterator& operator+=(difference_type value) & {
-            if (value < 0) return *this -= value;
+            if constexpr (bucket_size_is_power_of_two_){
+                if (m_buckets_ptr != nullptr) {set_linear_index_(linear_index_() + value);}
+                return *this;
+            }
+            if (value < 0) return *this -= -value;
             if (m_buckets_ptr != nullptr){
-                if (m_ptr != nullptr){
+                if (m_pseudo_cell_index == -1){
                     difference_type result_index = (const_cast<T*>(m_ptr) - *m_bucket_ptr) + (value % BucketSize);
                     
                     if (value >= static_cast<difference_type>(BucketSize)){
@@ -255,12 +310,16 @@ private:
         }
 
         base_iterator& operator-=(difference_type value) & {
-            if (value < 0) {return *this += value;}
+            if constexpr (bucket_size_is_power_of_two_){
+                if (m_buckets_ptr != nullptr) {set_linear_index_(linear_index_() - value);}
+                return *this;
+            }
+            if (value < 0) {return *this += -value;}
             if (m_buckets_ptr != nullptr){
-                if (m_ptr != nullptr){
+                if (m_pseudo_cell_index == -1){
                     difference_type result_index_in_bucket = (const_cast<T*>(m_ptr) - *m_bucket_ptr) - (value % BucketSize);
                     
-                    if (value > static_cast<difference_type>(BucketSize)){
+                    if (value >= static_cast<difference_type>(BucketSize)){
                         m_bucket_ptr -= value / BucketSize;
                     }
                     if (
@@ -299,7 +358,7 @@ private:
                 }
                 else {
                     difference_type result_pseudo_index_in_bucket = m_pseudo_cell_index - (value % BucketSize);
-                    if (value > static_cast<difference_type>(BucketSize)){
+                    if (value >= static_cast<difference_type>(BucketSize)){
                         m_bucket_ptr -= value / BucketSize;
                     }
                     if (
@@ -343,21 +402,12 @@ private:
 
         base_iterator operator+(difference_type value) const {
             base_iterator temp = *(this);
-            if (value<0)
-                temp-=value;
-            else
-                temp+=value;
-
+            temp+=value;
             return temp;
         }
-        template <bool OtherIsConst>
-        friend base_iterator operator+(difference_type value, const base_iterator<OtherIsConst>& it) {
+        friend base_iterator operator+(difference_type value, const base_iterator& it) {
             base_iterator temp = it;
-            if (value<0)
-                temp-=value;
-            else
-                temp+=value;
-
+            temp+=value;
             return temp; 
         }
 
@@ -371,27 +421,15 @@ private:
 
         template<bool OtherIsConst>
         difference_type operator-(const base_iterator<OtherIsConst>& other){
-            if (m_bucket_ptr == nullptr || other.m_bucket_ptr == nullptr){
+            if (m_buckets_ptr == nullptr || other.m_buckets_ptr == nullptr){
                 return m_bucket_ptr - other.m_bucket_ptr;
             }
-
-            if(m_bucket_ptr == other.m_bucket_ptr){
-                return const_cast<T*>(m_ptr) - const_cast<T*>(other.m_ptr); 
-            }
-            else if(m_bucket_ptr > other.m_bucket_ptr){
-                return (
-                    (((m_bucket_ptr - other.m_bucket_ptr) -1) * BucketSize) 
-                    + 
-                    (const_cast<T*>(m_ptr) - *m_bucket_ptr) + ((*other.m_bucket_ptr + BucketSize) - const_cast<T*>(other.m_ptr))
-                );
-            }
-            else{
-                return( 
-                    (((other.m_bucket_ptr - m_bucket_ptr) -1) * BucketSize)
-                    + 
-                    (const_cast<T*>(other.m_ptr) - *other.m_bucket_ptr) + ((*m_bucket_ptr + BucketSize) - const_cast<T*>(m_ptr))
-                ); 
-            }
+            /*
+                linear_index_() takes the position inside the bucket from m_pseudo_cell_index
+                for the iterators outside of the bucket array (e.g. end() after the last slot),
+                so no map slot outside of the array is read
+            */
+            return linear_index_() - other.linear_index_();
         }
 
 
@@ -405,11 +443,17 @@ private:
                     && 
                 m_bucket_ptr == other.m_bucket_ptr 
                     && 
-                m_ptr == other.m_ptr); 
+                m_ptr == other.m_ptr
+                    &&
+                m_pseudo_cell_index == other.m_pseudo_cell_index); 
         }
+        /*
+            m_ptr alone isn't enough: the iterator on the free slot of the bucket array (e.g. end())
+            takes m_ptr from the stale slot, which can hold the address of the bucket in the other slot
+        */
         template<bool OtherIsConst>
         bool operator!=(const base_iterator<OtherIsConst>& other){
-            return !(m_ptr == other.m_ptr);
+            return !(*this == other);
         }
 
         template<bool OtherIsConst>
@@ -426,9 +470,28 @@ private:
         template<bool OtherIsConst>
         bool operator<=(const base_iterator<OtherIsConst>& other){    return !(*this > other); }
 
-        operator base_iterator<true>(){return {m_buckets_ptr, m_buckets_capacity, m_bucket_ptr, const_cast<const T*>(m_ptr)};}
+        // the pseudo cell is kept too: end() after the last slot of the bucket array has no map slot to read
+        operator base_iterator<true>(){
+            base_iterator<true> result(m_buckets_ptr, m_buckets_capacity, m_bucket_ptr, const_cast<const T*>(m_ptr));
+            result.m_pseudo_cell_index = m_pseudo_cell_index;
+            return result;
+        }
     };
-public: 
+
+    template <bool IsConst = false>
+    struct base_segment{
+    /*
+        Contiguous run of elements [first, last), which lies entirely inside one bucket.
+    */
+        using pointer = typename std::conditional<IsConst, const T*, T*>::type;
+        pointer first;
+        pointer last;
+
+        size_t size() const {return last - first;}
+        pointer begin() const {return first;}
+        pointer end() const {return last;}
+    };
+public:
     using value_type             = T;
     using allocator_type         = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
     using pointer                = typename std::allocator_traits<allocator_type>::pointer;
@@ -445,6 +508,11 @@ public:
     using reverse_iterator       = std::reverse_iterator<iterator>;
     using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
+    using segment                = base_segment<false>;
+    using const_segment          = base_segment<true>;
+
+    static constexpr size_type bucket_size = BucketSize;
+
 private:
     T** m_buckets_ptr; 
     T** m_first_allocated_bucket_ptr;
@@ -459,18 +527,65 @@ private:
     AllocatorPtrOnBucket m_alloc_ptr_on_bucket;
 
 
-    void center_the_iterators_m_first_and_m_last_(){
+    static constexpr bool bucket_size_is_power_of_two_ = (BucketSize & (BucketSize - 1)) == 0;
+
+    static constexpr size_type log2_of_bucket_size_(){
+        size_type result = 0;
+        while ((size_type(1) << result) < BucketSize) {++result;}
+        return result;
+    }
+
+    // for power-of-two BucketSize the division and the modulo are replaced by the shift and the mask
+    static constexpr size_type bucket_index_(size_type index){
+        if constexpr (bucket_size_is_power_of_two_){
+            return index >> log2_of_bucket_size_();
+        }
+        else{
+            return index / BucketSize;
+        }
+    }
+
+    static constexpr size_type index_in_bucket_(size_type index){
+        if constexpr (bucket_size_is_power_of_two_){
+            return index & (BucketSize - 1);
+        }
+        else{
+            return index % BucketSize;
+        }
+    }
+
     /*
-        Moving iterators (m_first and m_last) to the begin of the middle allocated bucket of the deque,
-        to optimize subsequent operations of inserting elements in the begin or end.
+        Direct path of the indexed access (without the iterator arithmetic):
+        the index is counted from the begin of the first used bucket.
     */
-        size_t index_of_middle_allocated_bucket = 
-            (m_first_allocated_bucket_ptr - m_buckets_ptr)
-                +
-            ((m_last_allocated_bucket_ptr - m_first_allocated_bucket_ptr) / 2);
+    T* element_ptr_(size_type pos) const {
+        size_type index = static_cast<size_type>(m_first.m_ptr - *m_first.m_bucket_ptr) + pos;
+        return m_first.m_bucket_ptr[bucket_index_(index)] + index_in_bucket_(index);
+    }
 
-        m_last.m_bucket_ptr = m_buckets_ptr + index_of_middle_allocated_bucket;
-        m_last.m_ptr = *m_last.m_bucket_ptr;
+    // all the allocations of the deque pass here (for the counters of container_stats.hpp)
+    T* allocate_bucket_(){
+        T* bucket = std::allocator_traits<Allocator>::allocate(m_alloc, BucketSize);
+        count_allocation_(BucketSize * sizeof(T));
+        return bucket;
+    }
+
+    T** allocate_bucket_array_(size_type capacity){
+        T** buckets_ptr = std::allocator_traits<AllocatorPtrOnBucket>::allocate(m_alloc_ptr_on_bucket, capacity);
+        count_allocation_(capacity * sizeof(T*));
+        return buckets_ptr;
+    }
+
+    void center_the_iterators_m_first_and_m_last_(){
+    /*
+        Moving iterators (m_first and m_last) to the middle cell of the allocated buckets,
+        so the refill of the emptied deque (from the begin or from the end) uses
+        the already allocated buckets and doesn't touch the allocator.
+    */
+        size_type middle_cell = ((m_last_allocated_bucket_ptr - m_first_allocated_bucket_ptr + 1) * BucketSize) / 2;
+        m_last.m_bucket_ptr = m_first_allocated_bucket_ptr + middle_cell / BucketSize;
+        m_last.m_ptr = *m_last.m_bucket_ptr + middle_cell % BucketSize;
+        m_last.m_pseudo_cell_index = -1; // the last pop could step m_last out of the bucket array
         m_first = m_last; 
     }
 
@@ -483,28 +598,35 @@ private:
         size_t new_m_buckets_capacity;
     };
 
+    /*
+        The first bucket array has the free slots at both ends (at least initial_buckets_capacity_ slots
+        in total), so the next buckets, added to the begin or to the end, don't reallocate it.
+    */
+    static constexpr size_type initial_buckets_capacity_ = 8;
+
     NewPtrsAndCapAfterRealloc realloc_with_add_allocated_buckets_to_end(size_t count_of_buckets, bool to_reserve_in_end){
         NewPtrsAndCapAfterRealloc result;
         if(!m_buckets_ptr){
-            result.new_m_buckets_capacity = count_of_buckets;
-            result.new_m_buckets_ptr = std::allocator_traits<AllocatorPtrOnBucket>::allocate(m_alloc_ptr_on_bucket, result.new_m_buckets_capacity);
+            result.new_m_buckets_capacity = std::max(initial_buckets_capacity_, 2 * count_of_buckets);
+            result.new_m_buckets_ptr = allocate_bucket_array_(result.new_m_buckets_capacity);
             
-            result.new_m_first_allocated_bucket_ptr = result.new_m_buckets_ptr;
+            result.new_m_first_allocated_bucket_ptr = result.new_m_buckets_ptr + (result.new_m_buckets_capacity - count_of_buckets) / 2;
             result.new_m_last_allocated_bucket_ptr = result.new_m_first_allocated_bucket_ptr;
             
             try{
                 for (size_t successful_allocated_buckets = 0; successful_allocated_buckets < count_of_buckets; ++successful_allocated_buckets, ++result.new_m_last_allocated_bucket_ptr){
-                    *result.new_m_last_allocated_bucket_ptr = std::allocator_traits<Allocator>::allocate(m_alloc, BucketSize);
+                    *result.new_m_last_allocated_bucket_ptr = allocate_bucket_();
                 }
                 --result.new_m_last_allocated_bucket_ptr;
             }
             catch(...){
                 --result.new_m_last_allocated_bucket_ptr;
-                T** end_pos = result.new_m_buckets_ptr - 1;
+                T** end_pos = result.new_m_first_allocated_bucket_ptr - 1;
                 while(result.new_m_last_allocated_bucket_ptr != end_pos){
                     std::allocator_traits<Allocator>::deallocate(m_alloc, *result.new_m_last_allocated_bucket_ptr, BucketSize);
                     --result.new_m_last_allocated_bucket_ptr;
                 }
+                std::allocator_traits<AllocatorPtrOnBucket>::deallocate(m_alloc_ptr_on_bucket, result.new_m_buckets_ptr, result.new_m_buckets_capacity);
                 throw;
             }
             result.new_m_first.m_buckets_ptr = result.new_m_buckets_ptr;
@@ -522,13 +644,14 @@ private:
                 result.new_m_buckets_capacity += (using_allocated_buckets / 2); 
             }
 
-            result.new_m_buckets_ptr = std::allocator_traits<AllocatorPtrOnBucket>::allocate(m_alloc_ptr_on_bucket, result.new_m_buckets_capacity);            
+            result.new_m_buckets_ptr = allocate_bucket_array_(result.new_m_buckets_capacity);            
+            count_map_reallocation_();
             
             result.new_m_last_allocated_bucket_ptr = result.new_m_buckets_ptr + old_count_of_allocated_buckets;
             size_t successful_allocated_buckets = 0;
             try{
                 for (; successful_allocated_buckets < count_of_buckets; ++successful_allocated_buckets, ++result.new_m_last_allocated_bucket_ptr){
-                    *result.new_m_last_allocated_bucket_ptr = std::allocator_traits<Allocator>::allocate(m_alloc, BucketSize);
+                    *result.new_m_last_allocated_bucket_ptr = allocate_bucket_();
                 }
                 --result.new_m_last_allocated_bucket_ptr;
             }
@@ -539,6 +662,7 @@ private:
                     --result.new_m_last_allocated_bucket_ptr;
                     --successful_allocated_buckets;
                 }
+                std::allocator_traits<AllocatorPtrOnBucket>::deallocate(m_alloc_ptr_on_bucket, result.new_m_buckets_ptr, result.new_m_buckets_capacity);
                 throw;
             }
 
@@ -562,9 +686,378 @@ private:
         return result;
     }
 
+    // count of elements, which can be added to the end without allocation of the buckets
+    size_type free_cells_in_end_() const {
+        if (m_buckets_ptr == nullptr) {return 0;}
+        size_type used_cells_in_last_bucket = (m_last.m_ptr - *m_last.m_bucket_ptr) + ((m_size == 0) ? 0 : 1);
+        return (BucketSize - used_cells_in_last_bucket) + (m_last_allocated_bucket_ptr - m_last.m_bucket_ptr) * BucketSize;
+    }
+
+    /*
+        After the call, (count_of_elements) elements can be added to the end without any allocation:
+        the missing buckets are allocated into the free cells of the bucket array,
+        or the bucket array is reallocated (once) with all the missing buckets.
+    */
+    void reserve_buckets_in_end_(size_type count_of_elements){
+        size_type free_cells = free_cells_in_end_();
+        if (count_of_elements <= free_cells) {return;}
+        size_type count_of_buckets = ((count_of_elements - free_cells) + BucketSize - 1) / BucketSize;
+
+        if (
+            m_buckets_ptr != nullptr
+                &&
+            static_cast<size_type>((m_buckets_ptr + m_buckets_capacity - 1) - m_last_allocated_bucket_ptr) >= count_of_buckets
+        ){
+            for (size_type i = 0; i < count_of_buckets; ++i){
+                *(m_last_allocated_bucket_ptr + 1) = allocate_bucket_();
+                ++m_last_allocated_bucket_ptr;
+            }
+            return;
+        }
+
+        auto result_of_realloc = realloc_with_add_allocated_buckets_to_end(count_of_buckets, true);
+        if (m_buckets_ptr != nullptr){
+            std::allocator_traits<AllocatorPtrOnBucket>::deallocate(m_alloc_ptr_on_bucket, m_buckets_ptr, m_buckets_capacity);
+        }
+        m_buckets_ptr = result_of_realloc.new_m_buckets_ptr;
+        m_buckets_capacity = result_of_realloc.new_m_buckets_capacity;
+
+        m_first_allocated_bucket_ptr = result_of_realloc.new_m_first_allocated_bucket_ptr;
+        m_last_allocated_bucket_ptr = result_of_realloc.new_m_last_allocated_bucket_ptr;
+
+        m_first = result_of_realloc.new_m_first;
+        m_last = result_of_realloc.new_m_last;
+    }
+
+    // count of elements, which can be added to the begin without allocation of the buckets
+    size_type free_cells_in_begin_() const {
+        if (m_buckets_ptr == nullptr) {return 0;}
+        size_type free_cells_in_first_bucket = (m_first.m_ptr - *m_first.m_bucket_ptr) + ((m_size == 0) ? 1 : 0);
+        return free_cells_in_first_bucket + (m_first.m_bucket_ptr - m_first_allocated_bucket_ptr) * BucketSize;
+    }
+
+    /*
+        Moves the pointers on the allocated buckets to the new bucket array with (free_slots_in_begin)
+        free cells before them and (free_slots_in_end) free cells after them
+        (the buckets themselves and the elements aren't moved).
+    */
+    void reallocate_bucket_array_(size_type free_slots_in_begin, size_type free_slots_in_end){
+        size_type count_of_allocated_buckets = m_last_allocated_bucket_ptr - m_first_allocated_bucket_ptr + 1;
+        size_type new_buckets_capacity = free_slots_in_begin + count_of_allocated_buckets + free_slots_in_end;
+        T** new_buckets_ptr = allocate_bucket_array_(new_buckets_capacity);
+        count_map_reallocation_();
+        T** new_first_allocated_bucket_ptr = new_buckets_ptr + free_slots_in_begin;
+        std::copy(m_first_allocated_bucket_ptr, m_last_allocated_bucket_ptr + 1, new_first_allocated_bucket_ptr);
+
+        m_first.m_bucket_ptr = new_first_allocated_bucket_ptr + (m_first.m_bucket_ptr - m_first_allocated_bucket_ptr);
+        m_last.m_bucket_ptr = new_first_allocated_bucket_ptr + (m_last.m_bucket_ptr - m_first_allocated_bucket_ptr);
+        m_first.m_buckets_ptr = m_last.m_buckets_ptr = new_buckets_ptr;
+        m_first.m_buckets_capacity = m_last.m_buckets_capacity = new_buckets_capacity;
+
+        m_first_allocated_bucket_ptr = new_first_allocated_bucket_ptr;
+        m_last_allocated_bucket_ptr = new_first_allocated_bucket_ptr + count_of_allocated_buckets - 1;
+
+        std::allocator_traits<AllocatorPtrOnBucket>::deallocate(m_alloc_ptr_on_bucket, m_buckets_ptr, m_buckets_capacity);
+        m_buckets_ptr = new_buckets_ptr;
+        m_buckets_capacity = new_buckets_capacity;
+    }
+
+    // the mirror of reserve_buckets_in_end_
+    void reserve_buckets_in_begin_(size_type count_of_elements){
+        if (count_of_elements == 0) {return;}
+        if (m_buckets_ptr == nullptr){
+            reserve_buckets_in_end_(count_of_elements);
+            // the first element, added to the begin, goes to the last cell, so all the reserved cells are before it
+            m_first.m_bucket_ptr = m_last_allocated_bucket_ptr;
+            m_first.m_ptr = *m_first.m_bucket_ptr + (BucketSize - 1);
+            m_last = m_first;
+            return;
+        }
+
+        size_type free_cells = free_cells_in_begin_();
+        if (count_of_elements <= free_cells) {return;}
+        size_type count_of_buckets = ((count_of_elements - free_cells) + BucketSize - 1) / BucketSize;
+
+        if (static_cast<size_type>(m_first_allocated_bucket_ptr - m_buckets_ptr) < count_of_buckets){
+            size_type using_allocated_buckets = m_last.m_bucket_ptr - m_first.m_bucket_ptr + 1;
+            reallocate_bucket_array_(
+                count_of_buckets + using_allocated_buckets / 2,
+                (m_buckets_ptr + m_buckets_capacity - 1) - m_last_allocated_bucket_ptr
+            );
+        }
+        for (size_type i = 0; i < count_of_buckets; ++i){
+            *(m_first_allocated_bucket_ptr - 1) = allocate_bucket_();
+            --m_first_allocated_bucket_ptr;
+        }
+    }
+
+    template <typename InputIt>
+    static constexpr bool is_memcpy_source_() {
+        return std::is_trivially_copyable<T>::value
+                &&
+            std::is_pointer<InputIt>::value
+                &&
+            std::is_same<typename std::remove_cv<typename std::remove_pointer<InputIt>::type>::type, T>::value;
+    }
+
+    template <typename OutputIt>
+    static constexpr bool is_memcpy_destination_() {
+        return std::is_trivially_copyable<T>::value && std::is_same<OutputIt, T*>::value;
+    }
+
+    // the state of the default constructed deque (without the bucket array); nothing is freed
+    void reset_to_null_state_(){
+        m_buckets_ptr = nullptr;
+        m_first_allocated_bucket_ptr = nullptr;
+        m_last_allocated_bucket_ptr = nullptr;
+        m_first = iterator(nullptr, 0, nullptr, nullptr);
+        m_last = m_first;
+        m_size = 0;
+        m_buckets_capacity = 0;
+    }
+
+    // O(1) handoff of the bucket array and the buckets of (other) (the allocators aren't touched)
+    void steal_buckets_(deque& other){
+        m_buckets_ptr = other.m_buckets_ptr;
+        m_first_allocated_bucket_ptr = other.m_first_allocated_bucket_ptr;
+        m_last_allocated_bucket_ptr = other.m_last_allocated_bucket_ptr;
+        m_first = other.m_first;
+        m_last = other.m_last;
+        m_size = other.m_size;
+        m_buckets_capacity = other.m_buckets_capacity;
+        other.reset_to_null_state_();
+    }
+
+    void destroy_all_and_free_(){
+        erase(cbegin(), cend());
+        shrink_to_fit();
+    }
+
+    /*
+        Appends the elements of (other) segment by segment: all the buckets are reserved
+        at once (one allocation per bucket), and every segment is constructed by push_back_n
+        (by memcpy for trivially copyable T). ToMove - the elements are moved out of (other).
+    */
+    template <bool ToMove, typename OtherDeque>
+    void append_segments_of_(OtherDeque& other){
+        reserve_buckets_in_end_(other.m_size);
+        for (size_type i = 0; i < other.segment_count(); ++i){
+            auto segment = other.get_segment(i);
+            if constexpr (ToMove){
+                push_back_n(std::make_move_iterator(segment.first), segment.size());
+            }
+            else{
+                push_back_n(segment.first, segment.size());
+            }
+        }
+    }
+
+    /*
+        Copy-assignment, which reuses the existing elements and buckets:
+        the common prefix is assigned by contiguous runs (std::copy between the segments
+        of both deques), the extra elements are destroyed or the missing ones are appended.
+    */
+    void assign_elements_from_(const deque& other){
+        size_type common_count = std::min(m_size, other.m_size);
+        size_type done_count = 0;
+        size_type segment_index = 0;
+        size_type other_segment_index = 0;
+        T* ptr = nullptr;
+        T* segment_end = nullptr;
+        const T* other_ptr = nullptr;
+        const T* other_segment_end = nullptr;
+        while (done_count < common_count){
+            if (ptr == segment_end){
+                segment current = get_segment(segment_index++);
+                ptr = current.first;
+                segment_end = current.last;
+            }
+            if (other_ptr == other_segment_end){
+                const_segment current = other.get_segment(other_segment_index++);
+                other_ptr = current.first;
+                other_segment_end = current.last;
+            }
+            size_type run = std::min({
+                static_cast<size_type>(segment_end - ptr),
+                static_cast<size_type>(other_segment_end - other_ptr),
+                common_count - done_count
+            });
+            std::copy(other_ptr, other_ptr + run, ptr);
+            ptr += run;
+            other_ptr += run;
+            done_count += run;
+        }
+
+        if (m_size > other.m_size){
+            while (m_size > other.m_size){
+                pop_back();
+            }
+            return;
+        }
+        reserve_buckets_in_end_(other.m_size - m_size);
+        while (done_count < other.m_size){
+            if (other_ptr == other_segment_end){
+                const_segment current = other.get_segment(other_segment_index++);
+                other_ptr = current.first;
+                other_segment_end = current.last;
+            }
+            size_type run = other_segment_end - other_ptr;
+            push_back_n(other_ptr, run);
+            other_ptr += run;
+            done_count += run;
+        }
+    }
+
+    // count of the cells from the element (pos) to the end of its bucket (with the element)
+    size_type cells_to_bucket_end_(size_type pos) const {
+        return BucketSize - index_in_bucket_(static_cast<size_type>(m_first.m_ptr - *m_first.m_bucket_ptr) + pos);
+    }
+
+    // count of the cells from the begin of the bucket of the element (pos) to the element (with it)
+    size_type cells_from_bucket_begin_(size_type pos) const {
+        return index_in_bucket_(static_cast<size_type>(m_first.m_ptr - *m_first.m_bucket_ptr) + pos) + 1;
+    }
+
+    // [src, src + count) --> [dst, dst + count), dst < src: by the runs inside the buckets (memmove for trivial T)
+    void move_elements_forward_(size_type dst, size_type src, size_type count){
+        while (count != 0){
+            size_type run = std::min({count, cells_to_bucket_end_(src), cells_to_bucket_end_(dst)});
+            T* src_ptr = element_ptr_(src);
+            std::move(src_ptr, src_ptr + run, element_ptr_(dst));
+            src += run;
+            dst += run;
+            count -= run;
+        }
+    }
+
+    // [src, src + count) --> [dst, dst + count), dst > src: from the end, by the runs inside the buckets
+    void move_elements_backward_(size_type dst, size_type src, size_type count){
+        size_type src_end = src + count;
+        size_type dst_end = dst + count;
+        while (count != 0){
+            size_type run = std::min({count, cells_from_bucket_begin_(src_end - 1), cells_from_bucket_begin_(dst_end - 1)});
+            T* src_last_ptr = element_ptr_(src_end - 1) + 1;
+            std::move_backward(src_last_ptr - run, src_last_ptr, element_ptr_(dst_end - 1) + 1);
+            src_end -= run;
+            dst_end -= run;
+            count -= run;
+        }
+    }
+
+    /*
+        Insertion of (count) elements before the element (index), when the begin is nearer:
+        (count) new cells are taken before the begin, the first (index) elements are moved
+        by (count) cells towards the begin, and the gap is filled by next_value()
+        (the cells, which were free, are constructed, the moved-from ones are assigned).
+    */
+    template <typename NextValue>
+    void insert_n_by_begin_(size_type index, size_type count, NextValue& next_value){
+        reserve_buckets_in_begin_(count);
+        iterator new_first = m_first;
+        new_first -= count;
+
+        size_type moved_count = std::min(count, index);
+        size_type constructed_count = 0;
+        iterator cell = new_first;
+        try{
+            iterator old = m_first;
+            for (; constructed_count < moved_count; ++constructed_count, ++cell, ++old){
+                std::allocator_traits<Allocator>::construct(m_alloc, cell.m_ptr, std::move_if_noexcept(*old));
+            }
+            for (; constructed_count < count; ++constructed_count, ++cell){
+                std::allocator_traits<Allocator>::construct(m_alloc, cell.m_ptr, next_value());
+            }
+        }
+        catch(...){
+            for (; constructed_count > 0; --constructed_count, ++new_first){
+                std::allocator_traits<Allocator>::destroy(m_alloc, new_first.m_ptr);
+            }
+            throw;
+        }
+        m_first = new_first;
+        m_size += count;
+        count_size_(m_size);
+
+        if (index > count){
+            move_elements_forward_(count, 2 * count, index - count);
+        }
+        iterator it = m_first + std::max(index, count);
+        for (size_type i = std::max(index, count); i < index + count; ++i, ++it){
+            *it = next_value();
+        }
+    }
+
+    // the mirror of insert_n_by_begin_: the elements after (index) are moved towards the end
+    template <typename NextValue>
+    void insert_n_by_end_(size_type index, size_type count, NextValue& next_value){
+        size_type old_size = m_size;
+        size_type moved_count = old_size - index;
+        reserve_buckets_in_end_(count);
+        iterator first_free_cell = (old_size == 0) ? m_last : (m_last + 1);
+
+        // the free cells after the new elements get the last elements of the deque
+        size_type first_moved_position = std::max(old_size, index + count);
+        iterator moved_cells_begin = first_free_cell + static_cast<difference_type>(first_moved_position - old_size);
+        size_type constructed_moved_count = 0;
+        size_type constructed_new_count = 0;
+        try{
+            iterator cell = moved_cells_begin;
+            iterator old = begin() + static_cast<difference_type>(first_moved_position - count);
+            for (size_type position = first_moved_position; position < old_size + count; ++position, ++cell, ++old){
+                std::allocator_traits<Allocator>::construct(m_alloc, cell.m_ptr, std::move_if_noexcept(*old));
+                ++constructed_moved_count;
+            }
+
+            if (moved_count >= count){
+                move_elements_backward_(index + count, index, moved_count - count);
+                iterator it = begin() + static_cast<difference_type>(index);
+                for (size_type i = 0; i < count; ++i, ++it){
+                    *it = next_value();
+                }
+            }
+            else{
+                iterator it = begin() + static_cast<difference_type>(index);
+                for (size_type i = 0; i < moved_count; ++i, ++it){
+                    *it = next_value();
+                }
+                cell = first_free_cell;
+                for (; constructed_new_count < count - moved_count; ++constructed_new_count, ++cell){
+                    std::allocator_traits<Allocator>::construct(m_alloc, cell.m_ptr, next_value());
+                }
+            }
+        }
+        catch(...){
+            for (; constructed_moved_count > 0; --constructed_moved_count, ++moved_cells_begin){
+                std::allocator_traits<Allocator>::destroy(m_alloc, moved_cells_begin.m_ptr);
+            }
+            for (; constructed_new_count > 0; --constructed_new_count, ++first_free_cell){
+                std::allocator_traits<Allocator>::destroy(m_alloc, first_free_cell.m_ptr);
+            }
+            throw;
+        }
+        commit_back(count);
+    }
+
+    /*
+        next_value() gives the inserted values one by one (in their order);
+        the cost is proportional to min(index, size() - index) + count.
+    */
+    template <typename NextValue>
+    iterator insert_n_(size_type index, size_type count, NextValue next_value){
+        if (count != 0){
+            if (m_size != 0 && index < m_size - index){
+                insert_n_by_begin_(index, count, next_value);
+            }
+            else{
+                insert_n_by_end_(index, count, next_value);
+            }
+        }
+        return begin() + static_cast<difference_type>(index);
+    }
+
 public:
 
-    explicit deque(): 
+    explicit deque():
         m_buckets_ptr(nullptr), 
         m_first_allocated_bucket_ptr(nullptr),
         m_last_allocated_bucket_ptr(nullptr),
@@ -598,26 +1091,115 @@ public:
     deque(InputIt first, InputIt last, const Allocator& alloc = Allocator()){}
     */
 
-    //deque (const deque& other){}
+    deque(const deque& other):
+        deque(std::allocator_traits<Allocator>::select_on_container_copy_construction(other.m_alloc))
+    {
+        try{
+            append_segments_of_<false>(other);
+        }
+        catch(...){
+            destroy_all_and_free_();
+            throw;
+        }
+    }
     
-    //deque (deque&& other){}
+    // O(1): the bucket array is handed over, (other) becomes empty
+    deque(deque&& other) noexcept:
+        deque(other.m_alloc)
+    {
+        steal_buckets_(other);
+    }
     
-    //deque (const deque& other, const Allocator& alloc){}
+    deque(const deque& other, const Allocator& alloc):
+        deque(alloc)
+    {
+        try{
+            append_segments_of_<false>(other);
+        }
+        catch(...){
+            destroy_all_and_free_();
+            throw;
+        }
+    }
     
-    //deque (deque&& other, const Allocator& alloc){}
+    // O(1), if (alloc == other.get_allocator()), otherwise the elements are moved one by one
+    deque(deque&& other, const Allocator& alloc):
+        deque(alloc)
+    {
+        if (m_alloc == other.m_alloc){
+            steal_buckets_(other);
+            return;
+        }
+        try{
+            append_segments_of_<true>(other);
+        }
+        catch(...){
+            destroy_all_and_free_();
+            throw;
+        }
+    }
 
 
     //deque (std::initializer_list<T> init_list, const Allocator& alloc){}
     
     ~deque(){
-        erase(cbegin(), cend());
-        shrink_to_fit();
+        destroy_all_and_free_();
     }
     
 
-    //deque& operator=(const deque& other){}
+    /*
+        With the same allocator the existing elements are assigned and the existing buckets
+        are reused (only the missing buckets are allocated).
+        If the allocator propagates and differs, the copy is built with the new allocator
+        and swapped in (copy-and-swap, like list::operator=).
+    */
+    deque& operator=(const deque& other) & {
+        if (this == &other) return *this;
+
+        if constexpr (std::allocator_traits<Allocator>::propagate_on_container_copy_assignment::value){
+            if (!std::allocator_traits<Allocator>::is_always_equal::value && m_alloc != other.m_alloc){
+                deque temp(other, other.m_alloc);
+                destroy_all_and_free_();
+                m_alloc = other.m_alloc;
+                m_alloc_ptr_on_bucket = AllocatorPtrOnBucket(m_alloc);
+                steal_buckets_(temp);
+                return *this;
+            }
+            m_alloc = other.m_alloc;
+            m_alloc_ptr_on_bucket = AllocatorPtrOnBucket(m_alloc);
+        }
+        assign_elements_from_(other);
+        return *this;
+    }
     
-    //deque& operator=(deque&& other)noexcept(noexcept(std::allocator_traits<Allocator>::is_always_equal::value)){}
+    deque& operator=(deque&& other) & noexcept(
+        std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+            ||
+        std::allocator_traits<Allocator>::is_always_equal::value
+    ){
+        if (this == &other) return *this;
+
+        if (
+            std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+                ||
+            std::allocator_traits<Allocator>::is_always_equal::value
+                ||
+            m_alloc == other.m_alloc
+        ){
+            destroy_all_and_free_();
+            if constexpr (std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value){
+                m_alloc = other.m_alloc;
+                m_alloc_ptr_on_bucket = AllocatorPtrOnBucket(m_alloc);
+            }
+            steal_buckets_(other);
+        }
+        else{
+            // the allocators differ and don't propagate: the elements are moved into the own buckets
+            clear();
+            append_segments_of_<true>(other);
+        }
+        return *this;
+    }
     
     
     //deque& operator=(std::initializer_list<value_type> init_list){}
@@ -631,24 +1213,30 @@ public:
 
     //void assign(std::initializer_list<T> init_list){}
 
-    // allocator_type get_allocator() const {}
+    allocator_type get_allocator() const {return m_alloc;}
 
-    // reference at(size_type pos){}
-    // const_reference at(size_type pos) const {}
+    reference at(size_type pos){
+        if (pos >= m_size) {throw std::out_of_range("Farebl::deque::at: pos >= size()");}
+        return *element_ptr_(pos);
+    }
+    const_reference at(size_type pos) const {
+        if (pos >= m_size) {throw std::out_of_range("Farebl::deque::at: pos >= size()");}
+        return *element_ptr_(pos);
+    }
 
 
     reference operator[](size_type pos) & {
-        return *((m_first + pos).m_ptr);
+        return *element_ptr_(pos);
     }   
     const_reference operator[](size_type pos) const& {
-        return *((m_first + pos).m_ptr);
+        return *element_ptr_(pos);
     }
 
     R_val_reference operator[](size_type pos) && {
-        return std::move(*((m_first + pos).m_ptr));
+        return std::move(*element_ptr_(pos));
     }   
     const_R_val_reference operator[](size_type pos) const&& {
-        return std::move(*((m_first + pos).m_ptr));
+        return std::move(*element_ptr_(pos));
     }
     
     reference front() {return *m_first;}
@@ -663,17 +1251,26 @@ public:
     const_iterator begin() const {return {m_buckets_ptr, m_buckets_capacity, m_first.m_bucket_ptr, const_cast<const T*>(m_first.m_ptr)};}
     const_iterator cbegin() const noexcept {return begin();}
 
-    //m_last pointing on the last element (not to the next position after last element, but straight at last element)
+    /*
+        m_last pointing on the last element (not to the next position after last element, but straight at last element);
+        in the empty deque m_first == m_last points on the free cell, so end() == begin()
+    */
     iterator end() {
         if (m_buckets_ptr == nullptr){
             return {m_buckets_ptr, m_buckets_capacity, nullptr, nullptr};
         }
+        if (m_size == 0){
+            return {m_first};
+        }
         return {m_last + 1 };
     }
     const_iterator end() const {
         if (m_buckets_ptr == nullptr){
             return {m_buckets_ptr, m_buckets_capacity, nullptr, nullptr};
         }
+        if (m_size == 0){
+            return begin();
+        }
         return {m_last + 1};
     } 
     const_iterator cend() const noexcept {return end();}
@@ -691,11 +1288,134 @@ public:
 
 
     bool empty() const {return !m_size;}
+
+    /*
+        After reserve_back(count) the next (count) push_back's (and after reserve_front(count) -
+        the next (count) push_front's) neither allocate the buckets nor reallocate the bucket array:
+        all the missing buckets are allocated in one step.
+    */
+    void reserve_back(size_type count){
+        reserve_buckets_in_end_(count);
+    }
+
+    void reserve_front(size_type count){
+        reserve_buckets_in_begin_(count);
+    }
     
     size_type size() const {return m_size;}
+
+    // the counters of container_stats.hpp (zeros without FAREBL_CONTAINER_STATS)
+    container_stats stats() const {return counters_snapshot_(m_size);}
+
+
+    /*
+        Memory footprint (for the decision, whether shrink_to_fit is worth it):
+        capacity_front()/capacity_back() - count of push_front's/push_back's without any allocation
+        (the free cells of the allocated buckets before front()/after back());
+        spare_buckets() - the allocated buckets without elements, which shrink_to_fit would free.
+    */
+    size_type capacity_front() const {return free_cells_in_begin_();}
+
+    size_type capacity_back() const {return free_cells_in_end_();}
+
+    size_type allocated_buckets() const {
+        if (m_buckets_ptr == nullptr) {return 0;}
+        return (m_last_allocated_bucket_ptr - m_first_allocated_bucket_ptr) + 1;
+    }
+
+    size_type spare_buckets() const {return allocated_buckets() - segment_count();}
+
+    // count of the slots of the bucket array (allocated and free ones)
+    size_type bucket_array_capacity() const {return m_buckets_capacity;}
+
+    // bytes of the buckets and of the bucket array (without sizeof(deque))
+    size_type memory_usage() const {
+        return allocated_buckets() * BucketSize * sizeof(T) + m_buckets_capacity * sizeof(T*);
+    }
+
+    // share of the allocated cells, which don't hold the elements: 0 - no waste, near 1 - mostly empty buckets
+    double fragmentation() const {
+        size_type cells = allocated_buckets() * BucketSize;
+        return (cells == 0) ? 0.0 : static_cast<double>(cells - m_size) / static_cast<double>(cells);
+    }
     
     long max_size() const {return std::numeric_limits<difference_type>::max();}
 
+
+    /*
+        The elements of the deque are split into segments at the bucket boundaries:
+        segment 0 starts at front(), segment (segment_count() - 1) ends at back(),
+        every other segment is a whole bucket of BucketSize elements.
+        It allows to process the deque by contiguous arrays (and in parallel - without
+        sharing of the buckets between the workers), instead of stepping through the iterators.
+    */
+    size_type segment_count() const {
+        if (m_size == 0) {return 0;}
+        return (m_last.m_bucket_ptr - m_first.m_bucket_ptr) + 1;
+    }
+
+    segment get_segment(size_type index){
+        T** bucket_ptr = m_first.m_bucket_ptr + index;
+        return {
+            (index == 0) ? m_first.m_ptr : *bucket_ptr,
+            (bucket_ptr == m_last.m_bucket_ptr) ? (m_last.m_ptr + 1) : (*bucket_ptr + BucketSize)
+        };
+    }
+    const_segment get_segment(size_type index) const {
+        segment result = const_cast<deque*>(this)->get_segment(index);
+        return {result.first, result.last};
+    }
+
+    // index of the first element of the segment (segment_offset(segment_count()) == size())
+    size_type segment_offset(size_type index) const {
+        if (index == 0) {return 0;}
+        size_type first_segment_size = BucketSize - (m_first.m_ptr - *m_first.m_bucket_ptr);
+        size_type result = first_segment_size + (index - 1) * BucketSize;
+        return (result < m_size) ? result : m_size;
+    }
+
+    /*
+        Appending without the intermediate buffers (e.g. readv straight into the buckets):
+        after reserve_back(count) the free cells after back() are split into the runs
+        spare_back_segment(0), spare_back_segment(1) ... (an empty segment - no more allocated cells);
+        the caller constructs the elements in the first (count) free cells and makes them
+        the part of the deque by commit_back(count).
+    */
+    segment spare_back_segment(size_type index){
+        if (m_buckets_ptr == nullptr) {return {nullptr, nullptr};}
+        T** bucket_ptr = m_last.m_bucket_ptr;
+        T* ptr = (m_size == 0) ? m_last.m_ptr : (m_last.m_ptr + 1);
+        if (ptr == *bucket_ptr + BucketSize){
+            ++bucket_ptr;
+            if (bucket_ptr > m_last_allocated_bucket_ptr) {return {nullptr, nullptr};}
+            ptr = *bucket_ptr;
+        }
+        if (index == 0) {return {ptr, *bucket_ptr + BucketSize};}
+        bucket_ptr += index;
+        if (bucket_ptr > m_last_allocated_bucket_ptr) {return {nullptr, nullptr};}
+        return {*bucket_ptr, *bucket_ptr + BucketSize};
+    }
+
+    // (count) must not exceed the count of the free cells, given by spare_back_segment
+    void commit_back(size_type count){
+        if (count == 0) {return;}
+        T** bucket_ptr = m_last.m_bucket_ptr;
+        T* ptr = (m_size == 0) ? m_last.m_ptr : (m_last.m_ptr + 1);
+        size_type rest = count;
+        while (true){
+            size_type run = std::min<size_type>(rest, (*bucket_ptr + BucketSize) - ptr);
+            ptr += run;
+            rest -= run;
+            if (rest == 0) {break;}
+            ++bucket_ptr;
+            ptr = *bucket_ptr;
+        }
+        m_last.m_bucket_ptr = bucket_ptr;
+        m_last.m_ptr = ptr - 1;
+        m_size += count;
+        count_size_(m_size);
+    }
+
     void shrink_to_fit(){
         if (m_buckets_ptr == nullptr){ return; }
          
@@ -728,11 +1448,11 @@ public:
             +
             (((m_last.m_ptr - *m_last.m_bucket_ptr) < (m_first.m_ptr - *m_first.m_bucket_ptr)) ? 0 : 1);
         
-        T** new_buckets_ptr = std::allocator_traits<AllocatorPtrOnBucket>::allocate(m_alloc_ptr_on_bucket, new_buckets_capacity);
+        T** new_buckets_ptr = allocate_bucket_array_(new_buckets_capacity);
         decltype(new_buckets_capacity) success_allocated_count = 0;
         try{
             for (; success_allocated_count < new_buckets_capacity; ++success_allocated_count){
-                new_buckets_ptr[success_allocated_count] = std::allocator_traits<Allocator>::allocate(m_alloc, BucketSize);
+                new_buckets_ptr[success_allocated_count] = allocate_bucket_();
             }
         }
         catch(...){  
@@ -767,6 +1487,8 @@ public:
             std::allocator_traits<AllocatorPtrOnBucket>::deallocate(m_alloc_ptr_on_bucket, new_buckets_ptr, new_buckets_capacity);
             throw;
         }
+        count_map_reallocation_();
+        count_moved_elements_(m_size);
         size_t temp_size = m_size;
         clear();
         m_size = temp_size;
@@ -799,25 +1521,60 @@ public:
     }
     
 
-    // iterator insert(const_iterator pos, const T& value){}
+    /*
+        The elements are shifted from the nearer end of the deque (by the runs inside the buckets),
+        new buckets are allocated only at that end.
+    */
+    iterator insert(const_iterator pos, const T& value){
+        return emplace(pos, value);
+    }
     
-    // iterator insert(const_iterator pos, T&& value){}
+    iterator insert(const_iterator pos, T&& value){
+        return emplace(pos, std::move(value));
+    }
     
 
-    //iterator insert(const_iterator pos, size_type count, const T& value){}
+    iterator insert(const_iterator pos, size_type count, const T& value){
+        size_type index = pos - cbegin();
+        T copy(value); // (value) may be an element of this deque
+        return insert_n_(index, count, [&copy]() -> const T& {return copy;});
+    }
 
     
-    /*
-    template <typename InputIt> 
-    iterator insert(const_iterator pos, InputIt first, InputIt last){}
-    */
+    template <typename InputIt, typename = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+    iterator insert(const_iterator pos, InputIt first, InputIt last){
+        size_type index = pos - cbegin();
+        using category = typename std::iterator_traits<InputIt>::iterator_category;
+        if constexpr (std::is_base_of<std::forward_iterator_tag, category>::value){
+            size_type count = std::distance(first, last);
+            return insert_n_(index, count, [&first]() -> decltype(auto) {return *first++;});
+        }
+        else{
+            // the single-pass range is collected at first (its length is unknown)
+            deque temp(m_alloc);
+            for (; first != last; ++first){
+                temp.emplace_back(*first);
+            }
+            size_type count = temp.size();
+            size_type temp_index = 0;
+            return insert_n_(index, count, [&temp, &temp_index]() -> T&& {return std::move(temp[temp_index++]);});
+        }
+    }
     
-    //iterator insert(std::initializer_list<T> init_list){}
+    iterator insert(const_iterator pos, std::initializer_list<T> init_list){
+        return insert(pos, init_list.begin(), init_list.end());
+    }
     
-    /*
     template< class... Args >
-    iterator emplace( const_iterator pos, Args&&... args );
-    */
+    iterator emplace( const_iterator pos, Args&&... args ){
+        size_type index = pos - cbegin();
+        if (index == 0 && m_size != 0){
+            emplace_front(std::forward<Args>(args)...);
+            return begin();
+        }
+        T value(std::forward<Args>(args)...);
+        return insert_n_(index, 1, [&value]() -> T&& {return std::move(value);});
+    }
 
 
     //iterator erase( const_iterator pos );
@@ -828,7 +1585,9 @@ public:
         if (m_size == 0) {return end();}
 
         if (first == last) {    
-            return {last.m_buckets_ptr, last.m_buckets_capacity, last.m_bucket_ptr, const_cast<T*>(last.m_ptr)};
+            iterator result(last.m_buckets_ptr, last.m_buckets_capacity, last.m_bucket_ptr, const_cast<T*>(last.m_ptr));
+            result.m_pseudo_cell_index = last.m_pseudo_cell_index; // last can be end() after the last slot
+            return result;
         } 
         /*
             like in gcc & clang here is no checking (first > last);
@@ -842,10 +1601,9 @@ public:
                 }
 
                 // for that future inserts are inside the middle of the deck:
-                m_first.m_bucket_ptr = m_last.m_bucket_ptr = m_buckets_ptr + (m_buckets_capacity / 2);
-                m_first.m_ptr = m_last.m_ptr = *m_last.m_bucket_ptr;
                 m_size = 0;
                 center_the_iterators_m_first_and_m_last_();
+                return end();
             }
             else{
                 while(m_first != last){
@@ -863,7 +1621,7 @@ public:
                 --m_last;
                 --m_size;
             }
-            return {last.m_buckets_ptr, last.m_buckets_capacity, last.m_bucket_ptr, const_cast<T*>(last.m_ptr)};
+            return end();
         }
 
         else if (first.m_ptr == *first.m_bucket_ptr && last.m_ptr == *last.m_bucket_ptr){
@@ -894,7 +1652,7 @@ public:
                     first.m_bucket_ptr +=count_delete_buckets; 
                 }
                 // now the distance between the last_bucket of the deck and the bucket block of pointers_to_delete_buckets is less than the size of the bucket block
-                difference_type remainder_size = m_last.m_bucket_ptr - first.m_bucket_ptr + count_delete_buckets - 1;
+                difference_type remainder_size = m_last.m_bucket_ptr - (first.m_bucket_ptr + count_delete_buckets - 1);
 
                 for (difference_type i = 0; i < remainder_size; ++i){
                     std::swap(first.m_bucket_ptr[i], first.m_bucket_ptr[i+count_delete_buckets]);
@@ -908,6 +1666,7 @@ public:
                     std::allocator_traits<Allocator>::destroy(m_alloc, const_cast<T*>(first.m_ptr));
                     ++first; 
                 }       
+                m_size -= static_cast<size_type>(count_delete_buckets) * BucketSize;
 
                 return {m_buckets_ptr, m_buckets_capacity, m_last.m_bucket_ptr - old_distance_from_last_to_end, const_cast<T*>(last.m_ptr)};
             }
@@ -926,12 +1685,14 @@ public:
             } 
 
             first.m_bucket_ptr -=  reminder_size; // first.m_bucket_ptr is pointing on first trach_bucket
+            first.m_ptr = *first.m_bucket_ptr; // updating m_ptr
             m_first.m_bucket_ptr = first.m_bucket_ptr + count_delete_buckets; 
 
             while(first.m_bucket_ptr != m_first.m_bucket_ptr){
                 std::allocator_traits<Allocator>::destroy(m_alloc, const_cast<T*>(first.m_ptr));
                 ++first; 
             }        
+            m_size -= static_cast<size_type>(count_delete_buckets) * BucketSize;
             return {last.m_buckets_ptr, last.m_buckets_capacity, last.m_bucket_ptr, const_cast<T*>(last.m_ptr)};
         }
 
@@ -946,6 +1707,7 @@ public:
             
             iterator return_pos = first_it;
             iterator end_pos = end();
+            count_moved_elements_(end_pos - second_it);
             while(second_it != end_pos){
                 std::swap(*first_it, *second_it);
                 ++first_it;
@@ -965,6 +1727,7 @@ public:
         --first_it;
         --second_it;
         iterator end_pos = begin() - 1;
+        count_moved_elements_(first_it - end_pos);
         while(first_it != end_pos){
             std::swap(*first_it, *second_it);
             --first_it;
@@ -1009,11 +1772,13 @@ public:
             m_last = m_first;
             
             ++m_size;
+            count_size_(m_size);
             return;
         }
         else if (m_size == 0){
             std::allocator_traits<Allocator>::construct(m_alloc, m_last.m_ptr, value);
             ++m_size;
+            count_size_(m_size);
             return;
         }
         else if ((m_last.m_ptr - *m_last.m_bucket_ptr) < static_cast<long int>(BucketSize - 1)){
@@ -1024,6 +1789,7 @@ public:
             satisfied guarantees that (++m_last) will not require a transition to the next bucket
         */
             ++m_size;
+            count_size_(m_size);
             return;
         }
         else {
@@ -1032,7 +1798,7 @@ public:
                     std::allocator_traits<Allocator>::construct(m_alloc, *(m_last.m_bucket_ptr + 1), value);
                 }
                 else{
-                    *(m_last_allocated_bucket_ptr + 1) = std::allocator_traits<Allocator>::allocate(m_alloc, BucketSize);
+                    *(m_last_allocated_bucket_ptr + 1) = allocate_bucket_();
                     try{
                         std::allocator_traits<Allocator>::construct(m_alloc, *(m_last_allocated_bucket_ptr + 1), value);
                     }
@@ -1044,6 +1810,7 @@ public:
                 }
                 ++m_last;
                 ++m_size;
+                count_size_(m_size);
                 return;
             }
             else{ // the worst case --> need reallocation
@@ -1069,6 +1836,7 @@ public:
                 m_buckets_ptr = result_of_realloc.new_m_buckets_ptr;
                 m_buckets_capacity = result_of_realloc.new_m_buckets_capacity;
                 ++m_size;
+                count_size_(m_size);
                 return;
             }    
         }
@@ -1076,14 +1844,27 @@ public:
 
 
     
-    //void push_back( T&& value ){}
-
+    void push_back( T&& value ){
+        emplace_back(std::move(value));
+    }
 
 
-    /*
     template< class... Args >
-    reference emplace_back( Args&&... args );
-    */
+    reference emplace_back( Args&&... args ){
+        reserve_buckets_in_end_(1);
+        T** bucket_ptr = m_last.m_bucket_ptr;
+        T* ptr = (m_size == 0) ? m_last.m_ptr : (m_last.m_ptr + 1);
+        if (ptr == *bucket_ptr + BucketSize){
+            ++bucket_ptr;
+            ptr = *bucket_ptr;
+        }
+        std::allocator_traits<Allocator>::construct(m_alloc, ptr, std::forward<Args>(args)...);
+        m_last.m_bucket_ptr = bucket_ptr;
+        m_last.m_ptr = ptr;
+        ++m_size;
+        count_size_(m_size);
+        return *ptr;
+    }
 
 
     void pop_back(){
@@ -1097,15 +1878,38 @@ public:
     }
 
 
-    //void push_front( const T& value );
+    void push_front( const T& value ){
+        emplace_front(value);
+    }
 
-    //void push_front( T&& value );
+    void push_front( T&& value ){
+        emplace_front(std::move(value));
+    }
 
 
-    /*
     template< class... Args >
-    reference emplace_front( Args&&... args );
-    */
+    reference emplace_front( Args&&... args ){
+        reserve_buckets_in_begin_(1);
+        if (m_size == 0){
+            std::allocator_traits<Allocator>::construct(m_alloc, m_first.m_ptr, std::forward<Args>(args)...);
+            ++m_size;
+            count_size_(m_size);
+            return *m_first.m_ptr;
+        }
+
+        T** bucket_ptr = m_first.m_bucket_ptr;
+        T* ptr = m_first.m_ptr - 1;
+        if (m_first.m_ptr == *bucket_ptr){
+            --bucket_ptr;
+            ptr = *bucket_ptr + (BucketSize - 1);
+        }
+        std::allocator_traits<Allocator>::construct(m_alloc, ptr, std::forward<Args>(args)...);
+        m_first.m_bucket_ptr = bucket_ptr;
+        m_first.m_ptr = ptr;
+        ++m_size;
+        count_size_(m_size);
+        return *ptr;
+    }
 
 
     void pop_front(){
@@ -1117,13 +1921,134 @@ public:
             center_the_iterators_m_first_and_m_last_();
         }
     }
-    
+
+
+    /*
+        Batch versions of push_back/pop_front:
+        the missing buckets are allocated in one step, the elements are copied (or moved out)
+        by whole bucket runs (by memcpy for trivially copyable T and pointer iterators),
+        and m_first/m_last/m_size are updated once per batch.
+    */
+    template <typename InputIt>
+    void push_back_n(InputIt first, size_type count){
+        if (count == 0) {return;}
+        reserve_buckets_in_end_(count);
+
+        T** bucket_ptr = m_last.m_bucket_ptr;
+        T* ptr = (m_size == 0) ? m_last.m_ptr : (m_last.m_ptr + 1);
+        if (ptr == *bucket_ptr + BucketSize){
+            ++bucket_ptr;
+            ptr = *bucket_ptr;
+        }
+        iterator start_pos(m_buckets_ptr, m_buckets_capacity, bucket_ptr, ptr);
+
+        size_type constructed_count = 0;
+        try{
+            while (true){
+                size_type run = std::min<size_type>(count - constructed_count, (*bucket_ptr + BucketSize) - ptr);
+                if constexpr (is_memcpy_source_<InputIt>()){
+                    std::memcpy(static_cast<void*>(ptr), static_cast<const void*>(first), run * sizeof(T));
+                    first += run;
+                    ptr += run;
+                    constructed_count += run;
+                }
+                else{
+                    for (T* end_pos = ptr + run; ptr != end_pos; ++ptr, ++first){
+                        std::allocator_traits<Allocator>::construct(m_alloc, ptr, *first);
+                        ++constructed_count;
+                    }
+                }
+                if (constructed_count == count) {break;}
+                ++bucket_ptr;
+                ptr = *bucket_ptr;
+            }
+        }
+        catch(...){
+            for (; constructed_count > 0; --constructed_count, ++start_pos){
+                std::allocator_traits<Allocator>::destroy(m_alloc, start_pos.m_ptr);
+            }
+            throw;
+        }
+
+        m_last.m_bucket_ptr = bucket_ptr;
+        m_last.m_ptr = ptr - 1;
+        m_size += count;
+        count_size_(m_size);
+    }
+
+    // pops min(count, size()) elements from the front, moving them to (out)
+    template <typename OutputIt>
+    OutputIt pop_front_n(OutputIt out, size_type count){
+        if (count > m_size) {count = m_size;}
+        if (count == 0) {return out;}
+
+        T** bucket_ptr = m_first.m_bucket_ptr;
+        T* ptr = m_first.m_ptr;
+        size_type popped_count = 0;
+
+        auto update_m_first_and_m_size = [&](){
+            m_first.m_bucket_ptr = bucket_ptr;
+            m_first.m_ptr = ptr;
+            m_size -= popped_count;
+            if (m_size == 0){
+                center_the_iterators_m_first_and_m_last_();
+            }
+        };
+
+        try{
+            while (popped_count < count){
+                size_type run = std::min<size_type>(count - popped_count, (*bucket_ptr + BucketSize) - ptr);
+                if constexpr (is_memcpy_destination_<OutputIt>()){
+                    std::memcpy(static_cast<void*>(out), static_cast<const void*>(ptr), run * sizeof(T));
+                    out += run;
+                }
+                else{
+                    for (T* p = ptr, *end_pos = ptr + run; p != end_pos; ++p, ++out){
+                        *out = std::move(*p);
+                    }
+                }
+                if constexpr (!std::is_trivially_destructible<T>::value){
+                    for (T* p = ptr, *end_pos = ptr + run; p != end_pos; ++p){
+                        std::allocator_traits<Allocator>::destroy(m_alloc, p);
+                    }
+                }
+                ptr += run;
+                popped_count += run;
+                if (ptr == *bucket_ptr + BucketSize && popped_count < m_size){
+                    ++bucket_ptr;
+                    ptr = *bucket_ptr;
+                }
+            }
+        }
+        catch(...){
+            // the elements of the current run stay in the deque (in moved-from state)
+            update_m_first_and_m_size();
+            throw;
+        }
+        update_m_first_and_m_size();
+        return out;
+    }
+
 
     //void resize( size_type count );
 
     //void resize( size_type count, const value_type& value );
 
-    //void swap( deque& other ) noexcept(noexcept(std::allocator_traits<Allocator>::is_always_equal::value));
+    // O(1): the bucket arrays are exchanged (the allocators - only if they propagate on swap)
+    void swap(deque& other) noexcept {
+        std::swap(m_buckets_ptr, other.m_buckets_ptr);
+        std::swap(m_first_allocated_bucket_ptr, other.m_first_allocated_bucket_ptr);
+        std::swap(m_last_allocated_bucket_ptr, other.m_last_allocated_bucket_ptr);
+        std::swap(m_first, other.m_first);
+        std::swap(m_last, other.m_last);
+        std::swap(m_size, other.m_size);
+        std::swap(m_buckets_capacity, other.m_buckets_capacity);
+
+        if constexpr(std::allocator_traits<Allocator>::propagate_on_container_swap::value){
+            std::swap(m_alloc, other.m_alloc);
+            std::swap(m_alloc_ptr_on_bucket, other.m_alloc_ptr_on_bucket);
+        }
+    }
 
 };
 
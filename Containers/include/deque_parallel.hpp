@@ -0,0 +1,326 @@
+#ifndef FAREBL_DEQUE_PARALLEL_H
+#define FAREBL_DEQUE_PARALLEL_H
+
+#include <algorithm>   // for sort, min, move
+#include <cstddef>     // for size_t
+#include <exception>   // for exception_ptr, current_exception, rethrow_exception
+#include <functional>  // for less, plus
+#include <memory>      // for allocator_traits, uninitialized_move, destroy
+#include <thread>      // for thread, hardware_concurrency
+#include <utility>     // for move
+#include <vector>      // for vector
+
+#include "deque.hpp"
+
+namespace Farebl {
+namespace parallel {
+
+namespace detail {
+
+    inline size_t default_threads_count(){
+        size_t count = std::thread::hardware_concurrency();
+        return (count == 0) ? 1 : count;
+    }
+
+    /*
+        Runs task(0) ... task(count - 1): (count - 1) tasks on the new std::threads and the
+        last one on the calling thread. The first caught exception is rethrown after all joins.
+    */
+    template <typename Task>
+    void run_tasks(size_t count, Task task){
+        if (count == 0) {return;}
+        if (count == 1) {
+            task(0);
+            return;
+        }
+        std::vector<std::exception_ptr> errors(count);
+        std::vector<std::thread> workers;
+        workers.reserve(count - 1);
+
+        auto guarded_task = [&task, &errors](size_t index){
+            try{
+                task(index);
+            }
+            catch(...){
+                errors[index] = std::current_exception();
+            }
+        };
+        try{
+            for (size_t i = 0; i < count - 1; ++i){
+                workers.emplace_back(guarded_task, i);
+            }
+        }
+        catch(...){
+            for (std::thread& worker: workers) {worker.join();}
+            throw;
+        }
+        guarded_task(count - 1);
+        for (std::thread& worker: workers) {worker.join();}
+
+        for (std::exception_ptr& error: errors){
+            if (error) {std::rethrow_exception(error);}
+        }
+    }
+
+    /*
+        The deque segments [0, segment_count) are split into (parts) continuous ranges;
+        the part (index) gets the segments [first_segment(index), first_segment(index + 1)).
+    */
+    inline size_t first_segment(size_t index, size_t parts, size_t segment_count){
+        return (segment_count * index) / parts;
+    }
+
+    inline size_t parts_count(size_t segment_count, size_t threads){
+        if (threads == 0) {threads = 1;}
+        return std::min(threads, segment_count);
+    }
+
+    /*
+        Sequential walk over the elements of the deque from the start of the segment (segment)
+        by the raw pointers of get_segment(): the merges of sort() read and write the deque
+        through it instead of deque::iterator.
+    */
+    template <typename Deque, typename T>
+    class segment_cursor{
+        Deque& m_deque;
+        size_t m_segment;
+        T* m_ptr;
+        T* m_last;
+
+        void load_(){
+            auto segment = m_deque.get_segment(m_segment);
+            m_ptr = segment.first;
+            m_last = segment.last;
+        }
+
+    public:
+        segment_cursor(Deque& d, size_t segment): m_deque(d), m_segment(segment), m_ptr(nullptr), m_last(nullptr){
+            if (m_segment < m_deque.segment_count()) {load_();}
+        }
+
+        T& operator*() const {return *m_ptr;}
+
+        segment_cursor& operator++(){
+            if (++m_ptr == m_last && m_segment + 1 < m_deque.segment_count()){
+                ++m_segment;
+                load_();
+            }
+            return *this;
+        }
+    };
+
+    // moves the merge of the sorted runs [a, a + a_count) and [b, b + b_count) to (out), stable
+    template <typename InputA, typename InputB, typename Output, typename Compare>
+    void merge_runs(InputA a, size_t a_count, InputB b, size_t b_count, Output out, Compare& comp){
+        for (; a_count != 0 && b_count != 0; ++out){
+            if (comp(*b, *a)) {*out = std::move(*b); ++b; --b_count;}
+            else              {*out = std::move(*a); ++a; --a_count;}
+        }
+        for (; a_count != 0; --a_count, ++a, ++out) {*out = std::move(*a);}
+        for (; b_count != 0; --b_count, ++b, ++out) {*out = std::move(*b);}
+    }
+
+} // end namespace detail
+
+
+
+/*
+    All the algorithms divide the work at the bucket boundaries, so two workers never
+    touch the same bucket (and therefore never share a cache line of the elements).
+*/
+
+template <typename T, typename Alloc, size_t BucketSize, typename UnaryFunc>
+void for_each(deque<T, Alloc, BucketSize>& d, UnaryFunc func, size_t threads = detail::default_threads_count()){
+    size_t segment_count = d.segment_count();
+    size_t parts = detail::parts_count(segment_count, threads);
+
+    detail::run_tasks(parts, [&](size_t part){
+        size_t end_segment = detail::first_segment(part + 1, parts, segment_count);
+        for (size_t s = detail::first_segment(part, parts, segment_count); s < end_segment; ++s){
+            for (T& value: d.get_segment(s)){
+                func(value);
+            }
+        }
+    });
+}
+
+
+// in-place transform: every element is replaced by op(element)
+template <typename T, typename Alloc, size_t BucketSize, typename UnaryOp>
+void transform(deque<T, Alloc, BucketSize>& d, UnaryOp op, size_t threads = detail::default_threads_count()){
+    parallel::for_each(d, [&op](T& value){ value = op(value); }, threads);
+}
+
+
+/*
+    dst[i] = op(src[i]) for every i in [0, src.size());
+    dst must already hold at least src.size() elements.
+    The work is split at the bucket boundaries of the src.
+*/
+template <typename T, typename AllocT, size_t BucketSizeT, typename U, typename AllocU, size_t BucketSizeU, typename UnaryOp>
+void transform(
+    const deque<T, AllocT, BucketSizeT>& src,
+    deque<U, AllocU, BucketSizeU>& dst,
+    UnaryOp op,
+    size_t threads = detail::default_threads_count()
+){
+    size_t segment_count = src.segment_count();
+    size_t parts = detail::parts_count(segment_count, threads);
+
+    detail::run_tasks(parts, [&](size_t part){
+        size_t begin_segment = detail::first_segment(part, parts, segment_count);
+        size_t end_segment = detail::first_segment(part + 1, parts, segment_count);
+        auto dst_it = dst.begin() + src.segment_offset(begin_segment);
+        for (size_t s = begin_segment; s < end_segment; ++s){
+            for (const T& value: src.get_segment(s)){
+                *dst_it = op(value);
+                ++dst_it;
+            }
+        }
+    });
+}
+
+
+/*
+    Every worker folds its own segments (starting from its first element, so op doesn't need
+    an identity element), then the partial results are folded with init in the order of the parts.
+    op must be associative.
+*/
+template <typename T, typename Alloc, size_t BucketSize, typename Result, typename BinaryOp>
+Result reduce(const deque<T, Alloc, BucketSize>& d, Result init, BinaryOp op, size_t threads = detail::default_threads_count()){
+    size_t segment_count = d.segment_count();
+    size_t parts = detail::parts_count(segment_count, threads);
+    if (parts == 0) {return init;}
+
+    std::vector<Result> partial_results;
+    partial_results.reserve(parts);
+    for (size_t part = 0; part < parts; ++part){
+        partial_results.push_back(*d.get_segment(detail::first_segment(part, parts, segment_count)).first);
+    }
+
+    detail::run_tasks(parts, [&](size_t part){
+        size_t begin_segment = detail::first_segment(part, parts, segment_count);
+        size_t end_segment = detail::first_segment(part + 1, parts, segment_count);
+        Result& accumulator = partial_results[part];
+
+        auto current_segment = d.get_segment(begin_segment);
+        for (const T* ptr = current_segment.first + 1; ptr != current_segment.last; ++ptr){
+            accumulator = op(std::move(accumulator), *ptr);
+        }
+        for (size_t s = begin_segment + 1; s < end_segment; ++s){
+            for (const T& value: d.get_segment(s)){
+                accumulator = op(std::move(accumulator), value);
+            }
+        }
+    });
+
+    for (Result& partial_result: partial_results){
+        init = op(std::move(init), std::move(partial_result));
+    }
+    return init;
+}
+
+template <typename T, typename Alloc, size_t BucketSize>
+T reduce(const deque<T, Alloc, BucketSize>& d){
+    return parallel::reduce(d, T(), std::plus<T>());
+}
+
+
+/*
+    Each worker moves its own range of whole buckets (through the raw pointers of get_segment())
+    into one buffer of size() elements, allocated by the allocator of the deque, and sorts it
+    there as the contiguous array. Then the sorted ranges are merged pairwise, between the buffer
+    and the deque in turn (the merges of one round run in parallel too); the deque is read
+    and written by the segments, so neither the sort nor the merges go through deque::iterator.
+    If comp (or the move of T) throws, the elements are left in the valid but unspecified order.
+*/
+template <typename T, typename Alloc, size_t BucketSize, typename Compare>
+void sort(deque<T, Alloc, BucketSize>& d, Compare comp, size_t threads = detail::default_threads_count()){
+    using Deque = deque<T, Alloc, BucketSize>;
+    using Cursor = detail::segment_cursor<Deque, T>;
+    // (Alloc) may be declared for another type: the buffer goes through the allocator of the deque
+    using BufferAllocator = typename std::allocator_traits<typename Deque::allocator_type>::template rebind_alloc<T>;
+    size_t segment_count = d.segment_count();
+    if (segment_count <= 1){
+        if (segment_count == 1) {std::sort(d.get_segment(0).first, d.get_segment(0).last, comp);}
+        return;
+    }
+    size_t parts = detail::parts_count(segment_count, threads);
+
+    std::vector<size_t> first_segments(parts + 1);
+    std::vector<size_t> bounds(parts + 1);
+    for (size_t part = 0; part <= parts; ++part){
+        first_segments[part] = detail::first_segment(part, parts, segment_count);
+        bounds[part] = d.segment_offset(first_segments[part]);
+    }
+
+    BufferAllocator alloc(d.get_allocator());
+    T* buffer = std::allocator_traits<BufferAllocator>::allocate(alloc, d.size());
+    std::vector<char> moved(parts, 0); // the range of the part in (buffer) is constructed
+    try{
+        detail::run_tasks(parts, [&](size_t part){
+            T* out = buffer + bounds[part];
+            T* constructed_end = out;
+            try{
+                for (size_t s = first_segments[part]; s < first_segments[part + 1]; ++s){
+                    auto segment = d.get_segment(s);
+                    constructed_end = std::uninitialized_move(segment.first, segment.last, constructed_end);
+                }
+            }
+            catch(...){
+                std::destroy(out, constructed_end);
+                throw;
+            }
+            moved[part] = 1;
+            std::sort(out, constructed_end, comp);
+        });
+
+        bool in_buffer = true;
+        for (size_t width = 1; width < parts; width *= 2, in_buffer = !in_buffer){
+            size_t merges_count = (parts + 2 * width - 1) / (2 * width);
+            detail::run_tasks(merges_count, [&](size_t merge){
+                size_t first = merge * 2 * width;
+                size_t middle = std::min(first + width, parts);
+                size_t last = std::min(first + 2 * width, parts);
+                size_t first_count = bounds[middle] - bounds[first];
+                size_t second_count = bounds[last] - bounds[middle];
+                // the single range of the last merge is moved over as is: the next round reads the other side
+                if (in_buffer){
+                    detail::merge_runs(buffer + bounds[first], first_count, buffer + bounds[middle], second_count, Cursor(d, first_segments[first]), comp);
+                }
+                else{
+                    detail::merge_runs(Cursor(d, first_segments[first]), first_count, Cursor(d, first_segments[middle]), second_count, buffer + bounds[first], comp);
+                }
+            });
+        }
+
+        if (in_buffer){
+            detail::run_tasks(parts, [&](size_t part){
+                T* in = buffer + bounds[part];
+                for (size_t s = first_segments[part]; s < first_segments[part + 1]; ++s){
+                    auto segment = d.get_segment(s);
+                    std::move(in, in + segment.size(), segment.first);
+                    in += segment.size();
+                }
+            });
+        }
+    }
+    catch(...){
+        for (size_t part = 0; part < parts; ++part){
+            if (moved[part]) {std::destroy(buffer + bounds[part], buffer + bounds[part + 1]);}
+        }
+        std::allocator_traits<BufferAllocator>::deallocate(alloc, buffer, d.size());
+        throw;
+    }
+    std::destroy(buffer, buffer + d.size());
+    std::allocator_traits<BufferAllocator>::deallocate(alloc, buffer, d.size());
+}
+
+template <typename T, typename Alloc, size_t BucketSize>
+void sort(deque<T, Alloc, BucketSize>& d){
+    parallel::sort(d, std::less<T>());
+}
+
+} // end namespace parallel
+} // end namespace Farebl
+#endif // FAREBL_DEQUE_PARALLEL_H
@@ -0,0 +1,242 @@
+#ifndef FAREBL_HUGEPAGE_ALLOCATOR_H
+#define FAREBL_HUGEPAGE_ALLOCATOR_H
+
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uintptr_t
+#include <map>          // for map
+#include <memory>       // for shared_ptr, make_shared
+#include <mutex>        // for mutex, lock_guard
+#include <new>          // for bad_alloc, placement new
+#include <type_traits>  // for true_type
+#include <utility>      // for pair
+#include <vector>       // for vector
+
+#include <sys/mman.h>     // for mmap, munmap, madvise
+#include <sys/syscall.h>  // for SYS_getcpu, SYS_mbind
+#include <unistd.h>       // for syscall
+
+namespace Farebl {
+
+enum class numa_policy{
+    first_touch,    // the kernel places every page on the node of the thread, which touches it first
+    local_preferred // every chunk prefers (mbind MPOL_PREFERRED) the node of the thread, which allocates it:
+                    // the pages go to another node, when that node is out of memory (no hard binding)
+};
+
+
+/*
+    Source of the memory for hugepage_allocator.
+    The memory is mapped by chunks of (chunk_size) bytes (a multiple of 2 MiB), aligned to 2 MiB
+    and advised as transparent hugepages (MADV_HUGEPAGE), so one TLB entry covers 2 MiB
+    (512 buckets of 4 KiB) instead of 4 KiB.
+    Small blocks (the deque buckets, the lists nodes) are carved from the chunks and reused
+    through the free lists (one per NUMA node and block size); the large blocks (> chunk_size / 4,
+    e.g. the bucket array of a huge deque) get their own hugepage mapping.
+    The chunks are returned to the system only by the destructor.
+    Thread-safe.
+*/
+class hugepage_arena{
+public:
+    static constexpr size_t huge_page_size = 2 * 1024 * 1024;
+    static constexpr size_t block_alignment = 64;
+
+private:
+    struct FreeBlock{
+        FreeBlock* next;
+    };
+
+    struct Region{
+        char* current = nullptr;
+        char* end = nullptr;
+    };
+
+    struct Mapping{
+        void* memory;
+        size_t size;
+    };
+
+    mutable std::mutex m_mutex;
+    size_t m_chunk_size;
+    numa_policy m_policy;
+    std::map<int, Region> m_regions;                         // NUMA node -> current chunk
+    std::map<std::pair<int, size_t>, FreeBlock*> m_free_lists; // (NUMA node, block size) -> free blocks
+    std::vector<Mapping> m_chunks;
+    size_t m_mapped_bytes = 0;
+
+    static size_t round_up_(size_t value, size_t alignment){
+        return ((value + alignment - 1) / alignment) * alignment;
+    }
+
+    int current_node_() const {
+        if (m_policy == numa_policy::first_touch) {return 0;}
+    #ifdef SYS_getcpu
+        unsigned cpu = 0;
+        unsigned node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {return static_cast<int>(node);}
+    #endif
+        return 0;
+    }
+
+    static void prefer_node_(void* memory, size_t size, int node){
+    #ifdef SYS_mbind
+        constexpr int mpol_preferred = 1;
+        unsigned long node_mask[16] = {};
+        if (node < 0 || static_cast<size_t>(node) >= sizeof(node_mask) * 8) {return;}
+        node_mask[node / (sizeof(unsigned long) * 8)] = 1UL << (node % (sizeof(unsigned long) * 8));
+        // failure isn't an error: the memory stays with the default policy
+        syscall(SYS_mbind, memory, size, mpol_preferred, node_mask, sizeof(node_mask) * 8, 0);
+    #else
+        (void)memory; (void)size; (void)node;
+    #endif
+    }
+
+    // mapping of (size) bytes (multiple of huge_page_size), aligned to huge_page_size
+    void* map_huge_(size_t size, int node){
+        size_t mapped_size = size + huge_page_size;
+        void* memory = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {throw std::bad_alloc();}
+
+        std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(memory);
+        std::uintptr_t aligned_begin = round_up_(begin, huge_page_size);
+        if (aligned_begin != begin){
+            munmap(memory, aligned_begin - begin);
+        }
+        size_t tail_size = (begin + mapped_size) - (aligned_begin + size);
+        if (tail_size != 0){
+            munmap(reinterpret_cast<void*>(aligned_begin + size), tail_size);
+        }
+        void* result = reinterpret_cast<void*>(aligned_begin);
+    #ifdef MADV_HUGEPAGE
+        madvise(result, size, MADV_HUGEPAGE);
+    #endif
+        if (m_policy == numa_policy::local_preferred){
+            prefer_node_(result, size, node);
+        }
+        m_mapped_bytes += size;
+        return result;
+    }
+
+public:
+    explicit hugepage_arena(size_t chunk_size = huge_page_size, numa_policy policy = numa_policy::first_touch):
+        m_chunk_size(round_up_((chunk_size == 0) ? huge_page_size : chunk_size, huge_page_size)),
+        m_policy(policy)
+    {}
+
+    hugepage_arena(const hugepage_arena&) = delete;
+    hugepage_arena& operator=(const hugepage_arena&) = delete;
+
+    ~hugepage_arena(){
+        for (Mapping& chunk: m_chunks){
+            munmap(chunk.memory, chunk.size);
+        }
+    }
+
+    void* allocate(size_t bytes){
+        size_t block_size = round_up_((bytes == 0) ? 1 : bytes, block_alignment);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        int node = current_node_();
+
+        if (block_size > m_chunk_size / 4){
+            return map_huge_(round_up_(block_size, huge_page_size), node);
+        }
+
+        FreeBlock*& free_list = m_free_lists[{node, block_size}];
+        if (free_list != nullptr){
+            FreeBlock* result = free_list;
+            free_list = result->next;
+            return result;
+        }
+
+        Region& region = m_regions[node];
+        if (region.current == nullptr || static_cast<size_t>(region.end - region.current) < block_size){
+            m_chunks.reserve(m_chunks.size() + 1);
+            char* chunk = static_cast<char*>(map_huge_(m_chunk_size, node));
+            m_chunks.push_back({chunk, m_chunk_size});
+            // the rest of the previous chunk is lost (it's less than one block)
+            region.current = chunk;
+            region.end = chunk + m_chunk_size;
+        }
+        void* result = region.current;
+        region.current += block_size;
+        return result;
+    }
+
+    void deallocate(void* ptr, size_t bytes){
+        size_t block_size = round_up_((bytes == 0) ? 1 : bytes, block_alignment);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (block_size > m_chunk_size / 4){
+            size_t size = round_up_(block_size, huge_page_size);
+            munmap(ptr, size);
+            m_mapped_bytes -= size;
+            return;
+        }
+        // the block goes to the free list of the node of the freeing thread (usually the owner)
+        FreeBlock*& free_list = m_free_lists[{current_node_(), block_size}];
+        free_list = ::new (ptr) FreeBlock{free_list};
+    }
+
+    size_t mapped_bytes() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_mapped_bytes;
+    }
+
+    numa_policy policy() const {return m_policy;}
+
+    static const std::shared_ptr<hugepage_arena>& default_arena(){
+        static const std::shared_ptr<hugepage_arena> arena = std::make_shared<hugepage_arena>();
+        return arena;
+    }
+};
+
+
+
+/*
+    Allocator, backed by hugepage_arena; intended for the buckets of the big deques:
+
+        Farebl::deque<T, Farebl::hugepage_allocator<T>> d;
+
+        auto arena = std::make_shared<Farebl::hugepage_arena>(64 * 1024 * 1024, Farebl::numa_policy::local_preferred);
+        Farebl::deque<T, Farebl::hugepage_allocator<T>> d_local((Farebl::hugepage_allocator<T>(arena)));
+
+    The copies (and the rebound copies) of the allocator share the arena.
+*/
+template <typename T>
+class hugepage_allocator{
+    template <typename U>
+    friend class hugepage_allocator;
+
+    std::shared_ptr<hugepage_arena> m_arena;
+
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+
+    hugepage_allocator(): m_arena(hugepage_arena::default_arena()){}
+
+    explicit hugepage_allocator(std::shared_ptr<hugepage_arena> arena): m_arena(std::move(arena)){}
+
+    template <typename U>
+    hugepage_allocator(const hugepage_allocator<U>& other): m_arena(other.m_arena){}
+
+    T* allocate(size_t n){
+        static_assert(alignof(T) <= hugepage_arena::block_alignment, "The alignment of T is too big for hugepage_allocator");
+        return static_cast<T*>(m_arena->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t n){
+        m_arena->deallocate(ptr, n * sizeof(T));
+    }
+
+    const std::shared_ptr<hugepage_arena>& arena() const {return m_arena;}
+
+    template <typename U>
+    bool operator==(const hugepage_allocator<U>& other) const {return m_arena == other.m_arena;}
+
+    template <typename U>
+    bool operator!=(const hugepage_allocator<U>& other) const {return !(*this == other);}
+};
+
+} // end namespace Farebl
+#endif // FAREBL_HUGEPAGE_ALLOCATOR_H
@@ -0,0 +1,652 @@
+#ifndef FAREBL_INDEXED_LIST_H
+#define FAREBL_INDEXED_LIST_H
+
+
+
+#include <algorithm>         // for equal, lexicographical_compare, stable_sort
+#include <cstddef>           // for size_t, ptrdiff_t
+#include <cstdint>           // for uint32_t
+#include <functional>        // for less
+#include <initializer_list>  // for initializer_list
+#include <iterator>          // for bidirectional_iterator_tag, reverse_iterator
+#include <memory>            // for allocator_traits, allocator
+#include <type_traits>       // for conditional
+#include <utility>           // for forward, move, swap
+#include <vector>            // for vector
+
+namespace Farebl {
+
+/*
+    Farebl::list with the order-statistic index: besides prev/next every node is
+    the node of the implicit treap (the key is the position in the list, the subtree
+    sizes are kept in the nodes), so nth(k), index_of(it) and distance(a, b) are O(log n)
+    instead of O(n) with the bidirectional iterators.
+
+    The price is the node (3 pointers, the size and the priority more than in list)
+    and O(log n) (expected) for insert and erase instead of O(1). The nodes are never moved
+    or reallocated by the index: insert and erase keep the iterators and the references
+    to the other elements, as in list. sort() and reverse() rebuild the index in O(n).
+*/
+template<typename T, typename Allocator = std::allocator<T>>
+class indexed_list{
+    struct BaseNode{
+        BaseNode* prev;
+        BaseNode* next;
+        BaseNode(BaseNode* prev, BaseNode* next): prev(prev), next(next){}
+    };
+
+    struct Node: BaseNode{
+        Node* parent;
+        Node* left;
+        Node* right;
+        size_t subtree_size;
+        uint32_t priority;   // max-heap by the priority
+        T value;
+    };
+
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+
+    NodeAllocator alloc_;
+    BaseNode fake_node_;
+    Node* root_;
+    size_t sz_;
+    uint32_t priority_state_;
+
+    static size_t subtree_size_(const Node* node){return node ? node->subtree_size : 0;}
+
+    static void update_size_(Node* node){
+        node->subtree_size = subtree_size_(node->left) + subtree_size_(node->right) + 1;
+    }
+
+    // xorshift32
+    uint32_t next_priority_(){
+        priority_state_ ^= priority_state_ << 13;
+        priority_state_ ^= priority_state_ >> 17;
+        priority_state_ ^= priority_state_ << 5;
+        return priority_state_;
+    }
+
+    // (node) takes the place of its parent, the parent becomes its child
+    void rotate_up_(Node* node){
+        Node* parent = node->parent;
+        if (node == parent->left){
+            parent->left = node->right;
+            if (node->right) node->right->parent = parent;
+            node->right = parent;
+        }
+        else{
+            parent->right = node->left;
+            if (node->left) node->left->parent = parent;
+            node->left = parent;
+        }
+        node->parent = parent->parent;
+        if (node->parent == nullptr) root_ = node;
+        else if (node->parent->left == parent) node->parent->left = node;
+        else node->parent->right = node;
+        parent->parent = node;
+        update_size_(parent);
+        update_size_(node);
+    }
+
+    // (node) becomes the in-order predecessor of (pos) in the treap; called before the list links are changed
+    void attach_before_(Node* node, BaseNode* pos){
+        node->left = nullptr;
+        node->right = nullptr;
+        node->subtree_size = 1;
+        node->priority = next_priority_();
+        if (root_ == nullptr){
+            node->parent = nullptr;
+            root_ = node;
+            return;
+        }
+        Node* pos_node = (pos == &fake_node_) ? nullptr : static_cast<Node*>(pos);
+        if (pos_node != nullptr && pos_node->left == nullptr){
+            pos_node->left = node;
+            node->parent = pos_node;
+        }
+        else{
+            // the previous element is the rightmost node of the left subtree of (pos) (or of the whole treap)
+            Node* prev_node = static_cast<Node*>(pos->prev);
+            prev_node->right = node;
+            node->parent = prev_node;
+        }
+        for (Node* ancestor = node->parent; ancestor != nullptr; ancestor = ancestor->parent){
+            ++ancestor->subtree_size;
+        }
+        while (node->parent != nullptr && node->priority > node->parent->priority){
+            rotate_up_(node);
+        }
+    }
+
+    // (node) is rotated down to the leaf and cut off
+    void detach_(Node* node){
+        while (node->left != nullptr || node->right != nullptr){
+            bool left_up = node->right == nullptr || (node->left != nullptr && node->left->priority > node->right->priority);
+            rotate_up_(left_up ? node->left : node->right);
+        }
+        Node* parent = node->parent;
+        if (parent == nullptr) root_ = nullptr;
+        else if (parent->left == node) parent->left = nullptr;
+        else parent->right = nullptr;
+        for (; parent != nullptr; parent = parent->parent){
+            --parent->subtree_size;
+        }
+    }
+
+    // the recursion depth is the treap height: O(log n) expected
+    static size_t compute_sizes_(Node* node) noexcept {
+        if (node == nullptr) return 0;
+        node->subtree_size = compute_sizes_(node->left) + compute_sizes_(node->right) + 1;
+        return node->subtree_size;
+    }
+
+    /*
+        O(n): the treap of the current list order with the kept priorities (the cartesian tree).
+        The right spine of the built part is the stack: from the last node through the parents.
+    */
+    void rebuild_index_() noexcept {
+        root_ = nullptr;
+        Node* last = nullptr;
+        for (BaseNode* current = fake_node_.next; current != &fake_node_; current = current->next){
+            Node* node = static_cast<Node*>(current);
+            Node* popped = nullptr;
+            Node* top = last;
+            while (top != nullptr && top->priority < node->priority){
+                popped = top;
+                top = top->parent;
+            }
+            node->left = popped;
+            node->right = nullptr;
+            node->parent = top;
+            if (popped != nullptr) popped->parent = node;
+            if (top != nullptr) top->right = node;
+            else root_ = node;
+            last = node;
+        }
+        compute_sizes_(root_);
+    }
+
+    template<class... Args>
+    Node* create_node_(Args&&... args){
+        Node* new_node = std::allocator_traits<NodeAllocator>::allocate(alloc_, 1);
+        try{
+            std::allocator_traits<NodeAllocator>::construct(alloc_, &new_node->value, std::forward<Args>(args)...);
+        }
+        catch(...){
+            std::allocator_traits<NodeAllocator>::deallocate(alloc_, new_node, 1);
+            throw;
+        }
+        return new_node;
+    }
+
+    BaseNode* link_before_(BaseNode* pos_node, Node* new_node){
+        attach_before_(new_node, pos_node);
+        new_node->next = pos_node;
+        new_node->prev = pos_node->prev;
+        new_node->prev->next = new_node;
+        pos_node->prev = new_node;
+        ++sz_;
+        return new_node;
+    }
+
+    // takes the nodes of (other), which becomes empty; *this must be empty
+    void steal_nodes_(indexed_list& other){
+        if (other.sz_ != 0){
+            fake_node_.next = other.fake_node_.next;
+            fake_node_.prev = other.fake_node_.prev;
+            fake_node_.next->prev = &fake_node_;
+            fake_node_.prev->next = &fake_node_;
+        }
+        root_ = other.root_;
+        sz_ = other.sz_;
+        other.fake_node_.next = &other.fake_node_;
+        other.fake_node_.prev = &other.fake_node_;
+        other.root_ = nullptr;
+        other.sz_ = 0;
+    }
+
+    template<bool IsConst = false>
+    struct base_iterator{
+    private:
+        friend class Farebl::indexed_list<T, Allocator>;
+
+        using BaseNodePtr_t = typename std::conditional<IsConst, const BaseNode*, BaseNode*>::type;
+        using NodePtr_t = typename std::conditional<IsConst, const Node*, Node*>::type;
+
+        BaseNodePtr_t ptr_;
+        base_iterator(BaseNodePtr_t ptr):ptr_(ptr){}
+
+    public:
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = T;
+        using pointer           = typename std::conditional<IsConst, const T*, T*>::type;
+        using reference         = typename std::conditional<IsConst, const T&, T&>::type;
+        using iterator_category = std::bidirectional_iterator_tag;
+
+        base_iterator():ptr_(nullptr){}
+        base_iterator(const base_iterator& other) = default;
+        base_iterator& operator=(const base_iterator& other) = default;
+
+        reference operator*()const {
+            return static_cast<NodePtr_t>(ptr_)->value;
+        }
+
+        pointer operator->()const{
+            return &static_cast<NodePtr_t>(ptr_)->value;
+        }
+
+        base_iterator& operator++(){
+            ptr_ = ptr_->next;
+            return *this;
+        }
+        base_iterator operator++(int ){
+            base_iterator temp = *this;
+            ptr_ = ptr_->next;
+            return temp;
+        }
+        base_iterator& operator--(){
+            ptr_ = ptr_->prev;
+            return *this;
+        }
+        base_iterator operator--(int ){
+            base_iterator temp = *this;
+            ptr_ = ptr_->prev;
+            return temp;
+        }
+
+        template<bool OtherIsConst>
+        bool operator==(const base_iterator<OtherIsConst>& other) const {
+            return ptr_ == other.ptr_;
+        }
+        template<bool OtherIsConst>
+        bool operator!=(const base_iterator<OtherIsConst>& other) const {
+            return !(ptr_ == other.ptr_);
+        }
+
+        operator base_iterator<true>() const {return {ptr_};}
+    };
+
+public:
+
+    // size of the single allocation, made by the list for every element
+    static constexpr size_t node_size = sizeof(Node);
+
+    using value_type      = T;
+    using allocator_type  = Allocator;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference       = value_type&;
+    using const_reference = const value_type&;
+    using pointer         = typename std::allocator_traits<Allocator>::pointer;
+    using const_pointer   = typename std::allocator_traits<Allocator>::const_pointer;
+
+    using iterator               = base_iterator<false>;
+    using const_iterator         = base_iterator<true>;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+
+
+    indexed_list(): indexed_list(Allocator()){}
+
+    explicit indexed_list(const Allocator& alloc)
+        : alloc_(alloc)
+        , fake_node_(&fake_node_, &fake_node_)
+        , root_(nullptr)
+        , sz_(0)
+        , priority_state_(0x9E3779B9u)
+    {}
+
+    indexed_list(size_t count, const T& value, const Allocator& alloc = Allocator())
+        : indexed_list(alloc)
+    {
+        insert(cend(), count, value);
+    }
+
+    template <typename InputIt, typename = decltype(*std::declval<InputIt&>(), ++std::declval<InputIt&>())>
+    indexed_list(InputIt first, InputIt last, const Allocator& alloc = Allocator())
+        : indexed_list(alloc)
+    {
+        insert(cend(), first, last);
+    }
+
+    indexed_list(std::initializer_list<T> init_list, const Allocator& alloc = Allocator())
+        : indexed_list(alloc)
+    {
+        insert(cend(), init_list.begin(), init_list.end());
+    }
+
+    indexed_list(const indexed_list& other)
+        : indexed_list(std::allocator_traits<NodeAllocator>::select_on_container_copy_construction(other.get_allocator()))
+    {
+        insert(cend(), other.begin(), other.end());
+    }
+
+    indexed_list(indexed_list&& other)
+        : indexed_list(other.get_allocator())
+    {
+        steal_nodes_(other);
+    }
+
+    ~indexed_list() {
+        clear();
+    }
+
+    // copy-and-swap: the allocators are expected to be equal (or to propagate on swap)
+    indexed_list& operator=(const indexed_list& other) & {
+        if (this != &other){
+            indexed_list temp(other);
+            swap(temp);
+        }
+        return *this;
+    }
+
+    indexed_list& operator=(indexed_list&& other) & {
+        if (this != &other){
+            clear();
+            steal_nodes_(other);
+        }
+        return *this;
+    }
+
+    indexed_list& operator=(std::initializer_list<T> init_list) & {
+        indexed_list temp(init_list, get_allocator());
+        swap(temp);
+        return *this;
+    }
+
+    Allocator get_allocator() const {return Allocator(alloc_);}
+
+
+
+    reference front(){return *begin();}
+    const_reference front() const {return *cbegin();}
+
+    reference back(){return *(--end());}
+    const_reference back() const {return *(--cend());}
+
+
+
+    iterator begin(){return {fake_node_.next};}
+    iterator end(){return {&fake_node_};}
+
+    const_iterator begin() const {return {fake_node_.next};}
+    const_iterator end() const {return {&fake_node_};}
+
+    const_iterator cbegin() const noexcept {return {fake_node_.next};}
+    const_iterator cend() const noexcept {return {&fake_node_};}
+
+    reverse_iterator rbegin(){return reverse_iterator(end());}
+    reverse_iterator rend(){return reverse_iterator(begin());}
+
+    const_reverse_iterator rbegin() const {return const_reverse_iterator(cend());}
+    const_reverse_iterator rend() const {return const_reverse_iterator(cbegin());}
+
+    const_reverse_iterator crbegin() const noexcept {return const_reverse_iterator(cend());}
+    const_reverse_iterator crend() const noexcept {return const_reverse_iterator(cbegin());}
+
+
+    bool empty() const {return sz_ == 0;}
+
+    size_t size() const {return sz_;}
+
+    // bytes of the nodes (without sizeof(indexed_list) and the bookkeeping of the allocator)
+    size_t memory_usage() const {return sz_ * sizeof(Node);}
+
+
+
+    // O(log n): the iterator to the element at the position (k); end() for k >= size()
+    iterator nth(size_type k){
+        return {const_cast<BaseNode*>(static_cast<const indexed_list*>(this)->nth(k).ptr_)};
+    }
+
+    const_iterator nth(size_type k) const {
+        if (k >= sz_) return cend();
+        const Node* node = root_;
+        while (true){
+            size_t left_size = subtree_size_(node->left);
+            if (k < left_size){
+                node = node->left;
+            }
+            else if (k == left_size){
+                return {node};
+            }
+            else{
+                k -= left_size + 1;
+                node = node->right;
+            }
+        }
+    }
+
+    // O(log n): the position of the element (size() for end())
+    size_type index_of(const_iterator it) const {
+        if (it.ptr_ == &fake_node_) return sz_;
+        const Node* node = static_cast<const Node*>(it.ptr_);
+        size_t index = subtree_size_(node->left);
+        for (; node->parent != nullptr; node = node->parent){
+            if (node == node->parent->right) index += subtree_size_(node->parent->left) + 1;
+        }
+        return index;
+    }
+
+    // O(log n): std::distance(first, last) for the iterators of this list
+    difference_type distance(const_iterator first, const_iterator last) const {
+        return static_cast<difference_type>(index_of(last)) - static_cast<difference_type>(index_of(first));
+    }
+
+
+
+    void clear(){
+        BaseNode* current = fake_node_.next;
+        while (current != &fake_node_){
+            Node* node = static_cast<Node*>(current);
+            current = current->next;
+            std::allocator_traits<NodeAllocator>::destroy(alloc_, &node->value);
+            std::allocator_traits<NodeAllocator>::deallocate(alloc_, node, 1);
+        }
+        fake_node_.next = &fake_node_;
+        fake_node_.prev = &fake_node_;
+        root_ = nullptr;
+        sz_ = 0;
+    }
+
+
+    template<class... Args>
+    iterator emplace(const_iterator pos, Args&&... args){
+        Node* new_node = create_node_(std::forward<Args>(args)...);
+        /*
+            Using of the const_cast<T*>(const T*) there is never UB here,
+            because at the memory level all elements are non-constant.
+        */
+        return {link_before_(const_cast<BaseNode*>(pos.ptr_), new_node)};
+    }
+
+    iterator insert(const_iterator pos, const T& value){return emplace(pos, value);}
+
+    iterator insert(const_iterator pos, T&& value){return emplace(pos, std::move(value));}
+
+    // the elements, inserted before the exception, stay in the list
+    iterator insert(const_iterator pos, size_type count, const T& value){
+        iterator result(const_cast<BaseNode*>(pos.ptr_));
+        for (size_type i = 0; i < count; ++i){
+            iterator inserted = emplace(pos, value);
+            if (i == 0) result = inserted;
+        }
+        return result;
+    }
+
+    template<class InputIt>
+    iterator insert(const_iterator pos, InputIt first, InputIt last){
+        iterator result(const_cast<BaseNode*>(pos.ptr_));
+        bool is_first = true;
+        for (; first != last; ++first){
+            iterator inserted = emplace(pos, *first);
+            if (is_first) {result = inserted; is_first = false;}
+        }
+        return result;
+    }
+
+    iterator insert(const_iterator pos, std::initializer_list<T> init_list){
+        return insert(pos, init_list.begin(), init_list.end());
+    }
+
+    iterator erase(const_iterator pos){
+        if (pos == cend()) return end();
+        Node* delete_node = static_cast<Node*>(const_cast<BaseNode*>(pos.ptr_));
+        BaseNode* delete_node_next = delete_node->next;
+        detach_(delete_node);
+        delete_node->prev->next = delete_node->next;
+        delete_node->next->prev = delete_node->prev;
+        std::allocator_traits<NodeAllocator>::destroy(alloc_, &delete_node->value);
+        std::allocator_traits<NodeAllocator>::deallocate(alloc_, delete_node, 1);
+        --sz_;
+        return {delete_node_next};
+    }
+
+    iterator erase(const_iterator first, const_iterator last){
+        while (first != last) first = erase(first);
+        return {const_cast<BaseNode*>(last.ptr_)};
+    }
+
+
+    void push_back(const T& value){emplace(cend(), value);}
+    void push_back(T&& value){emplace(cend(), std::move(value));}
+
+    template<class... Args>
+    reference emplace_back(Args&&... args){return *emplace(cend(), std::forward<Args>(args)...);}
+
+    void pop_back(){
+        if (sz_ == 0) return;
+        erase(--cend());
+    }
+
+    void push_front(const T& value){emplace(cbegin(), value);}
+    void push_front(T&& value){emplace(cbegin(), std::move(value));}
+
+    template<class... Args>
+    reference emplace_front(Args&&... args){return *emplace(cbegin(), std::forward<Args>(args)...);}
+
+    void pop_front(){
+        if (sz_ == 0) return;
+        erase(cbegin());
+    }
+
+    void swap(indexed_list& other) noexcept {
+        indexed_list* lists[2] = {this, &other};
+        BaseNode* firsts[2];
+        BaseNode* lasts[2];
+        for (int i = 0; i < 2; ++i){
+            firsts[i] = lists[i]->sz_ ? lists[i]->fake_node_.next : nullptr;
+            lasts[i] = lists[i]->sz_ ? lists[i]->fake_node_.prev : nullptr;
+        }
+        for (int i = 0; i < 2; ++i){
+            BaseNode& fake = lists[i]->fake_node_;
+            int j = 1 - i;
+            if (firsts[j] == nullptr){
+                fake.next = &fake;
+                fake.prev = &fake;
+            }
+            else{
+                fake.next = firsts[j];
+                fake.prev = lasts[j];
+                firsts[j]->prev = &fake;
+                lasts[j]->next = &fake;
+            }
+        }
+        std::swap(root_, other.root_);
+        std::swap(sz_, other.sz_);
+        std::swap(priority_state_, other.priority_state_);
+        if constexpr(std::allocator_traits<NodeAllocator>::propagate_on_container_swap::value){
+            std::swap(alloc_, other.alloc_);
+        }
+    }
+
+
+    size_type remove(const T& value){
+        return remove_if([&value](const T& element){return element == value;});
+    }
+
+    template< class UnaryPred >
+    size_type remove_if( UnaryPred p ){
+        size_type removed = 0;
+        const_iterator it = cbegin();
+        while (it != cend()){
+            if (p(*it)){
+                it = erase(it);
+                ++removed;
+            }
+            else{
+                ++it;
+            }
+        }
+        return removed;
+    }
+
+    void reverse() noexcept {
+        BaseNode* current = &fake_node_;
+        do{
+            std::swap(current->prev, current->next);
+            current = current->prev;
+        } while (current != &fake_node_);
+        rebuild_index_();
+    }
+
+    void sort(){sort(std::less<T>());}
+
+    // stable: the nodes are relinked (the elements aren't moved), the index is rebuilt in O(n)
+    template<class Compare>
+    void sort(Compare comp){
+        if (sz_ < 2) return;
+        std::vector<Node*> nodes;
+        nodes.reserve(sz_);
+        for (BaseNode* current = fake_node_.next; current != &fake_node_; current = current->next){
+            nodes.push_back(static_cast<Node*>(current));
+        }
+        std::stable_sort(nodes.begin(), nodes.end(), [&comp](const Node* lhs, const Node* rhs){
+            return comp(lhs->value, rhs->value);
+        });
+        BaseNode* prev = &fake_node_;
+        for (Node* node: nodes){
+            prev->next = node;
+            node->prev = prev;
+            prev = node;
+        }
+        prev->next = &fake_node_;
+        fake_node_.prev = prev;
+        rebuild_index_();
+    }
+};
+
+
+template<typename T, typename Allocator>
+bool operator==(const indexed_list<T, Allocator>& lhs, const indexed_list<T, Allocator>& rhs){
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template<typename T, typename Allocator>
+bool operator!=(const indexed_list<T, Allocator>& lhs, const indexed_list<T, Allocator>& rhs){
+    return !(lhs == rhs);
+}
+
+template<typename T, typename Allocator>
+bool operator<(const indexed_list<T, Allocator>& lhs, const indexed_list<T, Allocator>& rhs){
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template<typename T, typename Allocator>
+bool operator>(const indexed_list<T, Allocator>& lhs, const indexed_list<T, Allocator>& rhs){
+    return (rhs < lhs);
+}
+
+template<typename T, typename Allocator>
+bool operator<=(const indexed_list<T, Allocator>& lhs, const indexed_list<T, Allocator>& rhs){
+    return !(rhs < lhs);
+}
+
+template<typename T, typename Allocator>
+bool operator>=(const indexed_list<T, Allocator>& lhs, const indexed_list<T, Allocator>& rhs){
+    return !(lhs < rhs);
+}
+
+} // end namespace Farebl
+#endif // FAREBL_INDEXED_LIST_H
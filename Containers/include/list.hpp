@@ -3,18 +3,25 @@
 
 
 
+#include <algorithm>         // for copy, min, sort, upper_bound
 #include <cstddef>           // for size_t, ptrdiff_t
+#include <exception>         // for exception_ptr, current_exception, rethrow_exception
+#include <functional>        // for less, ref
 #include <initializer_list>  // for initializer_list
-#include <iterator>          // for make_reverse_iterator, reverse_iterator
+#include <iterator>          // for make_move_iterator, make_reverse_iterator, reverse_iterator
 #include <limits>            // for numeric_limits
 #include <memory>            // for allocator_traits, allocator
+#include <thread>            // for thread, hardware_concurrency
 #include <type_traits>       // for conditional
 #include <utility>           // for forward
+#include <vector>            // for vector
+
+#include "container_stats.hpp"  // for container_stats, stats_detail::counters
 
 namespace Farebl {
 
 template<typename T, typename Allocator = std::allocator<T>>
-class list{
+class list: private stats_detail::counters<>{
     struct BaseNode{
         BaseNode* prev;
         BaseNode* next;
@@ -27,9 +34,103 @@ class list{
 
     using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
     
+    // array of the nodes, allocated by defragment() by one allocation
+    struct NodeBlock{
+        Node* nodes;
+        size_t capacity;
+        size_t live_count; // the block is deallocated, when its last node is freed
+    };
+
+    /*
+        The blocks of defragment(), sorted by the address; [lowest, highest_end) covers
+        all of them, so the node outside of it is freed without the search.
+        It exists only while some block is alive (the list without defragment() pays
+        one null pointer for it), and it is allocated by the allocator of the list.
+    */
+    struct NodeBlocks{
+        NodeBlock* blocks;
+        size_t count;
+        size_t capacity; // of the array (blocks)
+        const Node* lowest;
+        const Node* highest_end;
+    };
+
+    using NodeBlockAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<NodeBlock>;
+    using NodeBlocksAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<NodeBlocks>;
+
     NodeAllocator alloc_;
     BaseNode fake_node_;
     size_t sz_;
+    NodeBlocks* node_blocks_ = nullptr;
+
+    // all the node allocations of the list pass here (for the counters of container_stats.hpp)
+    Node* allocate_node_(){
+        Node* node = std::allocator_traits<NodeAllocator>::allocate(alloc_, 1);
+        count_allocation_(sizeof(Node));
+        return node;
+    }
+
+    // the node of the block isn't deallocated alone: the block is freed with its last node
+    void deallocate_node_(Node* node){
+        if (
+            node_blocks_ != nullptr
+                &&
+            !std::less<const Node*>()(node, node_blocks_->lowest)
+                &&
+            std::less<const Node*>()(node, node_blocks_->highest_end)
+        ){
+            NodeBlock* first = node_blocks_->blocks;
+            NodeBlock* last = first + node_blocks_->count;
+            NodeBlock* it = std::upper_bound(first, last, node, [](const Node* ptr, const NodeBlock& block){
+                return std::less<const Node*>()(ptr, block.nodes);
+            });
+            if (it != first){
+                --it;
+                if (std::less<const Node*>()(node, it->nodes + it->capacity)){
+                    if (--it->live_count == 0){
+                        std::allocator_traits<NodeAllocator>::deallocate(alloc_, it->nodes, it->capacity);
+                        std::copy(it + 1, last, it);
+                        node_block_removed_();
+                    }
+                    return;
+                }
+            }
+        }
+        std::allocator_traits<NodeAllocator>::deallocate(alloc_, node, 1);
+    }
+
+    // after a block is removed from the array: the range is narrowed, the last block frees the bookkeeping
+    void node_block_removed_(){
+        NodeBlocks& blocks = *node_blocks_;
+        if (--blocks.count != 0){
+            blocks.lowest = blocks.blocks[0].nodes;
+            blocks.highest_end = blocks.blocks[blocks.count - 1].nodes + blocks.blocks[blocks.count - 1].capacity;
+            return;
+        }
+        NodeBlockAllocator block_alloc(alloc_);
+        NodeBlocksAllocator blocks_alloc(alloc_);
+        std::allocator_traits<NodeBlockAllocator>::deallocate(block_alloc, blocks.blocks, blocks.capacity);
+        std::allocator_traits<NodeBlocksAllocator>::deallocate(blocks_alloc, node_blocks_, 1);
+        node_blocks_ = nullptr;
+    }
+
+    // takes the nodes (and the blocks of defragment) of (other), which becomes empty; *this must be empty
+    void steal_nodes_(list& other){
+        if (other.sz_ != 0){
+            fake_node_.next = other.fake_node_.next;
+            fake_node_.prev = other.fake_node_.prev;
+            fake_node_.next->prev = &fake_node_;
+            fake_node_.prev->next = &fake_node_;
+        }
+        sz_ = other.sz_;
+        other.fake_node_.next = &other.fake_node_;
+        other.fake_node_.prev = &other.fake_node_;
+        other.sz_ = 0;
+        std::swap(node_blocks_, other.node_blocks_);
+    }
+
+    // size of the blocks of defragment(): 1 MiB of the nodes
+    static constexpr size_t defragment_block_nodes_ = ((size_t(1) << 20) / sizeof(Node) > 0) ? (size_t(1) << 20) / sizeof(Node) : 1;
 
     template<bool IsConst = false>
     struct base_iterator{
@@ -64,7 +165,7 @@ class list{
             ptr_ = ptr_->next;
             return *this;
         }
-        base_iterator& operator++(int ){ 
+        base_iterator operator++(int ){ 
             base_iterator temp = *this;
             ptr_ = ptr_->next;
             return temp;
@@ -73,7 +174,7 @@ class list{
             ptr_ = ptr_->prev;
             return *this;
         }
-        base_iterator& operator--(int ){ 
+        base_iterator operator--(int ){ 
             base_iterator temp = *this;
             ptr_ = ptr_->prev;
             return temp;
@@ -94,6 +195,12 @@ class list{
 
 public:
 
+    // size of the single allocation, made by the list for every element
+    static constexpr size_t node_size = sizeof(Node);
+
+    // bytes of the node, which aren't the element: the links and the padding
+    static constexpr size_t node_overhead = sizeof(Node) - sizeof(T);
+
     using value_type	  = T;
     using allocator_type  = Allocator;
     using size_type       = std::size_t;
@@ -127,7 +234,7 @@ public:
         , fake_node_(&fake_node_, &fake_node_)
         , sz_(0)    
     {
-        insert(begin(), T(), count);
+        insert(cbegin(), count, T());
     }
     
     explicit list(size_t count, const T& value, const Allocator& alloc = Allocator()) 
@@ -149,7 +256,8 @@ public:
     }
 
     list(const list& other) 
-        : alloc_(std::allocator_traits<NodeAllocator>::select_on_container_copy_construction(other.get_allocator()))
+        : counters()    // the counters of the copy start from zero
+        , alloc_(std::allocator_traits<NodeAllocator>::select_on_container_copy_construction(other.get_allocator()))
         , fake_node_(&fake_node_, &fake_node_)  
         , sz_(0)
     {
@@ -160,17 +268,9 @@ public:
     list(list&& other) 
         : alloc_(std::move(other.get_allocator()))
         , fake_node_(&fake_node_, &fake_node_)  
-        , sz_(other.sz_)
+        , sz_(0)
     {
-        fake_node_.next = other.fake_node_.next;
-        fake_node_.prev = other.fake_node_.prev;
-         
-        fake_node_.next->prev = &fake_node_;
-        fake_node_.prev->next = &fake_node_;
-
-        other.fake_node_.next = nullptr;
-        other.fake_node_.prev = nullptr;
-        other.sz_ = 0;
+        steal_nodes_(other);
     }
 
     
@@ -183,20 +283,18 @@ public:
     }
    
 
+    // the nodes are taken only with the equal allocator, else the elements are moved into the new nodes
     list(list&& other, const Allocator& alloc) 
         : alloc_(alloc)
         , fake_node_(&fake_node_, &fake_node_)  
-        , sz_(other.sz_)
+        , sz_(0)
     {
-        fake_node_.next = other.fake_node_.next;
-        fake_node_.prev = other.fake_node_.prev;
-         
-        fake_node_.next->prev = &fake_node_;
-        fake_node_.prev->next = &fake_node_;
-
-        other.fake_node_.next = &other.fake_node_;
-        other.fake_node_.prev = &other.fake_node_;
-        other.sz_ = 0;
+        if (std::allocator_traits<NodeAllocator>::is_always_equal::value || alloc_ == other.alloc_){
+            steal_nodes_(other);
+        }
+        else{
+            insert(cend(), std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+        }
     }
 
 
@@ -217,114 +315,54 @@ public:
 
 
 
+    /*
+        The allocator is assigned only when it propagates (polymorphic_allocator,
+        for example, can't be assigned at all). The elements of (other) are assigned
+        into the existing nodes, the rest of the nodes are inserted or erased; when
+        the propagating allocator differs, the copy is made by the new allocator first.
+    */
     list& operator=(const list& other) & {
         if (this == &other) return *this;
-        
-        NodeAllocator new_alloc = std::allocator_traits<NodeAllocator>::propagate_on_container_copy_assignment::value
-           ?  NodeAllocator(other.get_allocator()) : alloc_;
-        
-        if constexpr (std::allocator_traits<NodeAllocator>::is_always_equal::value){
-            alloc_ = new_alloc;
-            assign(other.begin(), other.end());
-        }
-        else{
-            if(alloc_ == new_alloc){
-                alloc_ = new_alloc;
-                assign(other.begin(), other.end());
-            }
-            else{
-                //for strong exception safety using copy-and-swap idiom 
-                if constexpr(std::allocator_traits<NodeAllocator>::propagate_on_container_swap::value){
-                    list temp(other, new_alloc);
-                    swap(temp);
-                }
-                else{
-                    list temp(other, new_alloc);
-                    swap(temp);
-                    alloc_ = new_alloc;
-                }
-                /*
-                    When implementing a basic exception guarantee (for best performance), a problem arises: 
-                when propagate_on_copy_assignment::value == true and alloc_ != new_alloc 
-                we have to allocate new elements with a new allocator, but in order to 
-                preserve the old allocator (we need it to clean up old data), the operation 
-                of replacing the current allocator with a new one (alloc_ = new_alloc) is 
-                postponed to the end of the assignment operation.
-                    But if an exception occurs during the element-by-element replacement of 
-                elements, the current list ends up in a heterogeneous state: some elements 
-                are created by the new allocator, and the rest by the old one. At the same 
-                time, the current allocator has not yet been updated. This leads to the fact 
-                that when cleaning up the current list, those elements that were deleted by 
-                the new allocator (new_alloc) will try to be cleaned up by the old allocator 
-                (alloc_). As mentioned above, alloc_ != new_alloc, so we expect a memory leak 
-                or (UB).
-                */
+
+        if constexpr (std::allocator_traits<NodeAllocator>::propagate_on_container_copy_assignment::value){
+            if (!std::allocator_traits<NodeAllocator>::is_always_equal::value && alloc_ != other.alloc_){
+                list temp(other, other.get_allocator());
+                clear();
+                alloc_ = other.alloc_;
+                steal_nodes_(temp);
+                return *this;
             }
+            alloc_ = other.alloc_;
         }
+        assign(other.begin(), other.end());
         return *this;
     }
 
-    list& operator=(list&& other) & noexcept(noexcept(std::allocator_traits<NodeAllocator>::is_always_equal::value)) {
+    list& operator=(list&& other) & noexcept(
+        std::allocator_traits<NodeAllocator>::propagate_on_container_move_assignment::value
+            ||
+        std::allocator_traits<NodeAllocator>::is_always_equal::value
+    ){
         if (this == &other) return *this;
-        
-        NodeAllocator new_alloc = std::allocator_traits<NodeAllocator>::propagate_on_container_move_assignment::value  
-           ?  NodeAllocator(other.get_allocator()) : alloc_;
-        
-        if constexpr (std::allocator_traits<NodeAllocator>::is_always_equal::value){
-            clear();
-            alloc_ = new_alloc;
-            fake_node_.next = other.fake_node_.next;
-            fake_node_.prev = other.fake_node_.prev;
-            fake_node_.next->prev = &fake_node_;
-            fake_node_.prev->next = &fake_node_;
-            sz_ = other.sz_;
 
-            other.fake_node_.next = &other.fake_node_;
-            other.fake_node_.prev = &other.fake_node_;
-            other.sz_ = 0;
+        if (
+            std::allocator_traits<NodeAllocator>::propagate_on_container_move_assignment::value
+                ||
+            std::allocator_traits<NodeAllocator>::is_always_equal::value
+                ||
+            alloc_ == other.alloc_
+        ){
+            clear();
+            if constexpr (std::allocator_traits<NodeAllocator>::propagate_on_container_move_assignment::value){
+                alloc_ = other.alloc_;
+            }
+            steal_nodes_(other);
         }
         else{
-            if(alloc_ == new_alloc){
-                clear();
-                alloc_ = new_alloc;
-                fake_node_.next = other.fake_node_.next;
-                fake_node_.prev = other.fake_node_.prev;
-                fake_node_.next->prev = &fake_node_;
-                fake_node_.prev->next = &fake_node_;
-
-                sz_ = other.sz_;
-
-                other.fake_node_.next = nullptr;
-                other.fake_node_.prev = nullptr;
-                other.sz_ = 0;
-            }
-            else{ 
-                //for strong exception safety using copy-and-swap idiom 
-                if constexpr(std::allocator_traits<NodeAllocator>::propagate_on_container_swap::value){
-                    list temp(std::move(other), new_alloc);
-                    swap(temp);
-                }
-                else{
-                    list temp(std::move(other), new_alloc);
-                    swap(temp);
-                    alloc_ = new_alloc;
-                }
-
-                /*
-                When implementing the basic exception guarantee (for the best performance),
-                the same problem arises as with operator=(copy): if an exception occurs 
-                during element-by-element replacement of elements, the current list enters 
-                a heterogeneous state: some elements are created by the new allocator, and 
-                the rest by the old one. At the same time, the current allocator has not 
-                yet been updated. This leads to the fact that when cleaning up the current 
-                list, those elements that were removed by the new allocator (new_alloc) 
-                will try to be cleaned up by the old allocator (alloc_), while 
-                alloc_ != new_alloc, so we expect a memory leak or (UB).
-                */
-            } 
-        }
-       return *this;
-        
+            // the allocators differ and don't propagate: the elements are moved into the own nodes
+            assign(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+        }
+        return *this;
     }
 
     list& operator=(std::initializer_list<T> init_list) & {
@@ -334,47 +372,32 @@ public:
     
 
     void assign(size_t count, const T& value){
-        if (count == 0){
-            clear();
-            return;
-        }
-        
         BaseNode* current_node = fake_node_.next;
-        if(count <= sz_){
-            for (int i = 0; i<count; ++i){
-                static_cast<Node*>(current_node)->value = value;
-                current_node = current_node->next;
-            } 
-            erase(current_node, cend());
+        for (; count != 0 && current_node != &fake_node_; --count){
+            static_cast<Node*>(current_node)->value = value;
+            current_node = current_node->next;
+        }
+        if (count != 0){
+            insert(cend(), count, value);
         }
         else{
-            for (int i = 0; i<sz_; ++i){
-                static_cast<Node*>(current_node)->value = value;
-                current_node = current_node->next;
-            }
-            current_node = current_node->prev;
-            insert(current_node, count-sz_, value);
+            erase(current_node, cend());
         }
     }
     
     template< class InputIt>
     void assign(InputIt first, InputIt last){
-        if (first == last){return;}
-        
-        InputIt current_other_it = first;
         BaseNode* current_node = fake_node_.next;
-        while (current_node != &fake_node_ && current_other_it != last){
-            static_cast<Node*>(current_node)->value = *current_other_it;
-
+        for (; first != last && current_node != &fake_node_; ++first){
+            static_cast<Node*>(current_node)->value = *first;
             current_node = current_node->next;
-            ++current_other_it;
-        } 
-        if (current_node == &fake_node_){
-            insert(current_node->prev, current_other_it, last);
+        }
+        if (first != last){
+            insert(cend(), first, last);
         }
         else{
             erase(current_node, cend());
-        }        
+        }
     }
 
 
@@ -411,19 +434,41 @@ public:
     automatically shifts the iterator so that it points to an element that matches the 
     logic of the reverse iterator.
     */
-    reverse_iterator rbegin(){return std::make_reverse_iterator(begin());}
-    reverse_iterator rend(){return std::make_reverse_iterator(end());}
+    reverse_iterator rbegin(){return std::make_reverse_iterator(end());}
+    reverse_iterator rend(){return std::make_reverse_iterator(begin());}
     
-    const_reverse_iterator rbegin() const {return std::make_reverse_iterator(cbegin());}
-    const_reverse_iterator rend() const {return std::make_reverse_iterator(cend());}
+    const_reverse_iterator rbegin() const {return std::make_reverse_iterator(cend());}
+    const_reverse_iterator rend() const {return std::make_reverse_iterator(cbegin());}
     
-    const_reverse_iterator crbegin() const noexcept {return std::make_reverse_iterator(cbegin());}
-    const_reverse_iterator crend() const noexcept {return std::make_reverse_iterator(cend());}
+    const_reverse_iterator crbegin() const noexcept {return std::make_reverse_iterator(cend());}
+    const_reverse_iterator crend() const noexcept {return std::make_reverse_iterator(cbegin());}
 
 
     bool empty() const {return sz_ == 0;}
     
     size_t size() const {return sz_;}
+
+    // the counters of container_stats.hpp (zeros without FAREBL_CONTAINER_STATS)
+    container_stats stats() const {return counters_snapshot_(sz_);}
+
+    /*
+        Bytes of the nodes (without sizeof(list) and the bookkeeping of the allocator).
+        The blocks of defragment() are counted whole with their array: the erased nodes
+        of a block stay allocated until its last node is freed.
+    */
+    size_t memory_usage() const {
+        if (node_blocks_ == nullptr) {return sz_ * sizeof(Node);}
+        size_t block_nodes = 0;
+        size_t live_block_nodes = 0;
+        for (size_t k = 0; k < node_blocks_->count; ++k){
+            block_nodes += node_blocks_->blocks[k].capacity;
+            live_block_nodes += node_blocks_->blocks[k].live_count;
+        }
+        return (sz_ - live_block_nodes + block_nodes) * sizeof(Node)
+            + sizeof(NodeBlocks) + node_blocks_->capacity * sizeof(NodeBlock);
+    }
+
+    size_t overhead_bytes() const {return sz_ * node_overhead;}
     
     long max_size() const{return std::numeric_limits<difference_type>::max();}
 
@@ -433,12 +478,12 @@ public:
 
     iterator insert(const_iterator pos, const T& value){
         Node* new_node = nullptr; 
-        new_node = std::allocator_traits<NodeAllocator>::allocate(alloc_, 1);
+        new_node = allocate_node_();
         try{
             std::allocator_traits<NodeAllocator>::construct(alloc_, &new_node->value, value);
         }
         catch(...){
-            std::allocator_traits<NodeAllocator>::deallocate(alloc_, new_node, 1);
+            deallocate_node_(new_node);
             throw;
         }    
         /*
@@ -454,18 +499,19 @@ public:
         pos_node->prev = new_node;
 
         ++sz_;
+        count_size_(sz_);
         return {new_node};
     }
 
     
     iterator insert(const_iterator pos, T&& value){
         Node* new_node = nullptr; 
-        new_node = std::allocator_traits<NodeAllocator>::allocate(alloc_, 1);
+        new_node = allocate_node_();
         try{
             std::allocator_traits<NodeAllocator>::construct(alloc_, &new_node->value, std::move(value));
         }
         catch(...){
-            std::allocator_traits<NodeAllocator>::deallocate(alloc_, new_node, 1);
+            deallocate_node_(new_node);
             throw;
         }    
         /*
@@ -481,6 +527,7 @@ public:
         pos_node->prev = new_node;
 
         ++sz_;
+        count_size_(sz_);
         return {new_node};
     }
 
@@ -490,13 +537,13 @@ public:
 
         BaseNode* first_new_node = nullptr;
         size_t inserted_count = 0;
-        first_new_node = std::allocator_traits<NodeAllocator>::allocate(alloc_, 1);
+        first_new_node = allocate_node_();
         
         try{
             std::allocator_traits<NodeAllocator>::construct(alloc_, &static_cast<Node*>(first_new_node)->value, value);
         }
         catch(...){
-            std::allocator_traits<NodeAllocator>::deallocate(alloc_, static_cast<Node*>(first_new_node), 1);
+            deallocate_node_(static_cast<Node*>(first_new_node));
             throw;
         } 
         
@@ -505,13 +552,13 @@ public:
         BaseNode* last_new_node = first_new_node;
         try{
             for(; inserted_count != count; ++inserted_count){
-                last_new_node->next = std::allocator_traits<NodeAllocator>::allocate(alloc_, 1);
+                last_new_node->next = allocate_node_();
                 try{
                     /*The Node::prev and Node::next elements are of type (BaseNode*).*/
                     std::allocator_traits<NodeAllocator>::construct(alloc_, &static_cast<Node*>(last_new_node->next)->value, value);
                 }
                 catch(...){
-                    std::allocator_traits<NodeAllocator>::deallocate(alloc_, static_cast<Node*>(last_new_node->next), 1);
+                    deallocate_node_(static_cast<Node*>(last_new_node->next));
                     throw;
                 }
                 last_new_node->next->prev = last_new_node;
@@ -523,19 +570,19 @@ public:
                 last_new_node = last_new_node->prev;
                 std::allocator_traits<NodeAllocator>::destroy(alloc_, static_cast<Node*>(last_new_node->next));
                 /*The Node::prev and Node::next elements are of type (BaseNode*).*/
-                std::allocator_traits<NodeAllocator>::deallocate(alloc_, static_cast<Node*>(last_new_node->next), 1);
+                deallocate_node_(static_cast<Node*>(last_new_node->next));
                 --inserted_count;
             }
 
             //Removing the second new node
             if(inserted_count == 2){
                 std::allocator_traits<NodeAllocator>::destroy(alloc_, static_cast<Node*>(first_new_node->next));
-                std::allocator_traits<NodeAllocator>::deallocate(alloc_, static_cast<Node*>(first_new_node->next), 1); 
+                deallocate_node_(static_cast<Node*>(first_new_node->next)); 
             }
 
             //Removing the first new node
             std::allocator_traits<NodeAllocator>::destroy(alloc_, static_cast<Node*>(first_new_node));
-            std::allocator_traits<NodeAllocator>::deallocate(alloc_,static_cast<Node*>( first_new_node), 1); 
+            deallocate_node_(static_cast<Node*>( first_new_node)); 
             
             throw;
         }
@@ -552,6 +599,7 @@ public:
         pos_node->prev = last_new_node;
 
         sz_+=inserted_count;
+        count_size_(sz_);
         return {first_new_node};
     }   
 
@@ -563,12 +611,12 @@ public:
         BaseNode* first_new_node = nullptr;
         size_t inserted_count = 0;
         
-        first_new_node = std::allocator_traits<NodeAllocator>::allocate(alloc_, 1);
+        first_new_node = allocate_node_();
         try{
             std::allocator_traits<NodeAllocator>::construct(alloc_, &static_cast<Node*>(first_new_node)->value, *current_other_it);
         }
         catch(...){
-            std::allocator_traits<NodeAllocator>::deallocate(alloc_, static_cast<Node*>(first_new_node), 1);
+            deallocate_node_(static_cast<Node*>(first_new_node));
             throw;
         } 
         
@@ -578,13 +626,13 @@ public:
         BaseNode* last_new_node = first_new_node;
         try{
             while(current_other_it != last){
-                last_new_node->next = std::allocator_traits<NodeAllocator>::allocate(alloc_, 1);
+                last_new_node->next = allocate_node_();
                 try{
                     /*The Node::prev and Node::next elements are of type (BaseNode*).*/
                     std::allocator_traits<NodeAllocator>::construct(alloc_, &static_cast<Node*>(last_new_node->next)->value, *current_other_it);
                 }
                 catch(...){
-                    std::allocator_traits<NodeAllocator>::deallocate(alloc_, static_cast<Node*>(last_new_node->next), 1);
+                    deallocate_node_(static_cast<Node*>(last_new_node->next));
                     throw;
                 }
                 
@@ -599,19 +647,19 @@ public:
                 last_new_node = last_new_node->prev;
                 std::allocator_traits<NodeAllocator>::destroy(alloc_, static_cast<Node*>(last_new_node->next));
                 /*The Node::prev and Node::next elements are of type (BaseNode*).*/
-                std::allocator_traits<NodeAllocator>::deallocate(alloc_, static_cast<Node*>(last_new_node->next), 1);
+                deallocate_node_(static_cast<Node*>(last_new_node->next));
                 --inserted_count;
             }
 
             //Removing the second new node
             if(inserted_count == 2){
                 std::allocator_traits<NodeAllocator>::destroy(alloc_, static_cast<Node*>(first_new_node->next));
-                std::allocator_traits<NodeAllocator>::deallocate(alloc_, static_cast<Node*>(first_new_node->next), 1); 
+                deallocate_node_(static_cast<Node*>(first_new_node->next)); 
             }
 
             //Removing the first new node
             std::allocator_traits<NodeAllocator>::destroy(alloc_, static_cast<Node*>(first_new_node));
-            std::allocator_traits<NodeAllocator>::deallocate(alloc_,static_cast<Node*>( first_new_node), 1); 
+            deallocate_node_(static_cast<Node*>( first_new_node)); 
             
             throw;
         }
@@ -630,6 +678,7 @@ public:
         pos_node->prev = last_new_node;
 
         sz_+=inserted_count;
+        count_size_(sz_);
         return {first_new_node};
     }      
 
@@ -655,7 +704,7 @@ public:
             Using of the const_cast<T*>(const T*) there is never UB here, 
             because at the memory level all elements are non-constant.
         */
-        std::allocator_traits<NodeAllocator>::deallocate(alloc_, static_cast<Node*>(const_cast<BaseNode*>(delete_node)), 1);
+        deallocate_node_(static_cast<Node*>(const_cast<BaseNode*>(delete_node)));
         
         --sz_;
         return {delete_node_next};
@@ -675,7 +724,7 @@ public:
         if(last != cend()){
              while (following_after_delete->prev != last.ptr_) { 
                 std::allocator_traits<NodeAllocator>::destroy(alloc_, static_cast<Node*>(following_after_delete->prev));
-                std::allocator_traits<NodeAllocator>::deallocate(alloc_, static_cast<Node*>(following_after_delete->prev), 1);    
+                deallocate_node_(static_cast<Node*>(following_after_delete->prev));    
                 --sz_;
                 following_after_delete = following_after_delete->next;
             }
@@ -686,13 +735,13 @@ public:
         else{ 
             while (following_after_delete != &fake_node_) { 
                 std::allocator_traits<NodeAllocator>::destroy(alloc_, static_cast<Node*>(following_after_delete->prev));
-                std::allocator_traits<NodeAllocator>::deallocate(alloc_, static_cast<Node*>(following_after_delete->prev), 1);    
+                deallocate_node_(static_cast<Node*>(following_after_delete->prev));    
                 --sz_;
                 following_after_delete = following_after_delete->next;
             }
             
             std::allocator_traits<NodeAllocator>::destroy(alloc_, static_cast<Node*>(following_after_delete->prev));
-            std::allocator_traits<NodeAllocator>::deallocate(alloc_, static_cast<Node*>(following_after_delete->prev), 1);    
+            deallocate_node_(static_cast<Node*>(following_after_delete->prev));    
             --sz_;
             first_prev->next = following_after_delete;
             following_after_delete->prev = first_prev;
@@ -717,12 +766,12 @@ public:
 
     void push_back(const T& value){
         Node* new_node;
-        new_node = std::allocator_traits<NodeAllocator>::allocate(alloc_, 1);
+        new_node = allocate_node_();
         try{ 
             std::allocator_traits<NodeAllocator>::construct(alloc_, &new_node->value, value);
         }
         catch(...){
-            std::allocator_traits<NodeAllocator>::deallocate(alloc_, new_node, 1);
+            deallocate_node_(new_node);
             throw;
         }
         
@@ -732,16 +781,17 @@ public:
         new_node->next = &fake_node_;
         fake_node_.prev = new_node;
         ++sz_;
+        count_size_(sz_);
     }
     
     void push_back(T&& value){
         Node* new_node;
-        new_node = std::allocator_traits<NodeAllocator>::allocate(alloc_, 1);
+        new_node = allocate_node_();
         try{ 
             std::allocator_traits<NodeAllocator>::construct(alloc_, &new_node->value, std::move(value));
         }
         catch(...){
-            std::allocator_traits<NodeAllocator>::deallocate(alloc_, new_node, 1);
+            deallocate_node_(new_node);
             throw;
         }
         
@@ -751,6 +801,7 @@ public:
         new_node->next = &fake_node_;
         fake_node_.prev = new_node;
         ++sz_;
+        count_size_(sz_);
     }
 
 
@@ -758,12 +809,12 @@ public:
     template <class... Args>
     reference emplace_back(Args&&... args){
         Node* new_node;
-        new_node = std::allocator_traits<NodeAllocator>::allocate(alloc_, 1);
+        new_node = allocate_node_();
         try{ 
             std::allocator_traits<NodeAllocator>::construct(alloc_, &new_node->value, std::forward<Args>(args)...);
         }
         catch(...){
-            std::allocator_traits<NodeAllocator>::deallocate(alloc_, new_node, 1);
+            deallocate_node_(new_node);
             throw;
         }
         
@@ -773,6 +824,7 @@ public:
         new_node->next = &fake_node_;
         fake_node_.prev = new_node;
         ++sz_;
+        count_size_(sz_);
 
         return new_node->value;
     }
@@ -785,7 +837,7 @@ public:
         fake_node_.prev = delete_node->prev;
         fake_node_.prev->next = &fake_node_; 
         std::allocator_traits<NodeAllocator>::destroy(alloc_, static_cast<Node*>(delete_node));
-        std::allocator_traits<NodeAllocator>::deallocate(alloc_, static_cast<Node*>(delete_node), 1);
+        deallocate_node_(static_cast<Node*>(delete_node));
         --sz_;
     }
     
@@ -793,12 +845,12 @@ public:
 
     void push_front(const T& value){
         Node* new_node;
-        new_node = std::allocator_traits<NodeAllocator>::allocate(alloc_, 1);
+        new_node = allocate_node_();
         try{
             std::allocator_traits<NodeAllocator>::construct(alloc_, &new_node->value, value);
         }
         catch(...){
-            std::allocator_traits<NodeAllocator>::deallocate(alloc_, new_node, 1);
+            deallocate_node_(new_node);
             throw;
         }
 
@@ -808,16 +860,17 @@ public:
         new_node->next = fake_node_next;           
         fake_node_next->prev = new_node;
         ++sz_;
+        count_size_(sz_);
     }
     
     void push_front(T&& value){ 
         Node* new_node;
-        new_node = std::allocator_traits<NodeAllocator>::allocate(alloc_, 1);
+        new_node = allocate_node_();
         try{
             std::allocator_traits<NodeAllocator>::construct(alloc_, &new_node->value, std::move(value));
         }
         catch(...){
-            std::allocator_traits<NodeAllocator>::deallocate(alloc_, new_node, 1);
+            deallocate_node_(new_node);
             throw;
         }
 
@@ -827,18 +880,19 @@ public:
         new_node->next = fake_node_next;           
         fake_node_next->prev = new_node;
         ++sz_;
+        count_size_(sz_);
     }
 
 
     template <class... Args>
     reference emplace_front(Args&&... args){
         Node* new_node;
-        new_node = std::allocator_traits<NodeAllocator>::allocate(alloc_, 1);
+        new_node = allocate_node_();
         try{ 
             std::allocator_traits<NodeAllocator>::construct(alloc_, &new_node->value, std::forward<Args>(args)...);
         }
         catch(...){
-            std::allocator_traits<NodeAllocator>::deallocate(alloc_, new_node, 1);
+            deallocate_node_(new_node);
             throw;
         }
      
@@ -848,6 +902,7 @@ public:
         new_node->next = fake_node_next;           
         fake_node_next->prev = new_node;
         ++sz_;
+        count_size_(sz_);
 
         return new_node->value;
     }
@@ -862,26 +917,26 @@ public:
         fake_node_.next = delete_node->next;
         fake_node_.next->prev = &fake_node_; 
         std::allocator_traits<NodeAllocator>::destroy(alloc_, static_cast<Node*>(delete_node));
-        std::allocator_traits<NodeAllocator>::deallocate(alloc_, static_cast<Node*>(delete_node), 1);
+        deallocate_node_(static_cast<Node*>(delete_node));
         --sz_;
     }
 
    
     void resize(size_type count){
         if (count > sz_){
-            insert(--end(), count - sz_, T());
+            insert(cend(), count - sz_, T());
         }
         else if (count < sz_){
             BaseNode* first_delete;
             if (count <= sz_/2){
                 first_delete = fake_node_.next;
-                for (int i = 0; i < count; ++i){
+                for (size_type i = 0; i < count; ++i){
                     first_delete = first_delete->next;
                 }
             }
             else{
                 first_delete = &fake_node_;
-                for (int i = sz_; i > count; --i){
+                for (size_type i = sz_; i > count; --i){
                     first_delete = first_delete->prev;
                 }
             }
@@ -891,19 +946,19 @@ public:
     
     void resize(size_type count, const value_type& value){   
         if (count > sz_){
-            insert(--end(), count - sz_, value);
+            insert(cend(), count - sz_, value);
         }
         else if (count < sz_){
             BaseNode* first_delete;
             if (count <= sz_/2){
                 first_delete = fake_node_.next;
-                for (int i = 0; i < count; ++i){
+                for (size_type i = 0; i < count; ++i){
                     first_delete = first_delete->next;
                 }
             }
             else{
                 first_delete = &fake_node_;
-                for (int i = sz_; i > count; --i){
+                for (size_type i = sz_; i > count; --i){
                     first_delete = first_delete->prev;
                 }
             }
@@ -911,11 +966,34 @@ public:
         }
     }
    
-    void swap(list& other) noexcept(noexcept(std::allocator_traits<NodeAllocator>::is_always_equal::value)){
-        std::swap(fake_node_, other.fake_node_);
-        std::swap(fake_node_.next->prev, other.fake_node_.next->prev);
-        std::swap(fake_node_.prev->next, other.fake_node_.prev->next);
+    /*
+        The sentinels stay in their lists: the chains of the nodes are exchanged
+        and relinked to them (the empty side gets the sentinel, pointing at itself).
+    */
+    void swap(list& other) noexcept(std::allocator_traits<NodeAllocator>::is_always_equal::value){
+        list* lists[2] = {this, &other};
+        BaseNode* firsts[2];
+        BaseNode* lasts[2];
+        for (int i = 0; i < 2; ++i){
+            firsts[i] = lists[i]->sz_ ? lists[i]->fake_node_.next : nullptr;
+            lasts[i] = lists[i]->sz_ ? lists[i]->fake_node_.prev : nullptr;
+        }
+        for (int i = 0; i < 2; ++i){
+            BaseNode& fake = lists[i]->fake_node_;
+            int j = 1 - i;
+            if (firsts[j] == nullptr){
+                fake.next = &fake;
+                fake.prev = &fake;
+            }
+            else{
+                fake.next = firsts[j];
+                fake.prev = lasts[j];
+                firsts[j]->prev = &fake;
+                lasts[j]->next = &fake;
+            }
+        }
         std::swap(sz_, other.sz_);
+        std::swap(node_blocks_, other.node_blocks_);
         
         if constexpr(std::allocator_traits<NodeAllocator>::propagate_on_container_swap::value){
             std::swap(alloc_, other.alloc_);
@@ -924,6 +1002,87 @@ public:
     
    
    
+    /*
+        Relayout of the nodes: the elements are moved (or copied, if the move of T may throw)
+        into the new nodes, which fill the blocks of contiguous memory in the traversal order,
+        and the old nodes are freed. After the long insert/erase churn it brings the traversal
+        back to the sequential memory access.
+        The nodes, inserted later, are allocated one by one as usual. A block (up to 1 MiB)
+        is returned to the allocator only with the last of its nodes: a single surviving node
+        keeps the whole block allocated until it is erased (or until the next defragment()).
+        All the iterators and the references are invalidated. If an exception is thrown
+        by the allocation or by the copy of T, the list is unchanged; if T isn't copyable
+        and its move may throw, the elements are moved anyway, and after the exception
+        the elements, moved before it, are left in the moved-from state.
+    */
+    void defragment(){
+        if (sz_ == 0) {return;}
+
+        NodeBlockAllocator block_alloc(alloc_);
+        NodeBlocksAllocator blocks_alloc(alloc_);
+        size_t new_count = (sz_ + defragment_block_nodes_ - 1) / defragment_block_nodes_;
+
+        // the bookkeeping is allocated first: nothing can throw after the elements are moved
+        NodeBlocks* new_blocks = std::allocator_traits<NodeBlocksAllocator>::allocate(blocks_alloc, 1);
+        NodeBlock* array = nullptr;
+        size_t allocated_count = 0;
+        size_t constructed_count = 0;
+        try{
+            array = std::allocator_traits<NodeBlockAllocator>::allocate(block_alloc, new_count);
+            for (size_t rest = sz_; rest > 0; ++allocated_count){
+                size_t block_capacity = std::min(rest, defragment_block_nodes_);
+                array[allocated_count] = {std::allocator_traits<NodeAllocator>::allocate(alloc_, block_capacity), block_capacity, block_capacity};
+                count_allocation_(block_capacity * sizeof(Node));
+                rest -= block_capacity;
+            }
+            BaseNode* old_node = fake_node_.next;
+            for (size_t k = 0; k < new_count; ++k){
+                for (size_t i = 0; i < array[k].capacity; ++i, old_node = old_node->next){
+                    std::allocator_traits<NodeAllocator>::construct(alloc_, &array[k].nodes[i].value, std::move_if_noexcept(static_cast<Node*>(old_node)->value));
+                    ++constructed_count;
+                }
+            }
+        }
+        catch(...){
+            for (size_t k = 0; k < allocated_count; ++k){
+                for (size_t i = 0; i < array[k].capacity && constructed_count > 0; ++i, --constructed_count){
+                    std::allocator_traits<NodeAllocator>::destroy(alloc_, &array[k].nodes[i].value);
+                }
+                std::allocator_traits<NodeAllocator>::deallocate(alloc_, array[k].nodes, array[k].capacity);
+            }
+            if (array) {std::allocator_traits<NodeBlockAllocator>::deallocate(block_alloc, array, new_count);}
+            std::allocator_traits<NodeBlocksAllocator>::deallocate(blocks_alloc, new_blocks, 1);
+            throw;
+        }
+
+        // all the nodes of the old blocks are in the list: the last of them frees the old bookkeeping too
+        BaseNode* old_node = fake_node_.next;
+        while (old_node != &fake_node_){
+            BaseNode* next = old_node->next;
+            std::allocator_traits<NodeAllocator>::destroy(alloc_, &static_cast<Node*>(old_node)->value);
+            deallocate_node_(static_cast<Node*>(old_node));
+            old_node = next;
+        }
+
+        BaseNode* prev = &fake_node_;
+        for (size_t k = 0; k < new_count; ++k){
+            for (size_t i = 0; i < array[k].capacity; ++i){
+                array[k].nodes[i].prev = prev;
+                prev->next = &array[k].nodes[i];
+                prev = &array[k].nodes[i];
+            }
+        }
+        prev->next = &fake_node_;
+        fake_node_.prev = prev;
+
+        std::sort(array, array + new_count, [](const NodeBlock& lhs, const NodeBlock& rhs){
+            return std::less<const Node*>()(lhs.nodes, rhs.nodes);
+        });
+        std::allocator_traits<NodeBlocksAllocator>::construct(blocks_alloc, new_blocks, NodeBlocks{array, new_count, new_count, array[0].nodes, array[new_count - 1].nodes + array[new_count - 1].capacity});
+        node_blocks_ = new_blocks;
+    }
+
+
     //merge
     
     
@@ -964,8 +1123,254 @@ public:
 
     //unique
 
-    //sort
-    
+
+    /*
+        Merge sort by relinking of the nodes: no node is allocated, copied or moved.
+        The sort is stable. If comp throws, all the elements stay in the list
+        (in unspecified order) and the exception is rethrown.
+    */
+    void sort(){
+        sort(std::less<T>());
+    }
+
+    template <class Compare>
+    void sort(Compare comp){
+        if (sz_ < 2) {return;}
+
+        Chain whole = detach_all_nodes_();
+        BaseNode* rest = whole.head;
+        Chain sorted;
+        try{
+            sort_chain_(sorted, rest, sz_, comp);
+        }
+        catch(...){
+            append_chain_(sorted, {rest, rest ? whole.tail : nullptr});
+            attach_all_nodes_(sorted);
+            throw;
+        }
+        attach_all_nodes_(sorted);
+    }
+
+
+    /*
+        The list is cut into (threads_count) detached sublists, each of them is sorted
+        on its own std::thread, then the sorted sublists are merged pairwise
+        (the merges of one round run in parallel too). No node is allocated.
+        Small lists (less than parallel_sort_min_part_size_ nodes per thread) are sorted serially.
+    */
+    void parallel_sort(){
+        parallel_sort(std::less<T>());
+    }
+
+    template <class Compare>
+    void parallel_sort(Compare comp, size_t threads_count = std::thread::hardware_concurrency()){
+        size_t parts = sz_ / parallel_sort_min_part_size_;
+        if (threads_count < parts) {parts = threads_count;}
+        if (parts < 2){
+            sort(comp);
+            return;
+        }
+
+        Chain whole = detach_all_nodes_();
+
+        // cutting of the sublists: part i gets (sz_ * (i + 1) / parts - sz_ * i / parts) nodes
+        std::vector<Chain> sorted(parts);
+        std::vector<Chain> rests(parts);
+        std::vector<size_t> sizes(parts);
+        BaseNode* current_node = whole.head;
+        for (size_t i = 0; i < parts; ++i){
+            sizes[i] = (sz_ * (i + 1)) / parts - (sz_ * i) / parts;
+            rests[i].head = current_node;
+            for (size_t j = 1; j < sizes[i]; ++j){
+                current_node = current_node->next;
+            }
+            rests[i].tail = current_node;
+            current_node = current_node->next;
+            rests[i].tail->next = nullptr;
+        }
+
+        std::vector<std::exception_ptr> errors(parts);
+        auto sort_part = [this, &comp, &sorted, &rests, &sizes, &errors](size_t i){
+            try{
+                sort_chain_(sorted[i], rests[i].head, sizes[i], comp);
+            }
+            catch(...){
+                errors[i] = std::current_exception();
+            }
+            append_chain_(sorted[i], rests[i]);
+            rests[i] = Chain{};
+        };
+        try{
+            run_in_threads_(parts, sort_part);
+        }
+        catch(...){
+            for (size_t i = 0; i < parts; ++i) {append_chain_(sorted[i], rests[i]);}
+            reattach_chains_(sorted);
+            throw;
+        }
+        rethrow_if_failed_(sorted, errors);
+
+        for (size_t width = 1; width < parts; width *= 2){
+            size_t merges_count = (parts + 2 * width - 1) / (2 * width);
+            auto merge_pair = [this, &comp, &sorted, &errors, width, parts](size_t merge){
+                size_t left = merge * 2 * width;
+                size_t right = left + width;
+                if (right >= parts) {return;}
+                try{
+                    merge_chains_(sorted[left], sorted[right], comp);
+                }
+                catch(...){
+                    errors[left] = std::current_exception();
+                }
+            };
+            try{
+                run_in_threads_(merges_count, merge_pair);
+            }
+            catch(...){
+                reattach_chains_(sorted);
+                throw;
+            }
+            rethrow_if_failed_(sorted, errors);
+        }
+
+        attach_all_nodes_(sorted[0]);
+    }
+
+
+private:
+
+    static constexpr size_t parallel_sort_min_part_size_ = 4096;
+
+    // null-terminated (by next) chain of nodes, which are detached from the list
+    struct Chain{
+        BaseNode* head = nullptr;
+        BaseNode* tail = nullptr;
+    };
+
+    Chain detach_all_nodes_(){
+        Chain result{fake_node_.next, fake_node_.prev};
+        result.tail->next = nullptr;
+        fake_node_.next = &fake_node_;
+        fake_node_.prev = &fake_node_;
+        return result;
+    }
+
+    // all the nodes of the list must be in chain (sz_ isn't changed)
+    void attach_all_nodes_(Chain chain){
+        if (chain.head == nullptr) {return;}
+        fake_node_.next = chain.head;
+        chain.head->prev = &fake_node_;
+        fake_node_.prev = chain.tail;
+        chain.tail->next = &fake_node_;
+    }
+
+    static void append_chain_(Chain& destination, Chain source){
+        if (source.head == nullptr) {return;}
+        if (destination.head == nullptr){
+            destination = source;
+            return;
+        }
+        destination.tail->next = source.head;
+        source.head->prev = destination.tail;
+        destination.tail = source.tail;
+    }
+
+    /*
+        Stable merge of the sorted chains into (left), (right) becomes empty.
+        If comp throws, (left) holds all the nodes of both chains (partially merged).
+    */
+    template <class Compare>
+    static void merge_chains_(Chain& left, Chain& right, Compare& comp){
+        BaseNode merged_head(nullptr, nullptr);
+        Chain merged{&merged_head, &merged_head};
+        try{
+            while (left.head != nullptr && right.head != nullptr){
+                BaseNode*& taken = comp(static_cast<Node*>(right.head)->value, static_cast<Node*>(left.head)->value)
+                    ? right.head : left.head;
+                merged.tail->next = taken;
+                taken->prev = merged.tail;
+                merged.tail = taken;
+                taken = taken->next;
+            }
+        }
+        catch(...){
+            merged.tail->next = nullptr;
+            Chain all{merged_head.next, (merged.tail == &merged_head) ? nullptr : merged.tail};
+            append_chain_(all, {left.head, left.head ? left.tail : nullptr});
+            append_chain_(all, {right.head, right.head ? right.tail : nullptr});
+            left = all;
+            right = Chain{};
+            throw;
+        }
+        if (left.head != nullptr){
+            merged.tail->next = left.head;
+            left.head->prev = merged.tail;
+            merged.tail = left.tail;
+        }
+        else{
+            merged.tail->next = right.head;
+            right.head->prev = merged.tail;
+            merged.tail = right.tail;
+        }
+        left = Chain{merged_head.next, merged.tail};
+        right = Chain{};
+    }
+
+    /*
+        Takes (count) nodes from the head of the (rest) chain and puts them sorted into (result).
+        If comp throws, (result) holds all the taken nodes, and (rest) holds the untouched ones.
+    */
+    template <class Compare>
+    static void sort_chain_(Chain& result, BaseNode*& rest, size_t count, Compare& comp){
+        if (count == 1){
+            result = Chain{rest, rest};
+            rest = rest->next;
+            result.tail->next = nullptr;
+            return;
+        }
+        sort_chain_(result, rest, count / 2, comp);
+        Chain right;
+        try{
+            sort_chain_(right, rest, count - count / 2, comp);
+            merge_chains_(result, right, comp);
+        }
+        catch(...){
+            append_chain_(result, right);
+            throw;
+        }
+    }
+
+    template <class Task>
+    static void run_in_threads_(size_t count, Task& task){
+        std::vector<std::thread> workers;
+        workers.reserve(count);
+        try{
+            for (size_t i = 1; i < count; ++i){
+                workers.emplace_back(std::ref(task), i);
+            }
+        }
+        catch(...){
+            for (std::thread& worker: workers) {worker.join();}
+            throw;
+        }
+        task(0);
+        for (std::thread& worker: workers) {worker.join();}
+    }
+
+    void reattach_chains_(std::vector<Chain>& chains){
+        Chain all;
+        for (Chain& chain: chains) {append_chain_(all, chain);}
+        attach_all_nodes_(all);
+    }
+
+    void rethrow_if_failed_(std::vector<Chain>& chains, std::vector<std::exception_ptr>& errors){
+        for (std::exception_ptr& error: errors){
+            if (error){
+                reattach_chains_(chains);
+                std::rethrow_exception(error);
+            }
+        }
+    }
 };
 
 
@@ -0,0 +1,454 @@
+#ifndef FAREBL_MAPPED_DEQUE_H
+#define FAREBL_MAPPED_DEQUE_H
+
+#include <algorithm>     // for max, fill
+#include <cerrno>        // for errno
+#include <cstddef>       // for size_t
+#include <cstdint>       // for uint32_t, uint64_t, UINT64_MAX
+#include <cstring>       // for memcmp, memcpy
+#include <stdexcept>     // for out_of_range, runtime_error
+#include <string>        // for string
+#include <system_error>  // for system_error, generic_category
+#include <type_traits>   // for is_trivially_copyable, conditional
+
+#include <fcntl.h>       // for open, O_RDWR, O_CREAT, O_TRUNC
+#include <sys/mman.h>    // for mmap, munmap, msync
+#include <sys/stat.h>    // for fstat
+#include <unistd.h>      // for close, ftruncate
+
+#include "deque.hpp"     // for deque_default_bucket_size
+
+namespace Farebl {
+
+/*
+    Deque of trivially copyable elements, whose buckets live in a memory-mapped file.
+
+    The file layout:
+        [Header][... buckets and bucket arrays, appended to the end of the used space ...]
+    The bucket array (the "map") stores the offsets of the buckets in the file instead of T*,
+    so after the restart the file is simply mapped again and the deque continues from
+    the same state, without copying or deserializing of the elements.
+    The buckets, which become empty, go to the free list (inside the file) and are reused;
+    the old bucket arrays, left after the growth of the map, aren't reused.
+
+    Durability: the changes reach the file through the shared mapping; flush() (msync) is the
+    point, after which they survive a crash of the system. If the system crashes between
+    the flushes, the last operations may be lost.
+*/
+template <typename T, size_t BucketSize = deque_default_bucket_size<T>>
+class mapped_deque{
+    static_assert(std::is_trivially_copyable<T>::value, "The elements of mapped_deque must be trivially copyable");
+    static_assert(alignof(T) <= 64, "The alignment of T cannot exceed 64 bytes");
+    static_assert(BucketSize > 0, "The bucket size must be 1 or greater");
+
+    struct Header{
+        char magic[8];
+        uint32_t version;
+        uint32_t value_size;
+        uint64_t bucket_size;
+        uint64_t map_offset;     // offset of the array of the bucket offsets
+        uint64_t map_capacity;   // count of the slots in the map
+        uint64_t first_index;    // index of the front() cell: slot (first_index / BucketSize)
+        uint64_t size;
+        uint64_t space_end;      // end of the used space of the file (new regions are appended here)
+        uint64_t free_bucket;    // offset of the first free bucket (0 - no free buckets)
+    };
+
+    static constexpr char magic_[8] = {'F', 'A', 'R', 'E', 'B', 'L', 'M', 'D'};
+    static constexpr uint32_t version_ = 1;
+    static constexpr uint64_t region_alignment_ = 64;
+    static constexpr uint64_t bucket_bytes_ = ((BucketSize * sizeof(T) + region_alignment_ - 1) / region_alignment_) * region_alignment_;
+    static constexpr uint64_t header_bytes_ = ((sizeof(Header) + region_alignment_ - 1) / region_alignment_) * region_alignment_;
+    static constexpr uint64_t initial_map_capacity_ = 8;
+    static constexpr uint64_t min_file_growth_ = 1024 * 1024;
+
+    int m_fd;
+    char* m_base;
+    uint64_t m_file_size;
+
+    template <bool IsConst = false>
+    struct base_segment{
+        using pointer = typename std::conditional<IsConst, const T*, T*>::type;
+        pointer first;
+        pointer last;
+
+        size_t size() const {return last - first;}
+        pointer begin() const {return first;}
+        pointer end() const {return last;}
+    };
+
+public:
+    using value_type      = T;
+    using size_type       = size_t;
+    using reference       = T&;
+    using const_reference = const T&;
+    using segment         = base_segment<false>;
+    using const_segment   = base_segment<true>;
+
+    static constexpr size_type bucket_size = BucketSize;
+
+    enum class open_mode{
+        open_or_create, // the existing file is opened (and validated), the missing one is created
+        create,         // the file is created or truncated
+        open_existing   // the file must exist
+    };
+
+private:
+    [[noreturn]] static void throw_errno_(const std::string& what){
+        throw std::system_error(errno, std::generic_category(), "Farebl::mapped_deque: " + what);
+    }
+
+    Header* header_() const {return reinterpret_cast<Header*>(m_base);}
+    uint64_t* map_() const {return reinterpret_cast<uint64_t*>(m_base + header_()->map_offset);}
+    T* bucket_(uint64_t offset) const {return reinterpret_cast<T*>(m_base + offset);}
+
+    void map_file_(uint64_t file_size){
+        void* memory = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        if (memory == MAP_FAILED) {throw_errno_("mmap");}
+        m_base = static_cast<char*>(memory);
+        m_file_size = file_size;
+    }
+
+    // IMPORTANT: all the pointers into the mapping (header_(), map_(), bucket_()) are invalidated
+    void grow_file_(uint64_t min_file_size){
+        uint64_t new_file_size = std::max({min_file_size, m_file_size * 2, min_file_growth_});
+        if (ftruncate(m_fd, static_cast<off_t>(new_file_size)) != 0) {throw_errno_("ftruncate");}
+        munmap(m_base, m_file_size);
+        m_base = nullptr;
+        map_file_(new_file_size);
+    }
+
+    // offset of the new region of (bytes) bytes at the end of the used space
+    uint64_t append_region_(uint64_t bytes){
+        uint64_t offset = header_()->space_end;
+        if (offset + bytes > m_file_size){
+            grow_file_(offset + bytes);
+        }
+        header_()->space_end = offset + bytes;
+        return offset;
+    }
+
+    uint64_t allocate_bucket_(){
+        uint64_t offset = header_()->free_bucket;
+        if (offset != 0){
+            uint64_t next_free;
+            std::memcpy(&next_free, m_base + offset, sizeof(next_free));
+            header_()->free_bucket = next_free;
+            return offset;
+        }
+        return append_region_(bucket_bytes_);
+    }
+
+    void free_bucket_of_slot_(uint64_t slot){
+        uint64_t& bucket_offset = map_()[slot];
+        if (bucket_offset == 0) {return;}
+        uint64_t next_free = header_()->free_bucket;
+        std::memcpy(m_base + bucket_offset, &next_free, sizeof(next_free));
+        header_()->free_bucket = bucket_offset;
+        bucket_offset = 0;
+    }
+
+    void ensure_bucket_of_slot_(uint64_t slot){
+        if (map_()[slot] != 0) {return;}
+        uint64_t bucket_offset = allocate_bucket_(); // may remap the file
+        map_()[slot] = bucket_offset;
+    }
+
+    /*
+        The new map (with at least (min_capacity) slots) is appended to the file,
+        the used slots are placed in its middle.
+    */
+    void grow_map_(uint64_t min_capacity){
+        uint64_t old_capacity = header_()->map_capacity;
+        uint64_t new_capacity = std::max(old_capacity * 2, min_capacity);
+        uint64_t new_map_offset = append_region_(new_capacity * sizeof(uint64_t));
+
+        Header* header = header_();
+        uint64_t* old_map = map_();
+        uint64_t* new_map = reinterpret_cast<uint64_t*>(m_base + new_map_offset);
+        std::fill(new_map, new_map + new_capacity, uint64_t(0));
+
+        uint64_t first_slot = header->first_index / BucketSize;
+        uint64_t last_slot = (header->size == 0) ? first_slot : (header->first_index + header->size - 1) / BucketSize;
+        uint64_t used_slots = last_slot - first_slot + 1;
+        uint64_t new_first_slot = (new_capacity - used_slots) / 2;
+        std::memcpy(new_map + new_first_slot, old_map + first_slot, used_slots * sizeof(uint64_t));
+
+        header->first_index = new_first_slot * BucketSize + header->first_index % BucketSize;
+        header->map_offset = new_map_offset;
+        header->map_capacity = new_capacity;
+    }
+
+    void initialize_(){
+        if (ftruncate(m_fd, static_cast<off_t>(min_file_growth_)) != 0) {throw_errno_("ftruncate");}
+        map_file_(min_file_growth_);
+
+        Header* header = header_();
+        std::memcpy(header->magic, magic_, sizeof(magic_));
+        header->version = version_;
+        header->value_size = sizeof(T);
+        header->bucket_size = BucketSize;
+        header->map_offset = header_bytes_;
+        header->map_capacity = initial_map_capacity_;
+        header->first_index = (initial_map_capacity_ / 2) * BucketSize;
+        header->size = 0;
+        header->space_end = header_bytes_ + initial_map_capacity_ * sizeof(uint64_t);
+        header->free_bucket = 0;
+        std::fill(map_(), map_() + initial_map_capacity_, uint64_t(0));
+    }
+
+    /*
+        Offset of a whole bucket inside the used space (the buckets are placed after the header),
+        aligned for T (the regions are appended at the multiples of region_alignment_)
+    */
+    bool valid_bucket_offset_(uint64_t offset) const {
+        Header* header = header_();
+        return
+            offset >= header_bytes_
+                &&
+            offset % alignof(T) == 0
+                &&
+            offset <= header->space_end
+                &&
+            header->space_end - offset >= bucket_bytes_;
+    }
+
+    /*
+        The header, the map and the free list are checked against the file, so the damaged file
+        throws here instead of the access out of the mapping later: the used slots of the map
+        point to the buckets inside the used space, the free slots are 0, and the free list
+        is a chain (without cycles) of the buckets inside the used space.
+    */
+    void validate_(){
+        Header* header = header_();
+        bool valid =
+            std::memcmp(header->magic, magic_, sizeof(magic_)) == 0
+                &&
+            header->version == version_
+                &&
+            header->value_size == sizeof(T)
+                &&
+            header->bucket_size == BucketSize
+                &&
+            header->space_end >= header_bytes_
+                &&
+            header->space_end <= m_file_size
+                &&
+            header->map_offset >= header_bytes_
+                &&
+            header->map_offset % alignof(uint64_t) == 0
+                &&
+            header->map_offset <= header->space_end
+                &&
+            header->map_capacity != 0
+                &&
+            header->map_capacity <= (header->space_end - header->map_offset) / sizeof(uint64_t)
+                &&
+            header->first_index / BucketSize < header->map_capacity
+                &&
+            header->size <= UINT64_MAX - header->first_index
+                &&
+            (header->size == 0 || (header->first_index + header->size - 1) / BucketSize < header->map_capacity);
+
+        if (valid){
+            uint64_t first_slot = header->first_index / BucketSize;
+            uint64_t last_slot = (header->size == 0) ? first_slot : (header->first_index + header->size - 1) / BucketSize;
+            const uint64_t* map = map_();
+            for (uint64_t slot = 0; slot < header->map_capacity && valid; ++slot){
+                bool used = header->size != 0 && slot >= first_slot && slot <= last_slot;
+                valid = used ? valid_bucket_offset_(map[slot]) : (map[slot] == 0);
+            }
+            // each free bucket is a different bucket of the used space: a longer chain has a cycle
+            uint64_t max_free_buckets = header->space_end / bucket_bytes_;
+            uint64_t offset = header->free_bucket;
+            for (uint64_t count = 0; offset != 0 && valid; ++count){
+                valid = count < max_free_buckets && valid_bucket_offset_(offset);
+                if (valid) {std::memcpy(&offset, m_base + offset, sizeof(offset));}
+            }
+        }
+        if (!valid){
+            throw std::runtime_error("Farebl::mapped_deque: the file has incompatible format or is damaged");
+        }
+    }
+
+    void close_(){
+        if (m_base != nullptr) {munmap(m_base, m_file_size);}
+        if (m_fd != -1) {::close(m_fd);}
+        m_base = nullptr;
+        m_fd = -1;
+    }
+
+    T* element_ptr_(size_type pos) const {
+        uint64_t index = header_()->first_index + pos;
+        return bucket_(map_()[index / BucketSize]) + index % BucketSize;
+    }
+
+public:
+    explicit mapped_deque(const std::string& path, open_mode mode = open_mode::open_or_create):
+        m_fd(-1),
+        m_base(nullptr),
+        m_file_size(0)
+    {
+        int flags = O_RDWR;
+        if (mode == open_mode::open_or_create) {flags |= O_CREAT;}
+        if (mode == open_mode::create) {flags |= O_CREAT | O_TRUNC;}
+
+        m_fd = ::open(path.c_str(), flags, 0644);
+        if (m_fd == -1) {throw_errno_("open " + path);}
+        try{
+            struct stat file_stat;
+            if (fstat(m_fd, &file_stat) != 0) {throw_errno_("fstat");}
+            if (file_stat.st_size == 0){
+                initialize_();
+            }
+            else{
+                map_file_(static_cast<uint64_t>(file_stat.st_size));
+                if (m_file_size < header_bytes_){
+                    throw std::runtime_error("Farebl::mapped_deque: the file is too small");
+                }
+                validate_();
+            }
+        }
+        catch(...){
+            close_();
+            throw;
+        }
+    }
+
+    mapped_deque(const mapped_deque&) = delete;
+    mapped_deque& operator=(const mapped_deque&) = delete;
+
+    // the unflushed changes are written back by the kernel later (see flush())
+    ~mapped_deque(){
+        close_();
+    }
+
+
+    /*
+        synchronous == true:  returns after the data reaches the storage (msync MS_SYNC);
+        synchronous == false: only schedules the write back (msync MS_ASYNC).
+    */
+    void flush(bool synchronous = true){
+        if (msync(m_base, header_()->space_end, synchronous ? MS_SYNC : MS_ASYNC) != 0){
+            throw_errno_("msync");
+        }
+    }
+
+
+    bool empty() const {return header_()->size == 0;}
+
+    size_type size() const {return header_()->size;}
+
+    // bytes of the file, which are used by the deque
+    size_type used_file_bytes() const {return header_()->space_end;}
+
+
+    reference operator[](size_type pos) {return *element_ptr_(pos);}
+    const_reference operator[](size_type pos) const {return *element_ptr_(pos);}
+
+    reference at(size_type pos){
+        if (pos >= size()) {throw std::out_of_range("Farebl::mapped_deque::at: pos >= size()");}
+        return *element_ptr_(pos);
+    }
+    const_reference at(size_type pos) const {
+        if (pos >= size()) {throw std::out_of_range("Farebl::mapped_deque::at: pos >= size()");}
+        return *element_ptr_(pos);
+    }
+
+    reference front() {return *element_ptr_(0);}
+    const_reference front() const {return *element_ptr_(0);}
+
+    reference back() {return *element_ptr_(size() - 1);}
+    const_reference back() const {return *element_ptr_(size() - 1);}
+
+
+    // the same segments as Farebl::deque::get_segment (contiguous runs inside one bucket)
+    size_type segment_count() const {
+        Header* header = header_();
+        if (header->size == 0) {return 0;}
+        return (header->first_index + header->size - 1) / BucketSize - header->first_index / BucketSize + 1;
+    }
+
+    segment get_segment(size_type index){
+        Header* header = header_();
+        uint64_t first_slot = header->first_index / BucketSize;
+        uint64_t last_index = header->first_index + header->size - 1;
+        uint64_t slot = first_slot + index;
+        T* bucket = bucket_(map_()[slot]);
+        return {
+            (index == 0) ? (bucket + header->first_index % BucketSize) : bucket,
+            (slot == last_index / BucketSize) ? (bucket + last_index % BucketSize + 1) : (bucket + BucketSize)
+        };
+    }
+    const_segment get_segment(size_type index) const {
+        segment result = const_cast<mapped_deque*>(this)->get_segment(index);
+        return {result.first, result.last};
+    }
+
+
+    void push_back(const T& value){
+        T copy = value; // (value) may live inside the mapping, which can be remapped below
+        uint64_t index = header_()->first_index + header_()->size;
+        if (index / BucketSize >= header_()->map_capacity){
+            grow_map_(index / BucketSize + 1);
+            index = header_()->first_index + header_()->size;
+        }
+        ensure_bucket_of_slot_(index / BucketSize);
+        std::memcpy(static_cast<void*>(bucket_(map_()[index / BucketSize]) + index % BucketSize), &copy, sizeof(T));
+        ++header_()->size;
+    }
+
+    void push_front(const T& value){
+        T copy = value;
+        if (header_()->first_index == 0){
+            grow_map_(header_()->map_capacity + 1);
+        }
+        uint64_t index = header_()->first_index - 1;
+        ensure_bucket_of_slot_(index / BucketSize);
+        std::memcpy(static_cast<void*>(bucket_(map_()[index / BucketSize]) + index % BucketSize), &copy, sizeof(T));
+        header_()->first_index = index;
+        ++header_()->size;
+    }
+
+    void pop_front(){
+        Header* header = header_();
+        if (header->size == 0) {return;}
+        uint64_t index = header->first_index;
+        ++header->first_index;
+        --header->size;
+        if (header->size == 0 || header->first_index % BucketSize == 0){
+            free_bucket_of_slot_(index / BucketSize);
+        }
+        if (header->size == 0){
+            header->first_index = (header->map_capacity / 2) * BucketSize;
+        }
+    }
+
+    void pop_back(){
+        Header* header = header_();
+        if (header->size == 0) {return;}
+        --header->size;
+        uint64_t index = header->first_index + header->size;
+        if (header->size == 0 || index % BucketSize == 0){
+            free_bucket_of_slot_(index / BucketSize);
+        }
+        if (header->size == 0){
+            header->first_index = (header->map_capacity / 2) * BucketSize;
+        }
+    }
+
+    void clear(){
+        Header* header = header_();
+        if (header->size == 0) {return;}
+        uint64_t first_slot = header->first_index / BucketSize;
+        uint64_t last_slot = (header->first_index + header->size - 1) / BucketSize;
+        for (uint64_t slot = first_slot; slot <= last_slot; ++slot){
+            free_bucket_of_slot_(slot);
+        }
+        header->size = 0;
+        header->first_index = (header->map_capacity / 2) * BucketSize;
+    }
+};
+
+} // end namespace Farebl
+#endif // FAREBL_MAPPED_DEQUE_H
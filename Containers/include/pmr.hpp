@@ -0,0 +1,265 @@
+#ifndef FAREBL_PMR_H
+#define FAREBL_PMR_H
+
+#include <algorithm>         // for find_if, max
+#include <cstddef>           // for size_t, max_align_t
+#include <cstdint>           // for uintptr_t
+#include <initializer_list>  // for initializer_list
+#include <memory_resource>   // for memory_resource, polymorphic_allocator, get_default_resource
+#include <new>               // for placement new
+#include <vector>            // for vector
+
+#include "deque.hpp"
+#include "list.hpp"
+
+namespace Farebl {
+namespace pmr {
+
+template <typename T>
+using list = Farebl::list<T, std::pmr::polymorphic_allocator<T>>;
+
+template <typename T, size_t BucketSize = deque_default_bucket_size<T>>
+using deque = Farebl::deque<T, std::pmr::polymorphic_allocator<T>, BucketSize>;
+
+
+// sizes of the allocations, which are made by the containers for their elements
+template <typename T>
+inline constexpr size_t list_node_bytes = pmr::list<T>::node_size;
+
+template <typename T, size_t BucketSize = deque_default_bucket_size<T>>
+inline constexpr size_t deque_bucket_bytes = BucketSize * sizeof(T);
+
+
+
+/*
+    Bump allocator: the memory is taken from the upstream by chunks (every next chunk is
+    twice as large as the previous one), deallocate() does nothing, and all the memory is
+    returned to the upstream at once by release() or by the destructor.
+
+    Request-scoped containers can live in the arena: for trivially destructible T the
+    containers can be simply abandoned and the whole request memory is freed by release(),
+    without walking the elements.
+*/
+class monotonic_arena: public std::pmr::memory_resource{
+    struct ChunkHeader{
+        ChunkHeader* prev;
+        size_t size;
+    };
+
+    std::pmr::memory_resource* m_upstream;
+    ChunkHeader* m_last_chunk;
+    char* m_current;
+    char* m_end;
+    size_t m_next_chunk_size;
+    size_t m_initial_chunk_size;
+    size_t m_bytes_allocated;
+
+    static constexpr size_t chunk_alignment = alignof(std::max_align_t);
+    static constexpr size_t header_size = ((sizeof(ChunkHeader) + chunk_alignment - 1) / chunk_alignment) * chunk_alignment;
+
+    void add_chunk_(size_t min_size){
+        size_t size = std::max(m_next_chunk_size, min_size + header_size);
+        void* memory = m_upstream->allocate(size, chunk_alignment);
+        m_last_chunk = ::new (memory) ChunkHeader{m_last_chunk, size};
+        m_current = static_cast<char*>(memory) + header_size;
+        m_end = static_cast<char*>(memory) + size;
+        m_next_chunk_size = size * 2;
+    }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        size_t padding = (alignment - reinterpret_cast<std::uintptr_t>(m_current) % alignment) % alignment;
+        if (m_current == nullptr || static_cast<size_t>(m_end - m_current) < padding + bytes){
+            add_chunk_(bytes + alignment);
+            padding = (alignment - reinterpret_cast<std::uintptr_t>(m_current) % alignment) % alignment;
+        }
+        void* result = m_current + padding;
+        m_current += padding + bytes;
+        m_bytes_allocated += bytes;
+        return result;
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+public:
+    explicit monotonic_arena(size_t initial_chunk_size = 64 * 1024, std::pmr::memory_resource* upstream = std::pmr::get_default_resource()):
+        m_upstream(upstream),
+        m_last_chunk(nullptr),
+        m_current(nullptr),
+        m_end(nullptr),
+        m_next_chunk_size(std::max(initial_chunk_size, 2 * header_size)),
+        m_initial_chunk_size(m_next_chunk_size),
+        m_bytes_allocated(0)
+    {}
+
+    monotonic_arena(const monotonic_arena&) = delete;
+    monotonic_arena& operator=(const monotonic_arena&) = delete;
+
+    ~monotonic_arena() override {
+        release();
+    }
+
+    void release(){
+        while (m_last_chunk != nullptr){
+            ChunkHeader* prev = m_last_chunk->prev;
+            m_upstream->deallocate(m_last_chunk, m_last_chunk->size, chunk_alignment);
+            m_last_chunk = prev;
+        }
+        m_current = nullptr;
+        m_end = nullptr;
+        m_next_chunk_size = m_initial_chunk_size;
+        m_bytes_allocated = 0;
+    }
+
+    size_t bytes_allocated() const {return m_bytes_allocated;}
+
+    std::pmr::memory_resource* upstream_resource() const {return m_upstream;}
+};
+
+
+
+/*
+    Pool of the fixed-size blocks for the given block sizes (list_node_bytes<T>,
+    deque_bucket_bytes<T> ...): every block size has its own free list, and the blocks are
+    carved from the chunks of (blocks_per_chunk) blocks. Freed blocks are reused
+    by the next allocations of the same size. The requests of other sizes (e.g. the
+    bucket array of the deque, which grows) are passed to the upstream.
+    Not thread-safe (like std::pmr::unsynchronized_pool_resource).
+*/
+class pool_resource: public std::pmr::memory_resource{
+    struct FreeBlock{
+        FreeBlock* next;
+    };
+
+    struct Pool{
+        size_t block_size;
+        FreeBlock* free_list;
+    };
+
+    struct Chunk{
+        void* memory;
+        size_t size;
+    };
+
+    static constexpr size_t block_alignment = alignof(std::max_align_t);
+
+    std::pmr::memory_resource* m_upstream;
+    size_t m_blocks_per_chunk;
+    std::vector<Pool> m_pools;
+    std::vector<Chunk> m_chunks;
+
+    static size_t round_block_size_(size_t bytes){
+        size_t result = std::max(bytes, sizeof(FreeBlock));
+        return ((result + alignof(FreeBlock) - 1) / alignof(FreeBlock)) * alignof(FreeBlock);
+    }
+
+    Pool* find_pool_(size_t bytes, size_t alignment){
+        if (alignment > block_alignment) {return nullptr;}
+        size_t block_size = round_block_size_(bytes);
+        for (Pool& pool: m_pools){
+            if (pool.block_size == block_size && block_size % alignment == 0){
+                return &pool;
+            }
+        }
+        return nullptr;
+    }
+
+    void refill_(Pool& pool){
+        Chunk chunk{nullptr, pool.block_size * m_blocks_per_chunk};
+        m_chunks.reserve(m_chunks.size() + 1);
+        chunk.memory = m_upstream->allocate(chunk.size, block_alignment);
+        m_chunks.push_back(chunk);
+
+        char* block = static_cast<char*>(chunk.memory) + chunk.size;
+        for (size_t i = 0; i < m_blocks_per_chunk; ++i){
+            block -= pool.block_size;
+            pool.free_list = ::new (block) FreeBlock{pool.free_list};
+        }
+    }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        Pool* pool = find_pool_(bytes, alignment);
+        if (pool == nullptr){
+            return m_upstream->allocate(bytes, alignment);
+        }
+        if (pool->free_list == nullptr){
+            refill_(*pool);
+        }
+        FreeBlock* result = pool->free_list;
+        pool->free_list = result->next;
+        return result;
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        Pool* pool = find_pool_(bytes, alignment);
+        if (pool == nullptr){
+            m_upstream->deallocate(ptr, bytes, alignment);
+            return;
+        }
+        pool->free_list = ::new (ptr) FreeBlock{pool->free_list};
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+public:
+    pool_resource(
+        std::initializer_list<size_t> block_sizes,
+        size_t blocks_per_chunk = 256,
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource()
+    ):
+        m_upstream(upstream),
+        m_blocks_per_chunk(std::max<size_t>(blocks_per_chunk, 1))
+    {
+        for (size_t bytes: block_sizes){
+            size_t block_size = round_block_size_(bytes);
+            bool is_known = std::find_if(m_pools.begin(), m_pools.end(), [block_size](const Pool& pool){
+                return pool.block_size == block_size;
+            }) != m_pools.end();
+            if (!is_known){
+                m_pools.push_back({block_size, nullptr});
+            }
+        }
+    }
+
+    pool_resource(const pool_resource&) = delete;
+    pool_resource& operator=(const pool_resource&) = delete;
+
+    ~pool_resource() override {
+        release();
+    }
+
+    // returns all the chunks to the upstream (all the blocks, given by the pool, become invalid)
+    void release(){
+        for (Chunk& chunk: m_chunks){
+            m_upstream->deallocate(chunk.memory, chunk.size, block_alignment);
+        }
+        m_chunks.clear();
+        for (Pool& pool: m_pools){
+            pool.free_list = nullptr;
+        }
+    }
+
+    std::pmr::memory_resource* upstream_resource() const {return m_upstream;}
+};
+
+
+template <typename T>
+pool_resource make_list_pool(size_t nodes_per_chunk = 256, std::pmr::memory_resource* upstream = std::pmr::get_default_resource()){
+    return pool_resource({list_node_bytes<T>}, nodes_per_chunk, upstream);
+}
+
+template <typename T, size_t BucketSize = deque_default_bucket_size<T>>
+pool_resource make_deque_pool(size_t buckets_per_chunk = 16, std::pmr::memory_resource* upstream = std::pmr::get_default_resource()){
+    return pool_resource({deque_bucket_bytes<T, BucketSize>}, buckets_per_chunk, upstream);
+}
+
+} // end namespace pmr
+} // end namespace Farebl
+#endif // FAREBL_PMR_H
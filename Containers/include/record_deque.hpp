@@ -0,0 +1,347 @@
+#ifndef FAREBL_RECORD_DEQUE_H
+#define FAREBL_RECORD_DEQUE_H
+
+#include <algorithm>    // for max
+#include <cstddef>      // for size_t, ptrdiff_t
+#include <cstdint>      // for uint32_t
+#include <cstring>      // for memcpy, memmove
+#include <iterator>     // for forward_iterator_tag
+#include <limits>       // for numeric_limits
+#include <memory>       // for allocator, allocator_traits
+#include <stdexcept>    // for length_error
+#include <string_view>  // for string_view
+#include <utility>      // for exchange
+
+namespace Farebl {
+
+/*
+    Deque of variable-length records (byte strings), packed into the buckets of BucketBytes bytes:
+        [uint32_t length][bytes of the record][padding to 4 bytes][uint32_t length]...
+    The record, which doesn't fit into the rest of the last bucket, goes to the next bucket
+    (the record, which is longer than the bucket, gets its own bucket of the required size).
+    No allocation per record: the buckets are allocated only when the last one is full,
+    and one emptied bucket is kept as the spare for the next push_back.
+
+    Like Farebl::deque: the array of the buckets (m_buckets_ptr) with the used range
+    [m_first_bucket, m_last_bucket]; the records are added to the end and removed from the begin.
+    front()/back()/iteration give std::string_view into the buckets, which stay valid
+    until the record is popped (push_back never moves the records).
+*/
+template <typename Allocator = std::allocator<char>, size_t BucketBytes = 4096>
+class record_deque{
+    static_assert(BucketBytes >= 64 && BucketBytes % 4 == 0, "The bucket size must be a multiple of 4 and at least 64 bytes");
+
+    using length_type = uint32_t;
+    static constexpr size_t length_bytes_ = sizeof(length_type);
+
+    struct Bucket{
+        char* data;
+        size_t capacity; // BucketBytes, or more for the bucket of one long record
+        size_t used;     // bytes, occupied by the records
+    };
+
+public:
+    using value_type      = std::string_view;
+    using allocator_type  = typename std::allocator_traits<Allocator>::template rebind_alloc<char>;
+    using size_type       = size_t;
+    using difference_type = std::ptrdiff_t;
+
+    static constexpr size_type bucket_bytes = BucketBytes;
+    static constexpr size_type max_record_size = std::numeric_limits<length_type>::max() - 3;
+
+private:
+    using AllocatorBucket = typename std::allocator_traits<allocator_type>::template rebind_alloc<Bucket>;
+
+    Bucket* m_buckets_ptr;
+    size_type m_buckets_capacity;
+    size_type m_first_bucket;      // index of the bucket of front()
+    size_type m_last_bucket;       // index of the bucket of back()
+    size_type m_first_offset;      // offset of front() in its bucket
+    size_type m_last_offset;       // offset of back() in its bucket
+    size_type m_size;
+    Bucket m_spare;
+    allocator_type m_alloc;
+    AllocatorBucket m_alloc_bucket;
+
+    static size_type record_bytes_(size_type length){
+        return length_bytes_ + ((length + 3) & ~size_type(3));
+    }
+
+    static std::string_view record_at_(const Bucket& bucket, size_type offset){
+        length_type length;
+        std::memcpy(&length, bucket.data + offset, length_bytes_);
+        return {bucket.data + offset + length_bytes_, length};
+    }
+
+    Bucket take_bucket_(size_type min_capacity){
+        if (m_spare.data != nullptr && m_spare.capacity >= min_capacity){
+            Bucket result = m_spare;
+            m_spare = {nullptr, 0, 0};
+            return result;
+        }
+        size_type capacity = std::max(BucketBytes, min_capacity);
+        return {std::allocator_traits<allocator_type>::allocate(m_alloc, capacity), capacity, 0};
+    }
+
+    // the bucket of the standard size becomes the spare one (if there is no spare yet)
+    void release_bucket_(Bucket bucket){
+        if (m_spare.data == nullptr && bucket.capacity == BucketBytes){
+            m_spare = {bucket.data, bucket.capacity, 0};
+            return;
+        }
+        std::allocator_traits<allocator_type>::deallocate(m_alloc, bucket.data, bucket.capacity);
+    }
+
+    /*
+        Free slot after m_last_bucket: at first the used range is moved to the begin
+        of the bucket array (if the begin is free enough), otherwise the array is reallocated.
+    */
+    void make_slot_in_end_(){
+        if (m_last_bucket + 1 < m_buckets_capacity) {return;}
+        size_type used_buckets = m_last_bucket - m_first_bucket + 1;
+        if (m_first_bucket >= used_buckets){
+            std::memmove(static_cast<void*>(m_buckets_ptr), m_buckets_ptr + m_first_bucket, used_buckets * sizeof(Bucket));
+        }
+        else{
+            size_type new_capacity = std::max<size_type>(m_buckets_capacity * 2, 4);
+            Bucket* new_buckets_ptr = std::allocator_traits<AllocatorBucket>::allocate(m_alloc_bucket, new_capacity);
+            std::memcpy(static_cast<void*>(new_buckets_ptr), m_buckets_ptr + m_first_bucket, used_buckets * sizeof(Bucket));
+            std::allocator_traits<AllocatorBucket>::deallocate(m_alloc_bucket, m_buckets_ptr, m_buckets_capacity);
+            m_buckets_ptr = new_buckets_ptr;
+            m_buckets_capacity = new_capacity;
+        }
+        m_first_bucket = 0;
+        m_last_bucket = used_buckets - 1;
+    }
+
+    void free_all_(){
+        if (m_buckets_ptr != nullptr){
+            for (size_type i = m_first_bucket; i <= m_last_bucket; ++i){
+                std::allocator_traits<allocator_type>::deallocate(m_alloc, m_buckets_ptr[i].data, m_buckets_ptr[i].capacity);
+            }
+            std::allocator_traits<AllocatorBucket>::deallocate(m_alloc_bucket, m_buckets_ptr, m_buckets_capacity);
+        }
+        if (m_spare.data != nullptr){
+            std::allocator_traits<allocator_type>::deallocate(m_alloc, m_spare.data, m_spare.capacity);
+        }
+        m_buckets_ptr = nullptr;
+        m_buckets_capacity = 0;
+        m_first_bucket = m_last_bucket = m_first_offset = m_last_offset = m_size = 0;
+        m_spare = {nullptr, 0, 0};
+    }
+
+public:
+    class const_iterator{
+        friend class record_deque;
+
+        const Bucket* m_bucket_ptr;
+        const Bucket* m_last_bucket_ptr;
+        size_type m_offset;
+
+        const_iterator(const Bucket* bucket_ptr, const Bucket* last_bucket_ptr, size_type offset):
+            m_bucket_ptr(bucket_ptr), m_last_bucket_ptr(last_bucket_ptr), m_offset(offset){}
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = std::string_view;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const std::string_view*;
+        using reference         = std::string_view;
+
+        const_iterator(): m_bucket_ptr(nullptr), m_last_bucket_ptr(nullptr), m_offset(0){}
+
+        std::string_view operator*() const {return record_at_(*m_bucket_ptr, m_offset);}
+
+        const_iterator& operator++(){
+            length_type length;
+            std::memcpy(&length, m_bucket_ptr->data + m_offset, length_bytes_);
+            m_offset += record_bytes_(length);
+            if (m_offset == m_bucket_ptr->used && m_bucket_ptr != m_last_bucket_ptr){
+                ++m_bucket_ptr;
+                m_offset = 0;
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int){
+            const_iterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+
+        bool operator==(const const_iterator& other) const {return m_bucket_ptr == other.m_bucket_ptr && m_offset == other.m_offset;}
+        bool operator!=(const const_iterator& other) const {return !(*this == other);}
+    };
+
+    using iterator = const_iterator;
+
+
+    record_deque(): record_deque(Allocator()){}
+
+    explicit record_deque(const Allocator& alloc):
+        m_buckets_ptr(nullptr),
+        m_buckets_capacity(0),
+        m_first_bucket(0),
+        m_last_bucket(0),
+        m_first_offset(0),
+        m_last_offset(0),
+        m_size(0),
+        m_spare{nullptr, 0, 0},
+        m_alloc(alloc),
+        m_alloc_bucket(m_alloc)
+    {}
+
+    record_deque(const record_deque&) = delete;
+    record_deque& operator=(const record_deque&) = delete;
+
+    record_deque(record_deque&& other) noexcept:
+        m_buckets_ptr(std::exchange(other.m_buckets_ptr, nullptr)),
+        m_buckets_capacity(std::exchange(other.m_buckets_capacity, 0)),
+        m_first_bucket(std::exchange(other.m_first_bucket, 0)),
+        m_last_bucket(std::exchange(other.m_last_bucket, 0)),
+        m_first_offset(std::exchange(other.m_first_offset, 0)),
+        m_last_offset(std::exchange(other.m_last_offset, 0)),
+        m_size(std::exchange(other.m_size, 0)),
+        m_spare(std::exchange(other.m_spare, Bucket{nullptr, 0, 0})),
+        m_alloc(other.m_alloc),
+        m_alloc_bucket(other.m_alloc_bucket)
+    {}
+
+    ~record_deque(){
+        free_all_();
+    }
+
+
+    bool empty() const {return m_size == 0;}
+
+    size_type size() const {return m_size;}
+
+    // bytes of the buckets (with the spare one) and of the bucket array
+    size_type memory_usage() const {
+        size_type result = m_buckets_capacity * sizeof(Bucket) + m_spare.capacity;
+        if (m_buckets_ptr != nullptr){
+            for (size_type i = m_first_bucket; i <= m_last_bucket; ++i){
+                result += m_buckets_ptr[i].capacity;
+            }
+        }
+        return result;
+    }
+
+
+    std::string_view front() const {return record_at_(m_buckets_ptr[m_first_bucket], m_first_offset);}
+
+    std::string_view back() const {return record_at_(m_buckets_ptr[m_last_bucket], m_last_offset);}
+
+
+    const_iterator begin() const {
+        if (m_size == 0) {return end();}
+        return {m_buckets_ptr + m_first_bucket, m_buckets_ptr + m_last_bucket, m_first_offset};
+    }
+    const_iterator cbegin() const {return begin();}
+
+    const_iterator end() const {
+        if (m_buckets_ptr == nullptr) {return {};}
+        return {m_buckets_ptr + m_last_bucket, m_buckets_ptr + m_last_bucket, m_buckets_ptr[m_last_bucket].used};
+    }
+    const_iterator cend() const {return end();}
+
+
+    /*
+        Appends the record of (length) bytes and returns the pointer to its bytes,
+        which the caller fills (e.g. formats the log line straight into the bucket).
+    */
+    char* append_back(size_type length){
+        if (length > max_record_size) {throw std::length_error("Farebl::record_deque: the record is too long");}
+        size_type record_bytes = record_bytes_(length);
+
+        if (m_buckets_ptr == nullptr){
+            Bucket bucket = take_bucket_(record_bytes);
+            try{
+                m_buckets_capacity = 4;
+                m_buckets_ptr = std::allocator_traits<AllocatorBucket>::allocate(m_alloc_bucket, m_buckets_capacity);
+            }
+            catch(...){
+                m_buckets_capacity = 0;
+                release_bucket_(bucket);
+                throw;
+            }
+            m_first_bucket = m_last_bucket = 0;
+            m_buckets_ptr[0] = bucket;
+        }
+        else if (m_buckets_ptr[m_last_bucket].capacity - m_buckets_ptr[m_last_bucket].used < record_bytes){
+            if (m_size == 0){
+                // the kept empty bucket is too small for this record
+                Bucket bucket = take_bucket_(record_bytes);
+                release_bucket_(m_buckets_ptr[m_last_bucket]);
+                m_buckets_ptr[m_last_bucket] = bucket;
+            }
+            else{
+                make_slot_in_end_();
+                m_buckets_ptr[m_last_bucket + 1] = take_bucket_(record_bytes);
+                ++m_last_bucket;
+            }
+        }
+
+        Bucket& bucket = m_buckets_ptr[m_last_bucket];
+        length_type stored_length = static_cast<length_type>(length);
+        std::memcpy(bucket.data + bucket.used, &stored_length, length_bytes_);
+        m_last_offset = bucket.used;
+        bucket.used += record_bytes;
+        if (m_size == 0){
+            m_first_bucket = m_last_bucket;
+            m_first_offset = m_last_offset;
+        }
+        ++m_size;
+        return bucket.data + m_last_offset + length_bytes_;
+    }
+
+    void push_back(const void* data, size_type length){
+        char* destination = append_back(length);
+        if (length != 0) {std::memcpy(destination, data, length);}
+    }
+
+    void push_back(std::string_view record){
+        push_back(record.data(), record.size());
+    }
+
+    void pop_front(){
+        if (m_size == 0) {return;}
+        --m_size;
+        if (m_size == 0){
+            // the last bucket stays for the next records
+            for (size_type i = m_first_bucket; i < m_last_bucket; ++i){
+                release_bucket_(m_buckets_ptr[i]);
+            }
+            m_buckets_ptr[0] = m_buckets_ptr[m_last_bucket];
+            m_buckets_ptr[0].used = 0;
+            m_first_bucket = m_last_bucket = m_first_offset = m_last_offset = 0;
+            return;
+        }
+        m_first_offset += record_bytes_(front().size());
+        if (m_first_offset == m_buckets_ptr[m_first_bucket].used){
+            release_bucket_(m_buckets_ptr[m_first_bucket]);
+            ++m_first_bucket;
+            m_first_offset = 0;
+        }
+    }
+
+    void clear(){
+        if (m_size == 0) {return;}
+        m_size = 1; // the last pop_front releases all the buckets except the last one
+        pop_front();
+    }
+
+    void shrink_to_fit(){
+        if (m_size == 0){
+            free_all_();
+            return;
+        }
+        if (m_spare.data != nullptr){
+            std::allocator_traits<allocator_type>::deallocate(m_alloc, m_spare.data, m_spare.capacity);
+            m_spare = {nullptr, 0, 0};
+        }
+    }
+};
+
+} // end namespace Farebl
+#endif // FAREBL_RECORD_DEQUE_H
@@ -0,0 +1,256 @@
+#ifndef FAREBL_SERIALIZATION_H
+#define FAREBL_SERIALIZATION_H
+
+#include <algorithm>     // for min
+#include <cerrno>        // for errno, EINTR
+#include <climits>       // for IOV_MAX
+#include <cstddef>       // for size_t
+#include <cstdint>       // for uint64_t, SIZE_MAX
+#include <cstring>       // for memcpy
+#include <new>           // for launder
+#include <stdexcept>     // for runtime_error
+#include <system_error>  // for system_error, generic_category
+#include <type_traits>   // for is_trivially_copyable
+#include <vector>        // for vector
+
+#include <sys/stat.h>    // for fstat, S_ISREG
+#include <sys/uio.h>     // for iovec, writev, readv
+#include <unistd.h>      // for lseek
+
+#include "deque.hpp"
+#include "list.hpp"
+
+namespace Farebl {
+namespace serialization {
+
+/*
+    Binary format (the same for the deque and the list, so the data, written from one of them,
+    can be read into the other):
+        [Header: count of the elements, sizeof(T)][count * sizeof(T) bytes of the elements]
+    Only for trivially copyable T; the byte order and the layout of T are those of the writer.
+*/
+struct Header{
+    uint64_t count;
+    uint64_t value_size;
+};
+
+
+namespace detail {
+
+#ifdef IOV_MAX
+    constexpr size_t max_iovecs = IOV_MAX;
+#else
+    constexpr size_t max_iovecs = 1024;
+#endif
+
+    // drops (bytes) bytes from the beginning of the array, returns the new beginning
+    inline iovec* skip_bytes(iovec* first, iovec* last, size_t bytes){
+        while (first != last && bytes >= first->iov_len){
+            bytes -= first->iov_len;
+            ++first;
+        }
+        if (first != last){
+            first->iov_base = static_cast<char*>(first->iov_base) + bytes;
+            first->iov_len -= bytes;
+        }
+        return first;
+    }
+
+    // writes the whole array (repeats writev after the partial writes and EINTR)
+    inline void write_all(int fd, iovec* first, iovec* last){
+        while (first != last){
+            int count = static_cast<int>(std::min<size_t>(last - first, max_iovecs));
+            ssize_t written = ::writev(fd, first, count);
+            if (written < 0){
+                if (errno == EINTR) {continue;}
+                throw std::system_error(errno, std::generic_category(), "Farebl::serialization: writev");
+            }
+            first = skip_bytes(first, last, static_cast<size_t>(written));
+        }
+    }
+
+    // fills the whole array (repeats readv after the partial reads and EINTR)
+    inline void read_all(int fd, iovec* first, iovec* last){
+        while (first != last){
+            int count = static_cast<int>(std::min<size_t>(last - first, max_iovecs));
+            ssize_t was_read = ::readv(fd, first, count);
+            if (was_read < 0){
+                if (errno == EINTR) {continue;}
+                throw std::system_error(errno, std::generic_category(), "Farebl::serialization: readv");
+            }
+            if (was_read == 0){
+                throw std::runtime_error("Farebl::serialization: unexpected end of the data");
+            }
+            first = skip_bytes(first, last, static_cast<size_t>(was_read));
+        }
+    }
+
+    // bytes of the regular file after the current offset; SIZE_MAX, if the length isn't known (a pipe, a socket)
+    inline size_t bytes_left(int fd){
+        struct stat file_stat;
+        if (::fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {return SIZE_MAX;}
+        off_t offset = ::lseek(fd, 0, SEEK_CUR);
+        if (offset < 0) {return SIZE_MAX;}
+        return (offset < file_stat.st_size) ? static_cast<size_t>(file_stat.st_size - offset) : 0;
+    }
+
+    /*
+        The count of the header comes from the untrusted data: it is checked against the rest
+        of the file before anything is allocated for it (and against the overflow of its bytes)
+    */
+    template <typename T>
+    Header read_header(int fd){
+        Header header;
+        iovec header_iovec{&header, sizeof(header)};
+        read_all(fd, &header_iovec, &header_iovec + 1);
+        if (header.value_size != sizeof(T)){
+            throw std::runtime_error("Farebl::serialization: the size of the elements doesn't match");
+        }
+        if (header.count > bytes_left(fd) / sizeof(T)){
+            throw std::runtime_error("Farebl::serialization: the count of the elements exceeds the data");
+        }
+        return header;
+    }
+
+    constexpr size_t list_buffer_bytes = 64 * 1024;
+
+    // the data of the unknown length is read into the deque by the chunks of this size
+    constexpr size_t stream_chunk_bytes = 4 * 1024 * 1024;
+
+} // end namespace detail
+
+
+
+/*
+    The iovec array, which describes the elements of the deque without copying:
+    one entry per segment (contiguous run of the elements inside one bucket).
+    The array is valid until the deque is modified.
+*/
+template <typename T, typename Allocator, size_t BucketSize>
+std::vector<iovec> segments_iovecs(const deque<T, Allocator, BucketSize>& d){
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable elements can be serialized");
+    std::vector<iovec> result;
+    result.reserve(d.segment_count());
+    for (size_t i = 0; i < d.segment_count(); ++i){
+        auto segment = d.get_segment(i);
+        result.push_back({const_cast<T*>(segment.first), segment.size() * sizeof(T)});
+    }
+    return result;
+}
+
+
+// one writev (per IOV_MAX segments) straight from the buckets
+template <typename T, typename Allocator, size_t BucketSize>
+void write(int fd, const deque<T, Allocator, BucketSize>& d){
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable elements can be serialized");
+    Header header{d.size(), sizeof(T)};
+    std::vector<iovec> iovecs;
+    iovecs.reserve(d.segment_count() + 1);
+    iovecs.push_back({&header, sizeof(header)});
+    for (size_t i = 0; i < d.segment_count(); ++i){
+        auto segment = d.get_segment(i);
+        iovecs.push_back({const_cast<T*>(segment.first), segment.size() * sizeof(T)});
+    }
+    detail::write_all(fd, iovecs.data(), iovecs.data() + iovecs.size());
+}
+
+
+/*
+    Appends the elements to the back of the deque: the buckets are reserved in one step
+    and filled by readv directly (without the intermediate buffer). The length of a pipe
+    or a socket isn't known in advance, so from them the buckets are reserved and filled
+    by the chunks of detail::stream_chunk_bytes, as the data arrives.
+    If reading fails, the deque stays unchanged (the reserved buckets stay allocated).
+*/
+template <typename T, typename Allocator, size_t BucketSize>
+void read(int fd, deque<T, Allocator, BucketSize>& d){
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable elements can be serialized");
+    Header header = detail::read_header<T>(fd);
+    size_t count = static_cast<size_t>(header.count);
+    if (count == 0) {return;}
+    size_t step = (detail::bytes_left(fd) == SIZE_MAX) ? std::max<size_t>(detail::stream_chunk_bytes / sizeof(T), 1) : count;
+
+    size_t old_size = d.size();
+    std::vector<iovec> iovecs;
+    try{
+        for (size_t done = 0; done != count;){
+            size_t chunk = std::min(step, count - done);
+            d.reserve_back(chunk);
+            iovecs.clear();
+            size_t rest = chunk;
+            for (size_t i = 0; rest != 0; ++i){
+                auto segment = d.spare_back_segment(i);
+                size_t run = std::min(rest, segment.size());
+                iovecs.push_back({segment.first, run * sizeof(T)});
+                rest -= run;
+            }
+            detail::read_all(fd, iovecs.data(), iovecs.data() + iovecs.size());
+            d.commit_back(chunk);
+            done += chunk;
+        }
+    }
+    catch(...){
+        d.erase(d.cbegin() + old_size, d.cend());
+        throw;
+    }
+}
+
+
+/*
+    The nodes of the list aren't contiguous (and one iovec per element is more expensive
+    than copying of the small elements), so the elements are packed into the buffer
+    of detail::list_buffer_bytes bytes, which is written by one writev.
+*/
+template <typename T, typename Allocator>
+void write(int fd, const list<T, Allocator>& l){
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable elements can be serialized");
+    Header header{l.size(), sizeof(T)};
+    std::vector<char> buffer(std::max(detail::list_buffer_bytes, sizeof(T)));
+    size_t buffer_used = 0;
+    bool is_header_written = false;
+
+    auto flush_buffer = [&](){
+        iovec iovecs[2] = {{&header, sizeof(header)}, {buffer.data(), buffer_used}};
+        iovec* first = is_header_written ? (iovecs + 1) : iovecs;
+        detail::write_all(fd, first, iovecs + 2);
+        is_header_written = true;
+        buffer_used = 0;
+    };
+
+    for (const T& value: l){
+        if (buffer_used + sizeof(T) > buffer.size()){
+            flush_buffer();
+        }
+        std::memcpy(buffer.data() + buffer_used, &value, sizeof(T));
+        buffer_used += sizeof(T);
+    }
+    flush_buffer();
+}
+
+
+// appends the elements to the back of the list
+template <typename T, typename Allocator>
+void read(int fd, list<T, Allocator>& l){
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable elements can be serialized");
+    Header header = detail::read_header<T>(fd);
+    size_t rest = static_cast<size_t>(header.count);
+    size_t buffer_capacity = std::max<size_t>(detail::list_buffer_bytes / sizeof(T), 1);
+    std::vector<char> buffer(std::min(rest, buffer_capacity) * sizeof(T));
+
+    while (rest != 0){
+        size_t run = std::min(rest, buffer_capacity);
+        iovec buffer_iovec{buffer.data(), run * sizeof(T)};
+        detail::read_all(fd, &buffer_iovec, &buffer_iovec + 1);
+        for (size_t i = 0; i < run; ++i){
+            // T may have no default constructor: the bytes are copied into the storage of T
+            alignas(T) unsigned char storage[sizeof(T)];
+            std::memcpy(storage, buffer.data() + i * sizeof(T), sizeof(T));
+            l.push_back(*std::launder(reinterpret_cast<T*>(storage)));
+        }
+        rest -= run;
+    }
+}
+
+} // end namespace serialization
+} // end namespace Farebl
+#endif // FAREBL_SERIALIZATION_H
@@ -0,0 +1,269 @@
+#ifndef FAREBL_SLOT_MAP_H
+#define FAREBL_SLOT_MAP_H
+
+#include <algorithm>    // for max
+#include <cstddef>      // for size_t, ptrdiff_t
+#include <cstdint>      // for uint32_t
+#include <iterator>     // for forward_iterator_tag
+#include <limits>       // for numeric_limits
+#include <memory>       // for allocator, allocator_traits
+#include <new>          // for placement new, launder
+#include <stdexcept>    // for length_error
+#include <type_traits>  // for conditional
+#include <utility>      // for forward
+
+#include "deque.hpp"
+
+namespace Farebl {
+
+/*
+    Container with the stable handles: insert, erase and lookup by the handle are O(1),
+    the elements never move (the slots live in Farebl::deque, which doesn't relocate
+    its elements on push_back), erase leaves a hole instead of shifting the elements.
+
+    - every slot has the generation counter, which is incremented by erase, so the handle
+      of the erased element (index, generation) is recognized as stale;
+    - the holes form the runs; the first and the last slot of the run store its length
+      (the skip field: 0 - the live slot), so the iteration jumps over the whole run at once;
+    - the runs are linked into the free list (through the storage of their first slots),
+      insert takes the first slot of the first run.
+*/
+template <typename T, typename Allocator = std::allocator<T>>
+class slot_map{
+public:
+    struct handle{
+        uint32_t index;
+        uint32_t generation;
+
+        bool operator==(const handle& other) const {return index == other.index && generation == other.generation;}
+        bool operator!=(const handle& other) const {return !(*this == other);}
+    };
+
+private:
+    static constexpr uint32_t no_index_ = std::numeric_limits<uint32_t>::max();
+
+    struct FreeLinks{
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    struct Slot{
+        alignas(T) alignas(FreeLinks) unsigned char storage[std::max(sizeof(T), sizeof(FreeLinks))];
+        uint32_t generation;
+        uint32_t skip; // 0 - the slot is live; otherwise (in the first and the last slot of the run) - length of the run of holes
+    };
+
+    using AllocatorSlot = typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+    using Slots = deque<Slot, AllocatorSlot>;
+    using AllocatorT = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+
+    Slots m_slots;
+    uint32_t m_free_head; // first slot of the first run of holes
+    size_t m_size;
+    AllocatorT m_alloc;
+
+    T* value_ptr_(uint32_t index) const {
+        return std::launder(reinterpret_cast<T*>(const_cast<unsigned char*>(m_slots[index].storage)));
+    }
+
+    FreeLinks& links_(uint32_t index){
+        return *std::launder(reinterpret_cast<FreeLinks*>(m_slots[index].storage));
+    }
+
+    void link_run_(uint32_t first){
+        ::new (static_cast<void*>(m_slots[first].storage)) FreeLinks{no_index_, m_free_head};
+        if (m_free_head != no_index_) {links_(m_free_head).prev = first;}
+        m_free_head = first;
+    }
+
+    void unlink_run_(uint32_t first){
+        FreeLinks links = links_(first);
+        if (links.prev != no_index_) {links_(links.prev).next = links.next;}
+        else {m_free_head = links.next;}
+        if (links.next != no_index_) {links_(links.next).prev = links.prev;}
+    }
+
+    void set_run_(uint32_t first, uint32_t length){
+        m_slots[first].skip = length;
+        m_slots[first + length - 1].skip = length;
+    }
+
+    // index of the live slot, starting from (index) and jumping over the holes
+    uint32_t skip_holes_(uint32_t index) const {
+        if (index < m_slots.size()) {index += m_slots[index].skip;}
+        return index;
+    }
+
+    // the slot for the new element: the first slot of the first run of holes or the new slot at the end
+    uint32_t take_slot_(){
+        if (m_free_head == no_index_){
+            if (m_slots.size() >= no_index_) {throw std::length_error("Farebl::slot_map: too many slots");}
+            m_slots.push_back(Slot{{}, 0, 0});
+            return static_cast<uint32_t>(m_slots.size() - 1);
+        }
+        uint32_t first = m_free_head;
+        uint32_t length = m_slots[first].skip;
+        unlink_run_(first);
+        if (length > 1){
+            set_run_(first + 1, length - 1);
+            link_run_(first + 1);
+        }
+        m_slots[first].skip = 0;
+        return first;
+    }
+
+    // the slot (not live anymore) becomes the hole and is merged with the neighbouring runs
+    void release_slot_(uint32_t index){
+        uint32_t left_length = (index > 0) ? m_slots[index - 1].skip : 0;
+        uint32_t right_length = (index + 1 < m_slots.size()) ? m_slots[index + 1].skip : 0;
+        if (right_length != 0){
+            unlink_run_(index + 1);
+        }
+        if (left_length != 0){
+            set_run_(index - left_length, left_length + 1 + right_length);
+        }
+        else{
+            set_run_(index, 1 + right_length);
+            link_run_(index);
+        }
+    }
+
+    template <bool IsConst = false>
+    class base_iterator{
+        friend class slot_map;
+        using map_pointer = typename std::conditional<IsConst, const slot_map*, slot_map*>::type;
+
+        map_pointer m_map;
+        uint32_t m_index;
+
+        base_iterator(map_pointer map, uint32_t index): m_map(map), m_index(index){}
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = typename std::conditional<IsConst, const T*, T*>::type;
+        using reference         = typename std::conditional<IsConst, const T&, T&>::type;
+
+        base_iterator(): m_map(nullptr), m_index(0){}
+
+        operator base_iterator<true>() const {return {m_map, m_index};}
+
+        reference operator*() const {return *m_map->value_ptr_(m_index);}
+        pointer operator->() const {return m_map->value_ptr_(m_index);}
+
+        handle get_handle() const {return {m_index, m_map->m_slots[m_index].generation};}
+
+        base_iterator& operator++(){
+            m_index = m_map->skip_holes_(m_index + 1);
+            return *this;
+        }
+
+        base_iterator operator++(int){
+            base_iterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+
+        bool operator==(const base_iterator& other) const {return m_index == other.m_index;}
+        bool operator!=(const base_iterator& other) const {return m_index != other.m_index;}
+    };
+
+public:
+    using value_type      = T;
+    using size_type       = size_t;
+    using reference       = T&;
+    using const_reference = const T&;
+    using iterator        = base_iterator<false>;
+    using const_iterator  = base_iterator<true>;
+
+    slot_map(): slot_map(Allocator()){}
+
+    explicit slot_map(const Allocator& alloc):
+        m_slots(AllocatorSlot(alloc)),
+        m_free_head(no_index_),
+        m_size(0),
+        m_alloc(alloc)
+    {}
+
+    slot_map(const slot_map&) = delete;
+    slot_map& operator=(const slot_map&) = delete;
+
+    ~slot_map(){
+        clear();
+    }
+
+
+    bool empty() const {return m_size == 0;}
+
+    size_type size() const {return m_size;}
+
+    // count of the slots (live ones and holes)
+    size_type slot_count() const {return m_slots.size();}
+
+
+    template <class... Args>
+    handle emplace(Args&&... args){
+        uint32_t index = take_slot_();
+        try{
+            std::allocator_traits<AllocatorT>::construct(m_alloc, value_ptr_(index), std::forward<Args>(args)...);
+        }
+        catch(...){
+            release_slot_(index);
+            throw;
+        }
+        ++m_size;
+        return {index, m_slots[index].generation};
+    }
+
+    handle insert(const T& value) {return emplace(value);}
+    handle insert(T&& value) {return emplace(std::move(value));}
+
+    bool contains(handle h) const {
+        return h.index < m_slots.size() && m_slots[h.index].skip == 0 && m_slots[h.index].generation == h.generation;
+    }
+
+    // nullptr for the stale handle
+    T* get(handle h) {return contains(h) ? value_ptr_(h.index) : nullptr;}
+    const T* get(handle h) const {return contains(h) ? value_ptr_(h.index) : nullptr;}
+
+    // without the check of the handle
+    reference operator[](handle h) {return *value_ptr_(h.index);}
+    const_reference operator[](handle h) const {return *value_ptr_(h.index);}
+
+    // false for the stale handle
+    bool erase(handle h){
+        if (!contains(h)) {return false;}
+        std::allocator_traits<AllocatorT>::destroy(m_alloc, value_ptr_(h.index));
+        ++m_slots[h.index].generation;
+        release_slot_(h.index);
+        --m_size;
+        return true;
+    }
+
+    iterator erase(iterator pos){
+        iterator next = pos;
+        ++next;
+        erase(pos.get_handle());
+        return next;
+    }
+
+    // the slots stay (with the incremented generations), so the old handles stay stale
+    void clear(){
+        for (iterator it = begin(); it != end(); ){
+            it = erase(it);
+        }
+    }
+
+
+    iterator begin() {return {this, skip_holes_(0)};}
+    const_iterator begin() const {return {this, skip_holes_(0)};}
+    const_iterator cbegin() const {return begin();}
+
+    iterator end() {return {this, static_cast<uint32_t>(m_slots.size())};}
+    const_iterator end() const {return {this, static_cast<uint32_t>(m_slots.size())};}
+    const_iterator cend() const {return end();}
+};
+
+} // end namespace Farebl
+#endif // FAREBL_SLOT_MAP_H
@@ -0,0 +1,402 @@
+#ifndef FAREBL_SMALL_DEQUE_H
+#define FAREBL_SMALL_DEQUE_H
+
+#include <algorithm>    // for min
+#include <cstddef>      // for size_t, ptrdiff_t
+#include <iterator>     // for random_access_iterator_tag, make_move_iterator
+#include <memory>       // for allocator, allocator_traits
+#include <new>          // for placement new, launder
+#include <stdexcept>    // for out_of_range
+#include <type_traits>  // for conditional, is_nothrow_move_constructible
+#include <utility>      // for move, forward
+
+#include "deque.hpp"
+
+namespace Farebl {
+
+/*
+    Deque with the inline storage for the first InlineN elements:
+    while size() <= InlineN, the elements live in the ring buffer inside the object,
+    and nothing is allocated (neither the bucket array nor the buckets).
+    The push, which exceeds InlineN, moves the elements into Farebl::deque (the "spilled" state);
+    the deque stays spilled (keeping its buckets for reuse) until shrink_to_fit() or clear()
+    brings the elements back to the inline storage.
+    The spilled deque is constructed only by the spill, in the place of the inline storage
+    (they never live at the same time), so the object is max(InlineN * sizeof(T), sizeof(deque))
+    plus the counters, not their sum.
+
+    Unlike Farebl::deque the iterators are (container, index) pairs: they are invalidated
+    by the spill and by the return to the inline storage.
+*/
+template <typename T, size_t InlineN = 16, typename Allocator = std::allocator<T>, size_t BucketSize = deque_default_bucket_size<T>>
+class small_deque{
+    static_assert(InlineN > 0, "The inline capacity must be 1 or greater");
+
+public:
+    using value_type      = T;
+    using allocator_type  = Allocator;
+    using size_type       = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference       = T&;
+    using const_reference = const T&;
+    using spilled_type    = deque<T, Allocator, BucketSize>;
+
+    static constexpr size_type inline_capacity = InlineN;
+
+private:
+    template <bool IsConst = false>
+    class base_iterator{
+        friend class small_deque;
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = typename std::conditional<IsConst, const T*, T*>::type;
+        using reference         = typename std::conditional<IsConst, const T&, T&>::type;
+
+    private:
+        using container_pointer = typename std::conditional<IsConst, const small_deque*, small_deque*>::type;
+        container_pointer m_container;
+        difference_type m_index;
+
+        base_iterator(container_pointer container, difference_type index): m_container(container), m_index(index){}
+
+    public:
+        base_iterator(): m_container(nullptr), m_index(0){}
+
+        base_iterator(const base_iterator&) = default;
+        base_iterator& operator=(const base_iterator&) = default;
+
+        operator base_iterator<true>() const {return {m_container, m_index};}
+
+        reference operator*() const {return (*m_container)[m_index];}
+        pointer operator->() const {return &(*m_container)[m_index];}
+        reference operator[](difference_type value) const {return (*m_container)[m_index + value];}
+
+        base_iterator& operator++(){++m_index; return *this;}
+        base_iterator operator++(int){base_iterator temp = *this; ++m_index; return temp;}
+        base_iterator& operator--(){--m_index; return *this;}
+        base_iterator operator--(int){base_iterator temp = *this; --m_index; return temp;}
+
+        base_iterator& operator+=(difference_type value){m_index += value; return *this;}
+        base_iterator& operator-=(difference_type value){m_index -= value; return *this;}
+        base_iterator operator+(difference_type value) const {return {m_container, m_index + value};}
+        friend base_iterator operator+(difference_type value, const base_iterator& it){return it + value;}
+        base_iterator operator-(difference_type value) const {return {m_container, m_index - value};}
+        difference_type operator-(const base_iterator& other) const {return m_index - other.m_index;}
+
+        bool operator==(const base_iterator& other) const {return m_index == other.m_index;}
+        bool operator!=(const base_iterator& other) const {return m_index != other.m_index;}
+        bool operator<(const base_iterator& other) const {return m_index < other.m_index;}
+        bool operator>(const base_iterator& other) const {return m_index > other.m_index;}
+        bool operator<=(const base_iterator& other) const {return m_index <= other.m_index;}
+        bool operator>=(const base_iterator& other) const {return m_index >= other.m_index;}
+    };
+
+public:
+    using iterator       = base_iterator<false>;
+    using const_iterator = base_iterator<true>;
+
+private:
+    union{
+        alignas(T) unsigned char m_inline[InlineN * sizeof(T)];
+        spilled_type m_spilled; // alive only while (m_is_spilled)
+    };
+    size_type m_inline_first; // ring index of the first inline element
+    size_type m_inline_size;
+    bool m_is_spilled;
+    Allocator m_alloc;        // for the spilled deque, which doesn't exist in the inline state
+
+    T* inline_ptr_(size_type ring_index) const {
+        return std::launder(reinterpret_cast<T*>(const_cast<unsigned char*>(m_inline)) + ring_index);
+    }
+
+    static size_type ring_index_(size_type index){
+        return (index >= InlineN) ? (index - InlineN) : index;
+    }
+
+    T* inline_element_ptr_(size_type pos) const {
+        return inline_ptr_(ring_index_(m_inline_first + pos));
+    }
+
+    void destroy_inline_(){
+        for (size_type i = 0; i < m_inline_size; ++i){
+            inline_element_ptr_(i)->~T();
+        }
+        m_inline_first = 0;
+        m_inline_size = 0;
+    }
+
+    // destroys the elements (and the spilled deque with its buckets): *this becomes inline and empty
+    void destroy_all_(){
+        if (m_is_spilled){
+            m_spilled.~spilled_type();
+            m_is_spilled = false;
+            m_inline_first = 0;
+            m_inline_size = 0;
+        }
+        else{
+            destroy_inline_();
+        }
+    }
+
+    // the spilled deque takes the place of the inline storage (the move of the deque doesn't throw)
+    void become_spilled_(spilled_type&& spilled) noexcept {
+        ::new (static_cast<void*>(&m_spilled)) spilled_type(std::move(spilled));
+        m_is_spilled = true;
+    }
+
+    // moves the inline elements to the back of the new deque, reserving the place for (extra_count) more
+    void spill_(size_type extra_count){
+        spilled_type spilled(m_alloc);
+        spilled.reserve_back(m_inline_size + extra_count);
+        size_type first_run = std::min(m_inline_size, InlineN - m_inline_first);
+        spilled.push_back_n(std::make_move_iterator(inline_ptr_(m_inline_first)), first_run);
+        spilled.push_back_n(std::make_move_iterator(inline_ptr_(0)), m_inline_size - first_run);
+        destroy_inline_();
+        become_spilled_(std::move(spilled));
+    }
+
+    // moves the elements back to the inline storage (size() <= InlineN)
+    void unspill_(){
+        spilled_type spilled(std::move(m_spilled));
+        m_spilled.~spilled_type();
+        m_is_spilled = false;
+        m_inline_first = 0;
+        m_inline_size = 0;
+        try{
+            for (; m_inline_size < spilled.size(); ++m_inline_size){
+                ::new (static_cast<void*>(inline_ptr_(m_inline_size))) T(std::move(spilled[m_inline_size]));
+            }
+        }
+        catch(...){
+            destroy_inline_();
+            become_spilled_(std::move(spilled));
+            throw;
+        }
+    }
+
+    // *this is inline and empty; the elements of (other) are copied, its state (inline or spilled) is kept
+    void copy_from_(const small_deque& other){
+        if (other.m_is_spilled){
+            become_spilled_(spilled_type(other.m_spilled, m_alloc));
+            return;
+        }
+        try{
+            for (; m_inline_size < other.m_inline_size; ++m_inline_size){
+                ::new (static_cast<void*>(inline_ptr_(m_inline_size))) T(*other.inline_element_ptr_(m_inline_size));
+            }
+        }
+        catch(...){
+            destroy_inline_();
+            throw;
+        }
+    }
+
+    /*
+        *this is inline and empty; the spilled deque of (other) is stolen (if the allocators are equal),
+        the inline elements are moved one by one. (other) becomes inline and empty.
+    */
+    void move_from_(small_deque& other){
+        if (other.m_is_spilled){
+            become_spilled_(spilled_type(std::move(other.m_spilled), m_alloc));
+        }
+        else{
+            try{
+                for (; m_inline_size < other.m_inline_size; ++m_inline_size){
+                    ::new (static_cast<void*>(inline_ptr_(m_inline_size))) T(std::move(*other.inline_element_ptr_(m_inline_size)));
+                }
+            }
+            catch(...){
+                destroy_inline_();
+                throw;
+            }
+        }
+        other.destroy_all_();
+    }
+
+public:
+    small_deque(): m_inline_first(0), m_inline_size(0), m_is_spilled(false), m_alloc(){}
+
+    explicit small_deque(const Allocator& alloc): m_inline_first(0), m_inline_size(0), m_is_spilled(false), m_alloc(alloc){}
+
+    small_deque(const small_deque& other):
+        small_deque(std::allocator_traits<Allocator>::select_on_container_copy_construction(other.m_alloc))
+    {
+        copy_from_(other);
+    }
+
+    // the spilled deque is taken in O(1), the inline elements are moved; (other) becomes empty
+    small_deque(small_deque&& other) noexcept(std::is_nothrow_move_constructible<T>::value):
+        small_deque(other.m_alloc)
+    {
+        move_from_(other);
+    }
+
+    // if an exception is thrown, *this is left empty
+    small_deque& operator=(const small_deque& other){
+        if (this == &other) return *this;
+        destroy_all_();
+        if constexpr (std::allocator_traits<Allocator>::propagate_on_container_copy_assignment::value){
+            m_alloc = other.m_alloc;
+        }
+        copy_from_(other);
+        return *this;
+    }
+
+    /*
+        The spilled deque of (other) is taken in O(1), if the allocator propagates or is equal,
+        otherwise its elements are moved; the inline elements are moved. (other) becomes empty.
+    */
+    small_deque& operator=(small_deque&& other) noexcept(
+        std::is_nothrow_move_constructible<T>::value
+            &&
+        (
+            std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+                ||
+            std::allocator_traits<Allocator>::is_always_equal::value
+        )
+    ){
+        if (this == &other) return *this;
+        destroy_all_();
+        if constexpr (std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value){
+            m_alloc = other.m_alloc;
+        }
+        move_from_(other);
+        return *this;
+    }
+
+    ~small_deque(){
+        destroy_all_();
+    }
+
+
+    allocator_type get_allocator() const {return m_alloc;}
+
+    bool is_inline() const {return !m_is_spilled;}
+
+    size_type size() const {return m_is_spilled ? m_spilled.size() : m_inline_size;}
+
+    bool empty() const {return size() == 0;}
+
+
+    reference operator[](size_type pos){
+        return m_is_spilled ? m_spilled[pos] : *inline_element_ptr_(pos);
+    }
+    const_reference operator[](size_type pos) const {
+        return m_is_spilled ? m_spilled[pos] : *inline_element_ptr_(pos);
+    }
+
+    reference at(size_type pos){
+        if (pos >= size()) {throw std::out_of_range("Farebl::small_deque::at: pos >= size()");}
+        return (*this)[pos];
+    }
+    const_reference at(size_type pos) const {
+        if (pos >= size()) {throw std::out_of_range("Farebl::small_deque::at: pos >= size()");}
+        return (*this)[pos];
+    }
+
+    reference front() {return (*this)[0];}
+    const_reference front() const {return (*this)[0];}
+
+    reference back() {return (*this)[size() - 1];}
+    const_reference back() const {return (*this)[size() - 1];}
+
+
+    iterator begin() {return {this, 0};}
+    const_iterator begin() const {return {this, 0};}
+    const_iterator cbegin() const {return {this, 0};}
+
+    iterator end() {return {this, static_cast<difference_type>(size())};}
+    const_iterator end() const {return {this, static_cast<difference_type>(size())};}
+    const_iterator cend() const {return {this, static_cast<difference_type>(size())};}
+
+
+    void push_back(const T& value){
+        emplace_back(value);
+    }
+
+    void push_back(T&& value){
+        emplace_back(std::move(value));
+    }
+
+    template <class... Args>
+    reference emplace_back(Args&&... args){
+        if (!m_is_spilled && m_inline_size == InlineN){
+            T value(std::forward<Args>(args)...); // (args) may refer to an element of this deque
+            spill_(1);
+            return m_spilled.emplace_back(std::move(value));
+        }
+        if (m_is_spilled){
+            return m_spilled.emplace_back(std::forward<Args>(args)...);
+        }
+        T* ptr = ::new (static_cast<void*>(inline_element_ptr_(m_inline_size))) T(std::forward<Args>(args)...);
+        ++m_inline_size;
+        return *ptr;
+    }
+
+    template <class... Args>
+    reference emplace_front(Args&&... args){
+        if (!m_is_spilled && m_inline_size == InlineN){
+            T value(std::forward<Args>(args)...);
+            spill_(0);
+            return m_spilled.emplace_front(std::move(value));
+        }
+        if (m_is_spilled){
+            return m_spilled.emplace_front(std::forward<Args>(args)...);
+        }
+        size_type new_first = (m_inline_first == 0) ? (InlineN - 1) : (m_inline_first - 1);
+        T* ptr = ::new (static_cast<void*>(inline_ptr_(new_first))) T(std::forward<Args>(args)...);
+        m_inline_first = new_first;
+        ++m_inline_size;
+        return *ptr;
+    }
+
+    void push_front(const T& value){
+        emplace_front(value);
+    }
+
+    void push_front(T&& value){
+        emplace_front(std::move(value));
+    }
+
+    void pop_back(){
+        if (m_is_spilled){
+            m_spilled.pop_back();
+            return;
+        }
+        if (m_inline_size == 0) {return;}
+        inline_element_ptr_(m_inline_size - 1)->~T();
+        --m_inline_size;
+    }
+
+    void pop_front(){
+        if (m_is_spilled){
+            m_spilled.pop_front();
+            return;
+        }
+        if (m_inline_size == 0) {return;}
+        inline_ptr_(m_inline_first)->~T();
+        m_inline_first = ring_index_(m_inline_first + 1);
+        --m_inline_size;
+    }
+
+    // returns to the inline storage and frees the buckets
+    void clear(){
+        destroy_all_();
+    }
+
+    // returns to the inline storage, if the elements fit into it, otherwise shrinks the spilled deque
+    void shrink_to_fit(){
+        if (!m_is_spilled) {return;}
+        if (m_spilled.size() <= InlineN){
+            unspill_();
+        }
+        else{
+            m_spilled.shrink_to_fit();
+        }
+    }
+};
+
+} // end namespace Farebl
+#endif // FAREBL_SMALL_DEQUE_H
@@ -0,0 +1,548 @@
+#ifndef FAREBL_STATIC_LIST_H
+#define FAREBL_STATIC_LIST_H
+
+
+
+#include <algorithm>         // for equal, lexicographical_compare
+#include <cstddef>           // for size_t, ptrdiff_t
+#include <cstdint>           // for uint16_t, uint32_t
+#include <functional>        // for less
+#include <initializer_list>  // for initializer_list
+#include <iterator>          // for bidirectional_iterator_tag, reverse_iterator
+#include <new>               // for launder, placement new
+#include <stdexcept>         // for length_error
+#include <type_traits>       // for conditional, is_trivially_destructible
+#include <utility>           // for forward, move
+
+namespace Farebl {
+
+/*
+    Doubly linked list of at most N elements without the heap: the nodes are the inline
+    array of the list, the links are the 16-bit (N < 65535) or the 32-bit indices in it.
+    The free nodes are chained through next: the allocator is never used, push/insert
+    and erase are O(1), full() and empty() are O(1). Insertion into the full list
+    throws std::length_error and leaves the list unchanged.
+
+    The sentinel fake_node_ has the index N. The elements are stored inside the object,
+    so the move and swap move the elements (O(n)) and invalidate the iterators.
+*/
+template<typename T, size_t N>
+class static_list{
+    static_assert(N > 0, "Farebl::static_list: N must be positive");
+    static_assert(N < size_t(0xFFFFFFFF), "Farebl::static_list: N must fit the 32-bit index");
+
+    using Index = typename std::conditional<(N < size_t(0xFFFF)), uint16_t, uint32_t>::type;
+
+    struct BaseNode{
+        Index prev;
+        Index next; // in the free node - the next free node
+    };
+
+    struct Node: BaseNode{
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    static constexpr Index sentinel_ = static_cast<Index>(N);
+
+    Node nodes_[N];
+    BaseNode fake_node_;
+    Index sz_;
+    Index used_;      // the nodes [0, used_) were taken at least once, the rest isn't chained yet
+    Index free_head_; // sentinel_ - no free nodes in the chain
+
+    BaseNode& base_(Index index){
+        return index == sentinel_ ? fake_node_ : nodes_[index];
+    }
+
+    const BaseNode& base_(Index index) const {
+        return index == sentinel_ ? fake_node_ : nodes_[index];
+    }
+
+    T* value_ptr_(Index index){
+        return std::launder(reinterpret_cast<T*>(nodes_[index].storage));
+    }
+
+    const T* value_ptr_(Index index) const {
+        return std::launder(reinterpret_cast<const T*>(nodes_[index].storage));
+    }
+
+    Index take_node_(){
+        if (free_head_ != sentinel_){
+            Index index = free_head_;
+            free_head_ = nodes_[index].next;
+            return index;
+        }
+        return used_++;
+    }
+
+    void release_node_(Index index){
+        nodes_[index].next = free_head_;
+        free_head_ = index;
+    }
+
+    void link_before_(Index pos, Index index){
+        Index prev = base_(pos).prev;
+        nodes_[index].prev = prev;
+        nodes_[index].next = pos;
+        base_(prev).next = index;
+        base_(pos).prev = index;
+        ++sz_;
+    }
+
+    // the node is taken, the element is constructed in it and linked before (pos)
+    template<class... Args>
+    Index emplace_node_(Index pos, const char* error_message, Args&&... args){
+        if (sz_ == N) throw std::length_error(error_message);
+        Index index = take_node_();
+        try{
+            ::new (static_cast<void*>(nodes_[index].storage)) T(std::forward<Args>(args)...);
+        }
+        catch(...){
+            release_node_(index);
+            throw;
+        }
+        link_before_(pos, index);
+        return index;
+    }
+
+    // returns the index of the node after the erased one
+    Index erase_node_(Index index){
+        Index prev = nodes_[index].prev;
+        Index next = nodes_[index].next;
+        base_(prev).next = next;
+        base_(next).prev = prev;
+        value_ptr_(index)->~T();
+        release_node_(index);
+        --sz_;
+        return next;
+    }
+
+    // the body of the constructor: the elements, constructed before the exception, are destroyed
+    template<class Func>
+    void fill_or_clear_(Func fill){
+        try{
+            fill();
+        }
+        catch(...){
+            clear();
+            throw;
+        }
+    }
+
+    void reset_(){
+        fake_node_.prev = sentinel_;
+        fake_node_.next = sentinel_;
+        sz_ = 0;
+        used_ = 0;
+        free_head_ = sentinel_;
+    }
+
+    template<bool IsConst = false>
+    struct base_iterator{
+    private:
+        friend class Farebl::static_list<T, N>;
+
+        using ListPtr_t = typename std::conditional<IsConst, const static_list*, static_list*>::type;
+
+        ListPtr_t list_;
+        Index index_;
+        base_iterator(ListPtr_t list, Index index):list_(list), index_(index){}
+
+    public:
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = T;
+        using pointer           = typename std::conditional<IsConst, const T*, T*>::type;
+        using reference         = typename std::conditional<IsConst, const T&, T&>::type;
+        using iterator_category = std::bidirectional_iterator_tag;
+
+        base_iterator():list_(nullptr), index_(sentinel_){}
+        base_iterator(const base_iterator& other) = default;
+        base_iterator& operator=(const base_iterator& other) = default;
+
+        reference operator*()const {
+            return *list_->value_ptr_(index_);
+        }
+
+        pointer operator->()const{
+            return list_->value_ptr_(index_);
+        }
+
+        base_iterator& operator++(){
+            index_ = list_->base_(index_).next;
+            return *this;
+        }
+        base_iterator operator++(int ){
+            base_iterator temp = *this;
+            index_ = list_->base_(index_).next;
+            return temp;
+        }
+        base_iterator& operator--(){
+            index_ = list_->base_(index_).prev;
+            return *this;
+        }
+        base_iterator operator--(int ){
+            base_iterator temp = *this;
+            index_ = list_->base_(index_).prev;
+            return temp;
+        }
+
+        template<bool OtherIsConst>
+        bool operator==(const base_iterator<OtherIsConst>& other) const {
+            return index_ == other.index_;
+        }
+        template<bool OtherIsConst>
+        bool operator!=(const base_iterator<OtherIsConst>& other) const {
+            return !(index_ == other.index_);
+        }
+
+        operator base_iterator<true>() const {return {list_, index_};}
+    };
+
+public:
+
+    // size of the slot of the element in the inline array
+    static constexpr size_t node_size = sizeof(Node);
+
+    using value_type      = T;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference       = value_type&;
+    using const_reference = const value_type&;
+    using pointer         = T*;
+    using const_pointer   = const T*;
+
+    using iterator               = base_iterator<false>;
+    using const_iterator         = base_iterator<true>;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+
+
+    static_list(){reset_();}
+
+    explicit static_list(size_t count){
+        reset_();
+        fill_or_clear_([&](){for (size_t i = 0; i < count; ++i) emplace_back();});
+    }
+
+    static_list(size_t count, const T& value){
+        reset_();
+        fill_or_clear_([&](){insert(cend(), count, value);});
+    }
+
+    template<class InputIt, typename = decltype(*std::declval<InputIt&>(), ++std::declval<InputIt&>())>
+    static_list(InputIt first, InputIt last){
+        reset_();
+        fill_or_clear_([&](){insert(cend(), first, last);});
+    }
+
+    static_list(std::initializer_list<T> init_list){
+        reset_();
+        fill_or_clear_([&](){insert(cend(), init_list.begin(), init_list.end());});
+    }
+
+    static_list(const static_list& other){
+        reset_();
+        fill_or_clear_([&](){insert(cend(), other.begin(), other.end());});
+    }
+
+    // the elements are moved one by one: (other) keeps its moved-from elements
+    static_list(static_list&& other){
+        reset_();
+        fill_or_clear_([&](){for (T& value: other) emplace_back(std::move(value));});
+    }
+
+    ~static_list(){clear();}
+
+    static_list& operator=(const static_list& other) & {
+        if (this != &other) assign(other.begin(), other.end());
+        return *this;
+    }
+
+    static_list& operator=(static_list&& other) & {
+        if (this != &other){
+            clear();
+            for (T& value: other) emplace_back(std::move(value));
+        }
+        return *this;
+    }
+
+    static_list& operator=(std::initializer_list<T> init_list) & {
+        assign(init_list.begin(), init_list.end());
+        return *this;
+    }
+
+    void assign(size_t count, const T& value){
+        clear();
+        insert(cend(), count, value);
+    }
+
+    template<class InputIt>
+    void assign(InputIt first, InputIt last){
+        clear();
+        insert(cend(), first, last);
+    }
+
+    void assign(std::initializer_list<T> init_list){assign(init_list.begin(), init_list.end());}
+
+
+
+    reference front(){return *begin();}
+    const_reference front() const {return *cbegin();}
+
+    reference back(){return *(--end());}
+    const_reference back() const {return *(--cend());}
+
+
+
+    iterator begin(){return {this, fake_node_.next};}
+    iterator end(){return {this, sentinel_};}
+
+    const_iterator begin() const {return {this, fake_node_.next};}
+    const_iterator end() const {return {this, sentinel_};}
+
+    const_iterator cbegin() const noexcept {return {this, fake_node_.next};}
+    const_iterator cend() const noexcept {return {this, sentinel_};}
+
+    reverse_iterator rbegin(){return reverse_iterator(end());}
+    reverse_iterator rend(){return reverse_iterator(begin());}
+
+    const_reverse_iterator rbegin() const {return const_reverse_iterator(cend());}
+    const_reverse_iterator rend() const {return const_reverse_iterator(cbegin());}
+
+    const_reverse_iterator crbegin() const noexcept {return const_reverse_iterator(cend());}
+    const_reverse_iterator crend() const noexcept {return const_reverse_iterator(cbegin());}
+
+
+    bool empty() const {return sz_ == 0;}
+
+    bool full() const {return sz_ == N;}
+
+    size_t size() const {return sz_;}
+
+    static constexpr size_t capacity() {return N;}
+
+    static constexpr size_t max_size() {return N;}
+
+
+    void clear(){
+        if constexpr (!std::is_trivially_destructible<T>::value){
+            for (Index index = fake_node_.next; index != sentinel_; index = nodes_[index].next){
+                value_ptr_(index)->~T();
+            }
+        }
+        reset_();
+    }
+
+
+    template<class... Args>
+    iterator emplace(const_iterator pos, Args&&... args){
+        return {this, emplace_node_(pos.index_, "Farebl::static_list::emplace: full", std::forward<Args>(args)...)};
+    }
+
+    iterator insert(const_iterator pos, const T& value){
+        return {this, emplace_node_(pos.index_, "Farebl::static_list::insert: full", value)};
+    }
+
+    iterator insert(const_iterator pos, T&& value){
+        return {this, emplace_node_(pos.index_, "Farebl::static_list::insert: full", std::move(value))};
+    }
+
+    // the whole range is checked against the capacity before the insertion
+    iterator insert(const_iterator pos, size_type count, const T& value){
+        if (count > N - sz_) throw std::length_error("Farebl::static_list::insert: full");
+        iterator result(this, pos.index_);
+        for (size_type i = 0; i < count; ++i){
+            Index index = emplace_node_(pos.index_, "Farebl::static_list::insert: full", value);
+            if (i == 0) result.index_ = index;
+        }
+        return result;
+    }
+
+    // the elements, inserted before the exception, stay in the list
+    template<class InputIt>
+    iterator insert(const_iterator pos, InputIt first, InputIt last){
+        iterator result(this, pos.index_);
+        bool is_first = true;
+        for (; first != last; ++first){
+            Index index = emplace_node_(pos.index_, "Farebl::static_list::insert: full", *first);
+            if (is_first) {result.index_ = index; is_first = false;}
+        }
+        return result;
+    }
+
+    iterator insert(const_iterator pos, std::initializer_list<T> init_list){
+        return insert(pos, init_list.begin(), init_list.end());
+    }
+
+    iterator erase(const_iterator pos){
+        if (pos.index_ == sentinel_) return end();
+        return {this, erase_node_(pos.index_)};
+    }
+
+    iterator erase(const_iterator first, const_iterator last){
+        Index index = first.index_;
+        while (index != last.index_) index = erase_node_(index);
+        return {this, index};
+    }
+
+
+    void push_back(const T& value){emplace_node_(sentinel_, "Farebl::static_list::push_back: full", value);}
+    void push_back(T&& value){emplace_node_(sentinel_, "Farebl::static_list::push_back: full", std::move(value));}
+
+    template<class... Args>
+    reference emplace_back(Args&&... args){
+        return *value_ptr_(emplace_node_(sentinel_, "Farebl::static_list::emplace_back: full", std::forward<Args>(args)...));
+    }
+
+    void pop_back(){
+        if (sz_ == 0) return;
+        erase_node_(fake_node_.prev);
+    }
+
+    void push_front(const T& value){emplace_node_(fake_node_.next, "Farebl::static_list::push_front: full", value);}
+    void push_front(T&& value){emplace_node_(fake_node_.next, "Farebl::static_list::push_front: full", std::move(value));}
+
+    template<class... Args>
+    reference emplace_front(Args&&... args){
+        return *value_ptr_(emplace_node_(fake_node_.next, "Farebl::static_list::emplace_front: full", std::forward<Args>(args)...));
+    }
+
+    void pop_front(){
+        if (sz_ == 0) return;
+        erase_node_(fake_node_.next);
+    }
+
+    void resize(size_type count){
+        if (count > N) throw std::length_error("Farebl::static_list::resize: count > capacity()");
+        while (sz_ > count) erase_node_(fake_node_.prev);
+        while (sz_ < count) emplace_back();
+    }
+
+    void resize(size_type count, const value_type& value){
+        if (count > N) throw std::length_error("Farebl::static_list::resize: count > capacity()");
+        while (sz_ > count) erase_node_(fake_node_.prev);
+        while (sz_ < count) emplace_back(value);
+    }
+
+    // O(n): the elements are moved through the temporary list
+    void swap(static_list& other){
+        if (this == &other) return;
+        static_list temp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(temp);
+    }
+
+
+    size_type remove(const T& value){
+        return remove_if([&value](const T& element){return element == value;});
+    }
+
+    template< class UnaryPred >
+    size_type remove_if( UnaryPred p ){
+        size_type removed = 0;
+        Index index = fake_node_.next;
+        while (index != sentinel_){
+            if (p(*value_ptr_(index))){
+                index = erase_node_(index);
+                ++removed;
+            }
+            else{
+                index = nodes_[index].next;
+            }
+        }
+        return removed;
+    }
+
+    void reverse() noexcept {
+        Index index = sentinel_;
+        do{
+            BaseNode& node = base_(index);
+            Index next = node.next;
+            node.next = node.prev;
+            node.prev = next;
+            index = next;
+        } while (index != sentinel_);
+    }
+
+    void sort(){sort(std::less<T>());}
+
+    // stable merge sort of the links: the elements aren't moved
+    template<class Compare>
+    void sort(Compare comp){
+        if (sz_ < 2) return;
+        Index head = sort_chain_(fake_node_.next, sz_, comp);
+        Index prev = sentinel_;
+        for (Index index = head; index != sentinel_; index = nodes_[index].next){
+            base_(prev).next = index;
+            nodes_[index].prev = prev;
+            prev = index;
+        }
+        base_(prev).next = sentinel_;
+        fake_node_.prev = prev;
+    }
+
+private:
+    // sorts (count) nodes of the next-chain from (head): returns the new head, (head) becomes the node after them
+    template<class Compare>
+    Index sort_chain_(Index& head, size_t count, Compare& comp){
+        if (count == 1){
+            Index result = head;
+            head = nodes_[head].next;
+            nodes_[result].next = sentinel_;
+            return result;
+        }
+        Index left = sort_chain_(head, count / 2, comp);
+        Index right = sort_chain_(head, count - count / 2, comp);
+
+        Index result = sentinel_;
+        Index* tail = &result;
+        while (left != sentinel_ && right != sentinel_){
+            if (comp(*value_ptr_(right), *value_ptr_(left))){
+                *tail = right;
+                right = nodes_[right].next;
+            }
+            else{
+                *tail = left;
+                left = nodes_[left].next;
+            }
+            tail = &nodes_[*tail].next;
+        }
+        *tail = (left != sentinel_) ? left : right;
+        return result;
+    }
+};
+
+
+template<typename T, size_t N>
+bool operator==(const static_list<T, N>& lhs, const static_list<T, N>& rhs){
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template<typename T, size_t N>
+bool operator!=(const static_list<T, N>& lhs, const static_list<T, N>& rhs){
+    return !(lhs == rhs);
+}
+
+template<typename T, size_t N>
+bool operator<(const static_list<T, N>& lhs, const static_list<T, N>& rhs){
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template<typename T, size_t N>
+bool operator>(const static_list<T, N>& lhs, const static_list<T, N>& rhs){
+    return (rhs < lhs);
+}
+
+template<typename T, size_t N>
+bool operator<=(const static_list<T, N>& lhs, const static_list<T, N>& rhs){
+    return !(rhs < lhs);
+}
+
+template<typename T, size_t N>
+bool operator>=(const static_list<T, N>& lhs, const static_list<T, N>& rhs){
+    return !(lhs < rhs);
+}
+
+} // end namespace Farebl
+#endif // FAREBL_STATIC_LIST_H
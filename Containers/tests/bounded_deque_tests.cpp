@@ -0,0 +1,112 @@
+/*
+    Farebl::bounded_deque against std::deque: the random push/pop at both ends with the wrap
+    of the ring, the requested bound (not the bound of the whole buckets) and the element lifetimes.
+*/
+#include <cstddef>      // for size_t
+#include <deque>        // for deque
+#include <memory>       // for allocator
+#include <stdexcept>    // for out_of_range
+#include <string>       // for string
+
+#include "test_common.hpp"
+#include "bounded_deque.hpp"
+
+namespace {
+
+using namespace Farebl::test;
+
+template <typename Bounded>
+void check_same(const Bounded& d, const std::deque<typename Bounded::value_type>& ref){
+    FAREBL_CHECK(d.size() == ref.size());
+    if (d.size() != ref.size()) {return;}
+    bool same = true;
+    for (size_t i = 0; i < ref.size(); ++i) {same = same && d[i] == ref[i];}
+    FAREBL_CHECK(same);
+    if (!ref.empty()) {FAREBL_CHECK(d.front() == ref.front() && d.back() == ref.back());}
+}
+
+template <size_t BucketSize>
+void differential(size_t capacity, uint64_t seed, int steps){
+    Farebl::bounded_deque<std::string, std::allocator<std::string>, BucketSize> d(capacity);
+    std::deque<std::string> ref;
+    random_sequence random(seed);
+    FAREBL_CHECK(d.capacity() == capacity);
+
+    for (int step = 0; step < steps; ++step){
+        std::string value = long_string(random.next() % 1000);
+        bool room = ref.size() < capacity;
+        switch (random.below(6)){
+            case 0: case 1:
+                FAREBL_CHECK(d.try_push_back(value) == room);
+                if (room) {ref.push_back(value);}
+                break;
+            case 2:
+                FAREBL_CHECK(d.try_emplace_front(value) == room);
+                if (room) {ref.push_front(value);}
+                break;
+            case 3:
+                if (!ref.empty()) {d.pop_back(); ref.pop_back();}
+                break;
+            case 4: {
+                std::string out;
+                FAREBL_CHECK(d.try_pop_front(out) == !ref.empty());
+                if (!ref.empty()) {FAREBL_CHECK(out == ref.front()); ref.pop_front();}
+                break;
+            }
+            case 5:
+                if (random.below(32) == 0) {d.clear(); ref.clear();}
+                break;
+        }
+        FAREBL_CHECK(d.full() == (ref.size() == capacity));
+        if (step % 11 == 0) {check_same(d, ref);}
+    }
+    check_same(d, ref);
+}
+
+// the capacity between the bucket multiples is the bound: the rest of the last bucket isn't used
+void requested_bound(){
+    Farebl::bounded_deque<int, std::allocator<int>, 1024> d(16);
+    FAREBL_CHECK(d.capacity() == 16);
+    for (int i = 0; i < 16; ++i) {FAREBL_CHECK(d.try_push_back(i));}
+    FAREBL_CHECK(d.full());
+    FAREBL_CHECK(!d.try_push_back(16));
+    FAREBL_CHECK(!d.try_push_front(-1));
+    FAREBL_CHECK(d.size() == 16 && d.back() == 15);
+    FAREBL_CHECK_THROWS(d.at(16), std::out_of_range);
+
+    // the head wraps around the ring (1024 cells) with at most 16 elements inside
+    for (int i = 0; i < 5000; ++i){
+        d.pop_front();
+        FAREBL_CHECK(d.try_push_back(16 + i));
+        FAREBL_CHECK(!d.try_push_back(0));
+    }
+    FAREBL_CHECK(d.front() == 5000 && d.back() == 5015);
+
+    Farebl::bounded_deque<int, std::allocator<int>, 4> empty_bound(0);
+    FAREBL_CHECK(empty_bound.capacity() == 0 && empty_bound.full());
+    FAREBL_CHECK(!empty_bound.try_push_back(1));
+}
+
+void element_lifetimes(){
+    {
+        Farebl::bounded_deque<tracked, std::allocator<tracked>, 3> d(10);
+        for (int i = 0; i < 100; ++i){
+            d.try_push_back(tracked(i));
+            d.try_push_front(tracked(-i));
+            if (i % 3 == 0) {d.pop_back();}
+        }
+        FAREBL_CHECK(d.size() == 9 && tracked::live() == 9);
+    }
+    FAREBL_CHECK(tracked::live() == 0);
+}
+
+} // end namespace
+
+int main(){
+    run("bounded_deque<string, 4> differential, capacity 10", [](){differential<4>(10, 1, 20000);});
+    run("bounded_deque<string, 5> differential, capacity 17", [](){differential<5>(17, 2, 20000);});
+    run("bounded_deque<string, 8> differential, capacity 64", [](){differential<8>(64, 3, 20000);});
+    run("bounded_deque keeps the requested bound", requested_bound);
+    run("bounded_deque element lifetimes", element_lifetimes);
+    return finish();
+}
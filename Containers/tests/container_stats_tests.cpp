@@ -0,0 +1,115 @@
+/*
+    The counters of container_stats.hpp (the test is built with FAREBL_CONTAINER_STATS):
+    stats() of deque and list against the counts of the allocator, the growth of the bucket
+    array, the moved elements and the peak size, the copy, which starts from zero,
+    and the sums of global_container_stats.
+*/
+#include <cstddef>      // for size_t
+
+#include "test_common.hpp"
+#include "container_stats.hpp"
+#include "deque.hpp"
+#include "list.hpp"
+
+namespace {
+
+using namespace Farebl::test;
+
+static_assert(Farebl::container_stats_enabled, "the test is built with FAREBL_CONTAINER_STATS");
+
+using counted_deque = Farebl::deque<int, counting_allocator<int>, 4>;
+using counted_list = Farebl::list<int, counting_allocator<int>>;
+
+void deque_counters(){
+    size_t calls_before = allocation_counts::calls;
+    size_t bytes_before = allocation_counts::bytes;
+    counted_deque d;
+    for (int i = 0; i < 1000; ++i) {d.push_back(i);}
+    for (int i = 0; i < 100; ++i) {d.push_front(-i);}
+
+    Farebl::container_stats stats = d.stats();
+    FAREBL_CHECK(stats.allocator_calls == allocation_counts::calls - calls_before);
+    FAREBL_CHECK(stats.bytes_allocated == allocation_counts::bytes - bytes_before);
+    FAREBL_CHECK(stats.map_reallocations > 0);  // 1100 elements don't fit the initial bucket array
+    FAREBL_CHECK(stats.elements_moved == 0);
+    FAREBL_CHECK(stats.peak_size == 1100);
+
+    for (int i = 0; i < 1090; ++i) {d.pop_back();}
+    size_t reallocations = d.stats().map_reallocations;
+    d.shrink_to_fit();
+    stats = d.stats();
+    FAREBL_CHECK(stats.elements_moved == 10);
+    FAREBL_CHECK(stats.map_reallocations == reallocations + 1);
+    FAREBL_CHECK(stats.peak_size == 1100);
+    FAREBL_CHECK(stats.allocator_calls == allocation_counts::calls - calls_before);
+}
+
+void list_counters(){
+    size_t calls_before = allocation_counts::calls;
+    size_t bytes_before = allocation_counts::bytes;
+    counted_list l;
+    for (int i = 0; i < 500; ++i) {l.push_back(i);}
+    for (int i = 0; i < 300; ++i) {l.pop_front();}
+    for (int i = 0; i < 100; ++i) {l.push_front(i);}
+
+    Farebl::container_stats stats = l.stats();
+    FAREBL_CHECK(stats.allocator_calls == 600);
+    FAREBL_CHECK(stats.allocator_calls == allocation_counts::calls - calls_before);
+    FAREBL_CHECK(stats.bytes_allocated == allocation_counts::bytes - bytes_before);
+    FAREBL_CHECK(stats.peak_size == 500);
+    FAREBL_CHECK(stats.map_reallocations == 0 && stats.elements_moved == 0);
+}
+
+// the counters belong to the object: the copy counts only its own allocations
+template <typename Container>
+void copy_starts_from_zero(){
+    Container source;
+    for (int i = 0; i < 300; ++i) {source.push_back(i);}
+    Farebl::container_stats source_stats = source.stats();
+
+    size_t calls_before = allocation_counts::calls;
+    Container copy(source);
+    FAREBL_CHECK(copy.stats().allocator_calls == allocation_counts::calls - calls_before);
+    FAREBL_CHECK(copy.stats().peak_size == 300);
+
+    Container assigned;
+    assigned.push_back(1);
+    size_t assigned_calls = assigned.stats().allocator_calls;
+    calls_before = allocation_counts::calls;
+    assigned = source;
+    FAREBL_CHECK(assigned.stats().allocator_calls == assigned_calls + (allocation_counts::calls - calls_before));
+
+    FAREBL_CHECK(source.stats().allocator_calls == source_stats.allocator_calls);
+    FAREBL_CHECK(source.stats().bytes_allocated == source_stats.bytes_allocated);
+}
+
+void global_sums(){
+    Farebl::global_container_stats.reset();
+    counted_deque d;
+    counted_list l;
+    for (int i = 0; i < 700; ++i) {d.push_back(i);}
+    for (int i = 0; i < 200; ++i) {l.push_back(i);}
+    d.shrink_to_fit();
+
+    Farebl::container_stats global = Farebl::global_container_stats.snapshot();
+    FAREBL_CHECK(global.allocator_calls == d.stats().allocator_calls + l.stats().allocator_calls);
+    FAREBL_CHECK(global.bytes_allocated == d.stats().bytes_allocated + l.stats().bytes_allocated);
+    FAREBL_CHECK(global.map_reallocations == d.stats().map_reallocations);
+    FAREBL_CHECK(global.elements_moved == 700);
+    FAREBL_CHECK(global.peak_size == 700);  // the maximum over the containers, not the sum
+
+    Farebl::global_container_stats.reset();
+    global = Farebl::global_container_stats.snapshot();
+    FAREBL_CHECK(global.allocator_calls == 0 && global.bytes_allocated == 0 && global.peak_size == 0);
+}
+
+} // end namespace
+
+int main(){
+    run("deque counters", deque_counters);
+    run("list counters", list_counters);
+    run("deque copy starts from zero", copy_starts_from_zero<counted_deque>);
+    run("list copy starts from zero", copy_starts_from_zero<counted_list>);
+    run("global_container_stats sums the containers", global_sums);
+    return finish();
+}
@@ -0,0 +1,152 @@
+/*
+    The algorithms of deque_parallel.hpp against their sequential std:: versions:
+    the sizes around the bucket boundaries, the different thread counts (the merge rounds
+    of parallel::sort end in the buffer or in the deque), the elements with the heap memory.
+*/
+#include <algorithm>    // for sort, is_sorted
+#include <atomic>       // for atomic
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <functional>   // for less, greater, plus
+#include <memory>       // for allocator
+#include <numeric>      // for accumulate
+#include <stdexcept>    // for runtime_error
+#include <string>       // for string
+#include <vector>       // for vector
+
+#include "test_common.hpp"
+#include "deque.hpp"
+#include "deque_parallel.hpp"
+
+namespace {
+
+using namespace Farebl::test;
+
+template <typename Deque>
+std::vector<typename Deque::value_type> contents(const Deque& d){
+    return std::vector<typename Deque::value_type>(d.begin(), d.end());
+}
+
+// the front is popped, so the first segment is partial
+template <typename Deque, typename Make>
+Deque filled(size_t count, uint64_t seed, Make make){
+    Deque d;
+    random_sequence random(seed);
+    d.push_back(make(random.next()));
+    for (size_t i = 0; i < count; ++i) {d.push_back(make(random.next() % 1000));}
+    d.pop_front();
+    return d;
+}
+
+template <size_t BucketSize>
+void sort_ints(){
+    using Deque = Farebl::deque<int, std::allocator<int>, BucketSize>;
+    auto make = [](uint64_t key){return static_cast<int>(key % 100000);};
+    for (size_t count: {size_t(0), size_t(1), BucketSize - 1, BucketSize, 3 * BucketSize + 1, size_t(1000), size_t(5000)}){
+        for (size_t threads: {1, 2, 3, 4, 7, 8}){
+            Deque d = filled<Deque>(count, count * 31 + threads, make);
+            std::vector<int> expected = contents(d);
+            std::sort(expected.begin(), expected.end());
+            Farebl::parallel::sort(d, std::less<int>(), threads);
+            FAREBL_CHECK(contents(d) == expected);
+
+            std::sort(expected.begin(), expected.end(), std::greater<int>());
+            Farebl::parallel::sort(d, std::greater<int>(), threads);
+            FAREBL_CHECK(contents(d) == expected);
+        }
+    }
+}
+
+void sort_strings_and_lifetimes(){
+    {
+        using Deque = Farebl::deque<std::string, std::allocator<std::string>, 8>;
+        Deque d = filled<Deque>(3000, 5, long_string);
+        std::vector<std::string> expected = contents(d);
+        std::sort(expected.begin(), expected.end());
+        Farebl::parallel::sort(d, std::less<std::string>(), 5);
+        FAREBL_CHECK(contents(d) == expected);
+    }
+    {
+        using Deque = Farebl::deque<tracked, std::allocator<tracked>, 4>;
+        Deque d = filled<Deque>(2000, 6, [](uint64_t key){return tracked(static_cast<int>(key));});
+        Farebl::parallel::sort(d, std::less<tracked>(), 6);
+        FAREBL_CHECK(std::is_sorted(d.begin(), d.end()));
+        FAREBL_CHECK(tracked::live() == static_cast<long>(d.size()));
+    }
+    FAREBL_CHECK(tracked::live() == 0);
+}
+
+// the comparison throws in the sort of a part or in the last merge: every element stays alive once
+void sort_throwing_compare(){
+    using Deque = Farebl::deque<tracked, std::allocator<tracked>, 4>;
+    auto make = [](uint64_t key){return tracked(static_cast<int>(key));};
+    std::atomic<long> calls(0);
+    std::atomic<long> throw_at(-1);
+    auto comp = [&](const tracked& lhs, const tracked& rhs){
+        if (++calls == throw_at) {throw std::runtime_error("compare");}
+        return lhs < rhs;
+    };
+    {
+        Deque d = filled<Deque>(1000, 7, make);
+        Farebl::parallel::sort(d, comp, 4);
+    }
+    long total_calls = calls;
+    for (long at: {10L, total_calls - 10}){
+        {
+            Deque d = filled<Deque>(1000, 7, make);
+            size_t size = d.size();
+            calls = 0;
+            throw_at = at;
+            FAREBL_CHECK_THROWS(Farebl::parallel::sort(d, comp, 4), std::runtime_error);
+            FAREBL_CHECK(d.size() == size);
+            FAREBL_CHECK(tracked::live() == static_cast<long>(size));
+        }
+        FAREBL_CHECK(tracked::live() == 0);
+    }
+}
+
+// the deque, declared with the allocator of another type: the buffer goes through its rebound allocator
+void sort_with_the_rebound_allocator(){
+    using Deque = Farebl::deque<int, counting_allocator<char>, 8>;
+    Deque d = filled<Deque>(3000, 9, [](uint64_t key){return static_cast<int>(key);});
+    std::vector<int> expected = contents(d);
+    std::sort(expected.begin(), expected.end());
+    size_t calls_before = allocation_counts::calls;
+    size_t bytes_before = allocation_counts::bytes;
+    Farebl::parallel::sort(d, std::less<int>(), 4);
+    FAREBL_CHECK(contents(d) == expected);
+    FAREBL_CHECK(allocation_counts::calls == calls_before + 1);
+    FAREBL_CHECK(allocation_counts::bytes == bytes_before + d.size() * sizeof(int));
+}
+
+void for_each_transform_reduce(){
+    using Deque = Farebl::deque<long, std::allocator<long>, 16>;
+    Deque d = filled<Deque>(10000, 8, [](uint64_t key){return static_cast<long>(key);});
+    std::vector<long> values = contents(d);
+
+    Farebl::parallel::for_each(d, [](long& value){value += 1;}, 4);
+    Farebl::parallel::transform(d, [](long value){return value * 2;}, 3);
+    for (long& value: values) {value = (value + 1) * 2;}
+    FAREBL_CHECK(contents(d) == values);
+
+    Farebl::deque<long> dst;
+    for (size_t i = 0; i < d.size(); ++i) {dst.push_back(0);}
+    Farebl::parallel::transform(d, dst, [](long value){return -value;}, 5);
+    FAREBL_CHECK(dst.front() == -values.front() && dst.back() == -values.back());
+
+    long expected = std::accumulate(values.begin(), values.end(), 0L);
+    FAREBL_CHECK(Farebl::parallel::reduce(d, 0L, std::plus<long>(), 6) == expected);
+    FAREBL_CHECK(Farebl::parallel::reduce(Deque()) == 0);
+}
+
+} // end namespace
+
+int main(){
+    run("parallel::sort of int, bucket 4", sort_ints<4>);
+    run("parallel::sort of int, bucket 64", sort_ints<64>);
+    run("parallel::sort of strings, element lifetimes", sort_strings_and_lifetimes);
+    run("parallel::sort with the throwing comparison", sort_throwing_compare);
+    run("parallel::sort with the allocator of another type", sort_with_the_rebound_allocator);
+    run("parallel::for_each, transform, reduce", for_each_transform_reduce);
+    return finish();
+}
@@ -0,0 +1,317 @@
+/*
+    Farebl::deque against std::deque: the random sequences of push/pop at both ends,
+    insert/erase in the middle, batch operations and reserve/shrink, checked after every step,
+    with the small buckets (many bucket transitions), the power-of-two and other bucket sizes.
+*/
+#include <cstddef>      // for size_t
+#include <deque>        // for deque
+#include <iterator>     // for back_inserter, next
+#include <memory>       // for allocator
+#include <stdexcept>    // for out_of_range
+#include <string>       // for string
+#include <utility>      // for move
+#include <vector>       // for vector
+
+#include "test_common.hpp"
+#include "deque.hpp"
+
+namespace {
+
+using namespace Farebl::test;
+
+template <typename T>
+T make(uint64_t key);
+
+template <>
+int make<int>(uint64_t key) {return static_cast<int>(key % 100000);}
+
+template <>
+std::string make<std::string>(uint64_t key) {return long_string(key % 100000);}
+
+template <>
+tracked make<tracked>(uint64_t key) {return tracked(static_cast<int>(key % 100000));}
+
+
+template <typename Deque>
+bool same_segments(const Deque& d){
+    std::vector<typename Deque::value_type> joined;
+    for (size_t i = 0; i < d.segment_count(); ++i){
+        auto segment = d.get_segment(i);
+        joined.insert(joined.end(), segment.first, segment.last);
+    }
+    return joined.size() == d.size() && std::equal(joined.begin(), joined.end(), d.begin());
+}
+
+template <typename Deque>
+void check_same(const Deque& d, const std::deque<typename Deque::value_type>& ref){
+    FAREBL_CHECK(same_elements(d, ref));
+    FAREBL_CHECK(same_reversed(d, ref));
+    if (!ref.empty()){
+        FAREBL_CHECK(d.front() == ref.front());
+        FAREBL_CHECK(d.back() == ref.back());
+        size_t middle = ref.size() / 2;
+        FAREBL_CHECK(d[middle] == ref[middle]);
+        FAREBL_CHECK(*(d.begin() + static_cast<std::ptrdiff_t>(middle)) == ref[middle]);
+        FAREBL_CHECK(d.end() - d.begin() == static_cast<std::ptrdiff_t>(ref.size()));
+    }
+}
+
+template <typename T, size_t BucketSize>
+void differential(uint64_t seed, int steps){
+    using Deque = Farebl::deque<T, std::allocator<T>, BucketSize>;
+    Deque d;
+    std::deque<T> ref;
+    random_sequence random(seed);
+
+    for (int step = 0; step < steps; ++step){
+        T value = make<T>(random.next());
+        switch (random.below(14)){
+            case 0: case 1:
+                d.push_back(value); ref.push_back(value);
+                break;
+            case 2: case 3:
+                d.push_front(value); ref.push_front(value);
+                break;
+            case 4:
+                if (!ref.empty()) {d.pop_back(); ref.pop_back();}
+                break;
+            case 5:
+                if (!ref.empty()) {d.pop_front(); ref.pop_front();}
+                break;
+            case 6: {
+                size_t pos = random.below(ref.size() + 1);
+                auto it = d.insert(d.begin() + static_cast<std::ptrdiff_t>(pos), value);
+                ref.insert(ref.begin() + static_cast<std::ptrdiff_t>(pos), value);
+                FAREBL_CHECK(it - d.begin() == static_cast<std::ptrdiff_t>(pos));
+                break;
+            }
+            case 7: {
+                size_t pos = random.below(ref.size() + 1);
+                size_t count = 1 + random.below(3 * BucketSize);
+                d.insert(d.begin() + static_cast<std::ptrdiff_t>(pos), count, value);
+                ref.insert(ref.begin() + static_cast<std::ptrdiff_t>(pos), count, value);
+                break;
+            }
+            case 8: {
+                if (ref.empty()) break;
+                size_t first = random.below(ref.size());
+                size_t last = first + random.below(std::min<size_t>(ref.size() - first, 2 * BucketSize) + 1);
+                auto it = d.erase(d.begin() + static_cast<std::ptrdiff_t>(first), d.begin() + static_cast<std::ptrdiff_t>(last));
+                ref.erase(ref.begin() + static_cast<std::ptrdiff_t>(first), ref.begin() + static_cast<std::ptrdiff_t>(last));
+                FAREBL_CHECK(it - d.begin() == static_cast<std::ptrdiff_t>(first));
+                break;
+            }
+            case 9: {
+                std::vector<T> values;
+                size_t count = random.below(3 * BucketSize);
+                for (size_t i = 0; i < count; ++i) values.push_back(make<T>(random.next()));
+                d.push_back_n(values.begin(), values.size());
+                ref.insert(ref.end(), values.begin(), values.end());
+                break;
+            }
+            case 10: {
+                std::vector<T> popped;
+                size_t count = random.below(3 * BucketSize);
+                d.pop_front_n(std::back_inserter(popped), count);
+                count = std::min(count, ref.size());
+                FAREBL_CHECK(std::equal(popped.begin(), popped.end(), ref.begin(), ref.begin() + static_cast<std::ptrdiff_t>(count)));
+                ref.erase(ref.begin(), ref.begin() + static_cast<std::ptrdiff_t>(count));
+                break;
+            }
+            case 11:
+                if (random.below(2) == 0) d.reserve_back(random.below(4 * BucketSize));
+                else d.reserve_front(random.below(4 * BucketSize));
+                break;
+            case 12:
+                if (random.below(8) == 0) d.shrink_to_fit();
+                break;
+            case 13:
+                if (random.below(64) == 0) {d.clear(); ref.clear();}
+                break;
+        }
+        FAREBL_CHECK(d.size() == ref.size());
+        if (step % 17 == 0){
+            check_same(d, ref);
+            FAREBL_CHECK(same_segments(d));
+        }
+    }
+    check_same(d, ref);
+}
+
+template <size_t BucketSize>
+void copy_move_swap(){
+    using Deque = Farebl::deque<std::string, std::allocator<std::string>, BucketSize>;
+    std::deque<std::string> ref;
+    Deque d;
+    for (int i = 0; i < 100; ++i){
+        d.push_back(long_string(i));
+        ref.push_back(long_string(i));
+    }
+    d.pop_front();
+    ref.pop_front();
+
+    Deque copy(d);
+    check_same(copy, ref);
+
+    Deque assigned;
+    assigned.push_back("old");
+    assigned = d;
+    check_same(assigned, ref);
+
+    Deque smaller;
+    for (int i = 0; i < 500; ++i) smaller.push_front(long_string(i));
+    smaller = d;
+    check_same(smaller, ref);
+
+    Deque moved(std::move(copy));
+    check_same(moved, ref);
+    FAREBL_CHECK(copy.empty());
+    copy.push_back("reused");
+    FAREBL_CHECK(copy.size() == 1 && copy.front() == "reused");
+
+    Deque move_assigned;
+    move_assigned = std::move(moved);
+    check_same(move_assigned, ref);
+    FAREBL_CHECK(moved.empty());
+
+    Deque empty;
+    empty.swap(move_assigned);
+    check_same(empty, ref);
+    FAREBL_CHECK(move_assigned.empty());
+    move_assigned.swap(empty);
+    check_same(move_assigned, ref);
+    FAREBL_CHECK(empty.empty());
+
+    Deque self(d);
+    Deque& self_ref = self;
+    self = self_ref;
+    check_same(self, ref);
+}
+
+void element_lifetimes(){
+    {
+        Farebl::deque<tracked, std::allocator<tracked>, 4> d;
+        for (int i = 0; i < 50; ++i) {d.push_back(tracked(i)); d.push_front(tracked(-i));}
+        d.erase(d.begin() + 10, d.begin() + 30);
+        d.insert(d.begin() + 5, 7, tracked(1));
+        Farebl::deque<tracked, std::allocator<tracked>, 4> copy(d);
+        copy.shrink_to_fit();
+        FAREBL_CHECK(tracked::live() == static_cast<long>(d.size() + copy.size()));
+    }
+    FAREBL_CHECK(tracked::live() == 0);
+}
+
+void at_and_bounds(){
+    Farebl::deque<int> d;
+    FAREBL_CHECK_THROWS(d.at(0), std::out_of_range);
+    for (int i = 0; i < 10; ++i) d.push_back(i);
+    FAREBL_CHECK(d.at(9) == 9);
+    FAREBL_CHECK_THROWS(d.at(10), std::out_of_range);
+    FAREBL_CHECK(d.begin() + 10 == d.end());
+    FAREBL_CHECK(d.memory_usage() >= d.size() * sizeof(int));
+}
+
+/*
+    reserve_back(n)/reserve_front(n): the next n pushes at that end don't call the allocator
+    (neither the buckets nor the bucket array), from the empty deque, the deque with the free
+    cells at both ends and the counts across many buckets
+*/
+template <size_t BucketSize>
+void reserve_does_not_allocate(){
+    using Deque = Farebl::deque<int, counting_allocator<int>, BucketSize>;
+    for (size_t count: {size_t(1), BucketSize - 1, BucketSize, 3 * BucketSize + 1, size_t(1000)}){
+        for (size_t filled: {size_t(0), size_t(1), 2 * BucketSize + 1}){
+            Deque back;
+            Deque front;
+            for (size_t i = 0; i < filled; ++i) {back.push_back(0); front.push_front(0);}
+            back.reserve_back(count);
+            front.reserve_front(count);
+            FAREBL_CHECK(back.capacity_back() >= count && front.capacity_front() >= count);
+
+            size_t calls = allocation_counts::calls;
+            for (size_t i = 0; i < count; ++i) {back.push_back(static_cast<int>(i)); front.push_front(static_cast<int>(i));}
+            FAREBL_CHECK(allocation_counts::calls == calls);
+            FAREBL_CHECK(back.size() == filled + count && back.back() == static_cast<int>(count - 1));
+            FAREBL_CHECK(front.size() == filled + count && front.front() == static_cast<int>(count - 1));
+        }
+    }
+}
+
+/*
+    The first bucket array has the free slots at both ends: the first buckets at either end
+    allocate only themselves. The emptied deque (by the pops or by clear()) keeps its buckets
+    and starts from their middle cell: the refill up to the half of the cells from either end
+    (and up to all of them alternately) doesn't call the allocator.
+*/
+template <size_t BucketSize>
+void refill_does_not_allocate(){
+    using Deque = Farebl::deque<int, counting_allocator<int>, BucketSize>;
+    {
+        Deque d;
+        size_t calls = allocation_counts::calls;
+        d.push_back(0);
+        size_t map_capacity = d.bucket_array_capacity();
+        FAREBL_CHECK(map_capacity >= 8);
+        for (size_t i = 1; i < 3 * BucketSize; ++i) {d.push_back(static_cast<int>(i));}
+        for (size_t i = 0; i < 3 * BucketSize; ++i) {d.push_front(-static_cast<int>(i));}
+        FAREBL_CHECK(d.bucket_array_capacity() == map_capacity);
+        FAREBL_CHECK(d.stats().map_reallocations == 0);
+        FAREBL_CHECK(allocation_counts::calls - calls == d.allocated_buckets() + 1);
+    }
+
+    random_sequence random(BucketSize);
+    Deque d;
+    for (int round = 0; round < 6; ++round){
+        size_t count = 200 + random.below(800);
+        for (size_t i = 0; i < count; ++i){
+            if (random.below(2) == 0) {d.push_back(static_cast<int>(i));}
+            else {d.push_front(static_cast<int>(i));}
+        }
+        size_t cells = d.allocated_buckets() * BucketSize;
+        size_t refills[] = {cells - cells / 2, cells / 2, cells / 2 * 2};
+        for (int refill = 0; refill < 3; ++refill){
+            if (round % 2 == 0) {d.clear();}
+            else{
+                while (!d.empty()){
+                    if (random.below(2) == 0) {d.pop_back();}
+                    else {d.pop_front();}
+                }
+            }
+            FAREBL_CHECK(d.allocated_buckets() * BucketSize == cells);
+
+            size_t calls = allocation_counts::calls;
+            for (size_t i = 0; i < refills[refill]; ++i){
+                switch (refill){
+                    case 0: d.push_back(static_cast<int>(i)); break;
+                    case 1: d.push_front(static_cast<int>(i)); break;
+                    default:
+                        if (i % 2 == 0) {d.push_back(static_cast<int>(i));}
+                        else {d.push_front(static_cast<int>(i));}
+                        break;
+                }
+            }
+            FAREBL_CHECK(allocation_counts::calls == calls);
+        }
+        d.clear();
+    }
+}
+
+} // end namespace
+
+int main(){
+    run("deque<int, 4> differential", [](){differential<int, 4>(1, 20000);});
+    run("deque<int, 5> differential", [](){differential<int, 5>(2, 20000);});
+    run("deque<string, 8> differential", [](){differential<std::string, 8>(3, 10000);});
+    run("deque<tracked, 3> differential", [](){differential<tracked, 3>(4, 10000);});
+    run("deque<int> differential", [](){differential<int, Farebl::deque_default_bucket_size<int>>(5, 20000);});
+    run("deque<tracked> differential destroys all", [](){FAREBL_CHECK(tracked::live() == 0);});
+    run("deque copy/move/swap, bucket 4", copy_move_swap<4>);
+    run("deque copy/move/swap, bucket 6", copy_move_swap<6>);
+    run("deque element lifetimes", element_lifetimes);
+    run("deque at() and bounds", at_and_bounds);
+    run("deque<int, 4> reserve doesn't allocate", reserve_does_not_allocate<4>);
+    run("deque<int, 5> reserve doesn't allocate", reserve_does_not_allocate<5>);
+    run("deque<int, 4> refill doesn't allocate", refill_does_not_allocate<4>);
+    run("deque<int, 5> refill doesn't allocate", refill_does_not_allocate<5>);
+    return finish();
+}
@@ -0,0 +1,144 @@
+/*
+    Farebl::deque on hugepage_allocator against std::deque: the push/pop across many buckets
+    (many chunks of the arena), the deque freed on another thread, the reuse of the freed
+    blocks and mapped_bytes(). MADV_HUGEPAGE and mbind are only advice: the test passes
+    without them too.
+*/
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t, uintptr_t
+#include <deque>        // for deque
+#include <memory>       // for make_shared, shared_ptr
+#include <thread>       // for thread
+#include <utility>      // for move
+
+#include "test_common.hpp"
+#include "deque.hpp"
+#include "hugepage_allocator.hpp"
+
+namespace {
+
+using namespace Farebl::test;
+
+using huge_deque = Farebl::deque<uint64_t, Farebl::hugepage_allocator<uint64_t>, 512>;
+
+constexpr size_t huge_page_size = Farebl::hugepage_arena::huge_page_size;
+
+bool same(const huge_deque& d, const std::deque<uint64_t>& ref){
+    if (d.size() != ref.size()) {return false;}
+    for (size_t i = 0; i < ref.size(); ++i){
+        if (d[i] != ref[i]) {return false;}
+    }
+    return true;
+}
+
+void fill(huge_deque& d, std::deque<uint64_t>& ref, size_t count, uint64_t seed){
+    random_sequence random(seed);
+    for (size_t i = 0; i < count; ++i){
+        uint64_t value = random.next();
+        if (random.below(4) == 0) {d.push_front(value); ref.push_front(value);}
+        else {d.push_back(value); ref.push_back(value);}
+    }
+}
+
+// the buckets of 4 KiB over many chunks of 2 MiB: the arena maps whole hugepages
+void push_pop(Farebl::numa_policy policy){
+    auto arena = std::make_shared<Farebl::hugepage_arena>(huge_page_size, policy);
+    const Farebl::hugepage_arena& const_arena = *arena;
+    FAREBL_CHECK(const_arena.mapped_bytes() == 0 && const_arena.policy() == policy);
+    {
+        huge_deque d((Farebl::hugepage_allocator<uint64_t>(arena)));
+        std::deque<uint64_t> ref;
+        fill(d, ref, 1000000, 1);
+        FAREBL_CHECK(same(d, ref));
+        FAREBL_CHECK(const_arena.mapped_bytes() % huge_page_size == 0);
+        FAREBL_CHECK(const_arena.mapped_bytes() >= d.allocated_buckets() * 512 * sizeof(uint64_t));
+
+        bool aligned = true;
+        for (size_t i = 0; i < d.segment_count(); ++i){
+            aligned = aligned && reinterpret_cast<std::uintptr_t>(d.get_segment(i).first) % alignof(uint64_t) == 0;
+        }
+        FAREBL_CHECK(aligned);
+
+        random_sequence random(2);
+        while (ref.size() > 1000){
+            if (random.below(2) == 0) {d.pop_back(); ref.pop_back();}
+            else {d.pop_front(); ref.pop_front();}
+        }
+        FAREBL_CHECK(same(d, ref));
+        d.shrink_to_fit();
+        FAREBL_CHECK(same(d, ref));
+    }
+    // the chunks are returned only by the destructor of the arena
+    FAREBL_CHECK(const_arena.mapped_bytes() % huge_page_size == 0 && const_arena.mapped_bytes() > 0);
+}
+
+/*
+    The deque, filled on this thread, is destroyed on another one: its blocks go to the free lists
+    of the arena, so the same deque again doesn't map any more chunks (first_touch: one node)
+*/
+void free_on_another_thread(){
+    auto arena = std::make_shared<Farebl::hugepage_arena>(huge_page_size, Farebl::numa_policy::first_touch);
+    size_t mapped = 0;
+    {
+        huge_deque d((Farebl::hugepage_allocator<uint64_t>(arena)));
+        std::deque<uint64_t> ref;
+        fill(d, ref, 300000, 3);
+        mapped = arena->mapped_bytes();
+        std::thread freeing([moved = std::move(d), &ref]() mutable {
+            FAREBL_CHECK(same(moved, ref));
+            moved.clear();
+            moved.shrink_to_fit();
+        });
+        freeing.join();
+    }
+    huge_deque d((Farebl::hugepage_allocator<uint64_t>(arena)));
+    std::deque<uint64_t> ref;
+    fill(d, ref, 300000, 3);
+    FAREBL_CHECK(same(d, ref));
+    FAREBL_CHECK(arena->mapped_bytes() == mapped);
+
+    // the threads push into their own deques on the shared arena
+    std::deque<uint64_t> refs[4];
+    huge_deque deques[4] = {
+        huge_deque(Farebl::hugepage_allocator<uint64_t>(arena)), huge_deque(Farebl::hugepage_allocator<uint64_t>(arena)),
+        huge_deque(Farebl::hugepage_allocator<uint64_t>(arena)), huge_deque(Farebl::hugepage_allocator<uint64_t>(arena))
+    };
+    std::thread threads[4];
+    for (size_t i = 0; i < 4; ++i){
+        threads[i] = std::thread([&, i](){fill(deques[i], refs[i], 100000, 10 + i);});
+    }
+    for (std::thread& thread: threads) {thread.join();}
+    bool all_same = true;
+    for (size_t i = 0; i < 4; ++i) {all_same = all_same && same(deques[i], refs[i]);}
+    FAREBL_CHECK(all_same);
+}
+
+// the blocks larger than a quarter of the chunk get their own mapping, unmapped by deallocate()
+void large_blocks(){
+    Farebl::hugepage_arena arena(4 * huge_page_size);
+    void* small = arena.allocate(100);
+    FAREBL_CHECK(reinterpret_cast<std::uintptr_t>(small) % Farebl::hugepage_arena::block_alignment == 0);
+    size_t mapped = arena.mapped_bytes();
+    FAREBL_CHECK(mapped == 4 * huge_page_size);
+
+    void* large = arena.allocate(3 * huge_page_size / 2);
+    FAREBL_CHECK(reinterpret_cast<std::uintptr_t>(large) % huge_page_size == 0);
+    FAREBL_CHECK(arena.mapped_bytes() == mapped + 2 * huge_page_size);
+    static_cast<char*>(large)[3 * huge_page_size / 2 - 1] = 1;
+    arena.deallocate(large, 3 * huge_page_size / 2);
+    FAREBL_CHECK(arena.mapped_bytes() == mapped);
+
+    // the freed small block is reused
+    arena.deallocate(small, 100);
+    FAREBL_CHECK(arena.allocate(64 + 36) == small);
+}
+
+} // end namespace
+
+int main(){
+    run("hugepage deque push/pop, first_touch", [](){push_pop(Farebl::numa_policy::first_touch);});
+    run("hugepage deque push/pop, local_preferred", [](){push_pop(Farebl::numa_policy::local_preferred);});
+    run("hugepage deque freed on another thread", free_on_another_thread);
+    run("hugepage arena large blocks", large_blocks);
+    return finish();
+}
@@ -0,0 +1,421 @@
+/*
+    The lists (Farebl::list, index_list in both link modes, static_list, indexed_list)
+    against std::list: the random sequences of push/pop at both ends, insert/erase
+    at the random positions and the bulk operations, which the list has
+    (insert of count/range, assign, resize, remove_if, sort, parallel_sort), checked in both directions.
+*/
+#include <cstddef>      // for size_t
+#include <cstdint>      // for SIZE_MAX
+#include <iterator>     // for next, prev
+#include <list>         // for list
+#include <memory>       // for allocator
+#include <stdexcept>    // for length_error
+#include <string>       // for string
+#include <type_traits>  // for void_t, false_type, true_type
+#include <utility>      // for declval, move, pair
+#include <vector>       // for vector
+
+#include "test_common.hpp"
+#include "list.hpp"
+#include "index_list.hpp"
+#include "static_list.hpp"
+#include "indexed_list.hpp"
+
+namespace {
+
+using namespace Farebl::test;
+
+template <typename T>
+T make(uint64_t key);
+
+template <>
+int make<int>(uint64_t key) {return static_cast<int>(key % 1000);}
+
+template <>
+std::string make<std::string>(uint64_t key) {return long_string(key % 1000);}
+
+template <>
+tracked make<tracked>(uint64_t key) {return tracked(static_cast<int>(key % 1000));}
+
+
+// the bulk operations, which only some of the lists have
+template <typename List, typename = void>
+struct has_bulk_ops: std::false_type{};
+
+template <typename List>
+struct has_bulk_ops<List, std::void_t<
+    decltype(std::declval<List&>().insert(std::declval<List&>().cend(), size_t(1), std::declval<const typename List::value_type&>())),
+    decltype(std::declval<List&>().remove_if(std::declval<bool (*)(const typename List::value_type&)>())),
+    decltype(std::declval<List&>().sort())
+>>: std::true_type{};
+
+template <typename List, typename = void>
+struct has_assign: std::false_type{};
+
+template <typename List>
+struct has_assign<List, std::void_t<
+    decltype(std::declval<List&>().assign(size_t(1), std::declval<const typename List::value_type&>())),
+    decltype(std::declval<List&>().resize(size_t(1)))
+>>: std::true_type{};
+
+template <typename List, typename = void>
+struct has_index: std::false_type{};
+
+template <typename List>
+struct has_index<List, std::void_t<decltype(std::declval<List&>().nth(size_t(0)))>>: std::true_type{};
+
+
+// static_list can't take the nodes of the other list: the moved-from one keeps its moved-from elements
+template <typename List>
+constexpr bool moves_the_nodes = true;
+
+template <typename T, size_t N>
+constexpr bool moves_the_nodes<Farebl::static_list<T, N>> = false;
+
+
+template <typename List>
+void check_same(const List& l, const std::list<typename List::value_type>& ref){
+    FAREBL_CHECK(same_elements(l, ref));
+    FAREBL_CHECK(same_reversed(l, ref));
+    FAREBL_CHECK(l.empty() == ref.empty());
+    if (!ref.empty()){
+        FAREBL_CHECK(l.front() == ref.front());
+        FAREBL_CHECK(*std::prev(l.end()) == ref.back());
+    }
+}
+
+/*
+    (limit) is the capacity of the fixed-size lists: the growing operations are skipped,
+    when they would exceed it
+*/
+template <typename List>
+void differential(uint64_t seed, int steps, size_t limit){
+    using T = typename List::value_type;
+    List l;
+    std::list<T> ref;
+    random_sequence random(seed);
+
+    for (int step = 0; step < steps; ++step){
+        T value = make<T>(random.next());
+        size_t op = random.below(16);
+        bool can_grow = ref.size() + 8 <= limit;
+        switch (op){
+            case 0: case 1:
+                if (can_grow) {l.push_back(value); ref.push_back(value);}
+                break;
+            case 2: case 3:
+                if (can_grow) {l.push_front(value); ref.push_front(value);}
+                break;
+            case 4:
+                if (!ref.empty()) {l.pop_back(); ref.pop_back();}
+                break;
+            case 5:
+                if (!ref.empty()) {l.pop_front(); ref.pop_front();}
+                break;
+            case 6: case 7: {
+                if (!can_grow) break;
+                size_t pos = random.below(ref.size() + 1);
+                auto it = l.insert(std::next(l.cbegin(), static_cast<std::ptrdiff_t>(pos)), value);
+                ref.insert(std::next(ref.begin(), static_cast<std::ptrdiff_t>(pos)), value);
+                FAREBL_CHECK(*it == value);
+                break;
+            }
+            case 8: {
+                if (ref.empty()) break;
+                size_t pos = random.below(ref.size());
+                auto it = l.erase(std::next(l.cbegin(), static_cast<std::ptrdiff_t>(pos)));
+                auto ref_it = ref.erase(std::next(ref.begin(), static_cast<std::ptrdiff_t>(pos)));
+                FAREBL_CHECK((it == l.end()) == (ref_it == ref.end()));
+                if (ref_it != ref.end()) {FAREBL_CHECK(*it == *ref_it);}
+                break;
+            }
+            case 9: {
+                if (ref.empty()) break;
+                size_t first = random.below(ref.size());
+                size_t last = first + random.below(std::min<size_t>(ref.size() - first, 8) + 1);
+                l.erase(std::next(l.cbegin(), static_cast<std::ptrdiff_t>(first)), std::next(l.cbegin(), static_cast<std::ptrdiff_t>(last)));
+                ref.erase(std::next(ref.begin(), static_cast<std::ptrdiff_t>(first)), std::next(ref.begin(), static_cast<std::ptrdiff_t>(last)));
+                break;
+            }
+            case 10:
+                if (random.below(64) == 0) {l.clear(); ref.clear();}
+                break;
+            case 11: case 12: case 13:
+                if constexpr (has_bulk_ops<List>::value){
+                    size_t pos = random.below(ref.size() + 1);
+                    size_t count = random.below(6);
+                    if (!can_grow) break;
+                    if (op == 11){
+                        l.insert(std::next(l.cbegin(), static_cast<std::ptrdiff_t>(pos)), count, value);
+                        ref.insert(std::next(ref.begin(), static_cast<std::ptrdiff_t>(pos)), count, value);
+                    }
+                    else if (op == 12){
+                        std::vector<T> values;
+                        for (size_t i = 0; i < count; ++i) values.push_back(make<T>(random.next()));
+                        l.insert(std::next(l.cbegin(), static_cast<std::ptrdiff_t>(pos)), values.begin(), values.end());
+                        ref.insert(std::next(ref.begin(), static_cast<std::ptrdiff_t>(pos)), values.begin(), values.end());
+                    }
+                    else{
+                        T removed = make<T>(random.next() % 7);
+                        auto predicate = [&removed](const T& element){return element == removed;};
+                        size_t before = ref.size();
+                        ref.remove_if(predicate);
+                        FAREBL_CHECK(l.remove_if(predicate) == before - ref.size());
+                    }
+                }
+                break;
+            case 14:
+                if constexpr (has_bulk_ops<List>::value){
+                    if (random.below(16) == 0) {l.sort(); ref.sort();}
+                }
+                break;
+            case 15:
+                if constexpr (has_assign<List>::value){
+                    size_t count = random.below(std::min<size_t>(limit, 2 * ref.size() + 8));
+                    if (random.below(2) == 0){
+                        l.resize(count, value);
+                        ref.resize(count, value);
+                    }
+                    else if (random.below(8) == 0){
+                        l.assign(count, value);
+                        ref.assign(count, value);
+                    }
+                    else{
+                        std::vector<T> values;
+                        for (size_t i = 0; i < count; ++i) values.push_back(make<T>(random.next()));
+                        l.assign(values.begin(), values.end());
+                        ref.assign(values.begin(), values.end());
+                    }
+                }
+                break;
+        }
+        FAREBL_CHECK(l.size() == ref.size());
+        if (step % 13 == 0){
+            check_same(l, ref);
+            if constexpr (has_index<List>::value){
+                if (!ref.empty()){
+                    size_t k = random.below(ref.size());
+                    auto it = l.nth(k);
+                    FAREBL_CHECK(*it == *std::next(ref.begin(), static_cast<std::ptrdiff_t>(k)));
+                    FAREBL_CHECK(l.index_of(it) == k);
+                    FAREBL_CHECK(l.distance(l.begin(), it) == static_cast<std::ptrdiff_t>(k));
+                }
+            }
+        }
+    }
+    check_same(l, ref);
+}
+
+// copy, move and swap, with the empty lists on either side
+template <typename List>
+void copy_move_swap(){
+    std::list<std::string> ref;
+    List l;
+    for (int i = 0; i < 40; ++i){
+        l.push_back(long_string(i));
+        ref.push_back(long_string(i));
+    }
+
+    List copy(l);
+    check_same(copy, ref);
+
+    List assigned;
+    assigned.push_back("old");
+    assigned = l;
+    check_same(assigned, ref);
+
+    List moved(std::move(copy));
+    check_same(moved, ref);
+    if constexpr (moves_the_nodes<List>){
+        FAREBL_CHECK(copy.empty());
+    }
+    copy.clear();
+    copy.push_back("reused");
+    FAREBL_CHECK(copy.size() == 1 && copy.front() == "reused");
+
+    List move_assigned;
+    move_assigned.push_back("old");
+    move_assigned = std::move(moved);
+    check_same(move_assigned, ref);
+    if constexpr (moves_the_nodes<List>){
+        FAREBL_CHECK(moved.empty());
+    }
+
+    List empty;
+    move_assigned.swap(empty);
+    check_same(empty, ref);
+    FAREBL_CHECK(move_assigned.empty());
+    FAREBL_CHECK(move_assigned.begin() == move_assigned.end());
+    move_assigned.swap(empty);
+    check_same(move_assigned, ref);
+    FAREBL_CHECK(empty.empty());
+
+    List other_empty;
+    empty.swap(other_empty);
+    FAREBL_CHECK(empty.empty() && other_empty.empty());
+    empty.push_back("after swap");
+    FAREBL_CHECK(empty.size() == 1 && empty.front() == "after swap");
+
+    List small;
+    small.push_back("small");
+    small.swap(move_assigned);
+    check_same(small, ref);
+    FAREBL_CHECK(move_assigned.size() == 1 && move_assigned.front() == "small");
+}
+
+template <typename List>
+void element_lifetimes(){
+    {
+        List l;
+        for (int i = 0; i < 100; ++i) {l.push_back(tracked(i)); l.push_front(tracked(-i));}
+        l.erase(std::next(l.cbegin(), 10), std::next(l.cbegin(), 30));
+        l.pop_back();
+        List copy(l);
+        FAREBL_CHECK(tracked::live() == static_cast<long>(l.size() + copy.size()));
+        copy.clear();
+        FAREBL_CHECK(tracked::live() == static_cast<long>(l.size()));
+    }
+    FAREBL_CHECK(tracked::live() == 0);
+}
+
+void list_defragment(){
+    Farebl::list<tracked> l;
+    std::list<tracked> ref;
+    random_sequence random(11);
+    for (int i = 0; i < 3000; ++i){
+        l.push_back(tracked(i));
+        ref.push_back(tracked(i));
+        if (random.below(3) == 0){
+            size_t pos = random.below(ref.size());
+            l.erase(std::next(l.cbegin(), static_cast<std::ptrdiff_t>(pos)));
+            ref.erase(std::next(ref.begin(), static_cast<std::ptrdiff_t>(pos)));
+        }
+    }
+    l.defragment();
+    check_same(l, ref);
+    // the nodes of the blocks are freed one by one, the blocks with the last node
+    for (int round = 0; round < 2; ++round){
+        for (int i = 0; i < 500; ++i){
+            size_t pos = random.below(ref.size());
+            l.erase(std::next(l.cbegin(), static_cast<std::ptrdiff_t>(pos)));
+            ref.erase(std::next(ref.begin(), static_cast<std::ptrdiff_t>(pos)));
+            l.push_front(tracked(i));
+            ref.push_front(tracked(i));
+        }
+        l.defragment();
+        check_same(l, ref);
+    }
+    Farebl::list<tracked> other;
+    other.swap(l);
+    check_same(other, ref);
+    other.clear();
+    ref.clear();
+    FAREBL_CHECK(tracked::live() == 0);
+}
+
+// the list over several blocks: the blocks are freed in any order, the list keeps one pointer for them
+void list_defragment_blocks(){
+    static_assert(sizeof(Farebl::list<int>) <= 5 * sizeof(void*) + sizeof(Farebl::stats_detail::counters<>),
+                  "the blocks of defragment() cost one pointer");
+    Farebl::list<int> l;
+    std::list<int> ref;
+    for (int i = 0; i < 150000; ++i) {l.push_back(i); ref.push_back(i);}
+    l.defragment();
+    check_same(l, ref);
+    random_sequence random(12);
+    while (ref.size() > 1000){
+        if (random.below(2) == 0) {l.pop_back(); ref.pop_back();}
+        else {l.pop_front(); ref.pop_front();}
+        if (random.below(50) == 0) {l.push_front(-1); ref.push_front(-1);}
+    }
+    check_same(l, ref);
+    l.defragment();
+    check_same(l, ref);
+    Farebl::list<int> moved(std::move(l));
+    moved.clear();
+    moved.push_back(1);
+    FAREBL_CHECK(moved.size() == 1 && moved.front() == 1);
+
+    // memory_usage() counts the whole block, which the surviving nodes keep allocated
+    Farebl::list<int> pinned;
+    for (int i = 0; i < 10; ++i) {pinned.push_back(i);}
+    size_t node_bytes = pinned.memory_usage() / 10;
+    pinned.defragment();
+    FAREBL_CHECK(pinned.memory_usage() > 10 * node_bytes);
+    for (int i = 0; i < 9; ++i) {pinned.pop_back();}
+    pinned.push_back(100);
+    FAREBL_CHECK(pinned.memory_usage() > 11 * node_bytes);
+    pinned.pop_front();
+    FAREBL_CHECK(pinned.memory_usage() == node_bytes);
+}
+
+/*
+    parallel_sort against the stable std::list::sort: more than 2 * 4096 nodes, so the
+    sublists are really sorted on the threads; the keys repeat, the second field is the order
+    of the insertion (the equal keys keep it), the comparison looks at the key only
+*/
+void list_parallel_sort(){
+    using keyed = std::pair<int, int>;
+    auto by_key = [](const keyed& lhs, const keyed& rhs){return lhs.first < rhs.first;};
+    for (size_t count: {size_t(2 * 4096 + 1), size_t(3 * 4096 + 17), size_t(40000)}){
+        for (size_t threads: {2, 3}){
+            Farebl::list<keyed> l;
+            std::list<keyed> ref;
+            random_sequence random(count + threads);
+            for (size_t i = 0; i < count; ++i){
+                keyed value(static_cast<int>(random.below(100)), static_cast<int>(i));
+                l.push_back(value);
+                ref.push_back(value);
+            }
+            l.parallel_sort(by_key, threads);
+            ref.sort(by_key);
+            check_same(l, ref);
+            FAREBL_CHECK(l.size() == count);
+        }
+    }
+}
+
+void static_list_full(){
+    Farebl::static_list<int, 8> l;
+    for (int i = 0; i < 8; ++i) l.push_back(i);
+    FAREBL_CHECK(l.full());
+    FAREBL_CHECK_THROWS(l.push_back(8), std::length_error);
+    FAREBL_CHECK(l.size() == 8 && l.back() == 7);
+    l.pop_front();
+    l.push_back(8);
+    FAREBL_CHECK(l.front() == 1 && l.back() == 8);
+}
+
+} // end namespace
+
+int main(){
+    using xor_index_list = Farebl::index_list<int, std::allocator<int>, Farebl::index_list_links::xor_linked>;
+
+    run("list<int> differential", [](){differential<Farebl::list<int>>(1, 20000, SIZE_MAX);});
+    run("list<string> differential", [](){differential<Farebl::list<std::string>>(2, 8000, SIZE_MAX);});
+    run("list<tracked> differential", [](){differential<Farebl::list<tracked>>(3, 8000, SIZE_MAX);});
+    run("index_list<int> differential", [](){differential<Farebl::index_list<int>>(4, 20000, SIZE_MAX);});
+    run("index_list<int, xor_linked> differential", [](){differential<xor_index_list>(5, 20000, SIZE_MAX);});
+    run("index_list<tracked> differential", [](){differential<Farebl::index_list<tracked>>(6, 8000, SIZE_MAX);});
+    run("static_list<int, 256> differential", [](){differential<Farebl::static_list<int, 256>>(7, 20000, 256);});
+    run("static_list<tracked, 100> differential", [](){differential<Farebl::static_list<tracked, 100>>(8, 8000, 100);});
+    run("indexed_list<int> differential", [](){differential<Farebl::indexed_list<int>>(9, 20000, SIZE_MAX);});
+    run("indexed_list<tracked> differential", [](){differential<Farebl::indexed_list<tracked>>(10, 8000, SIZE_MAX);});
+    run("the lists destroy all the elements", [](){FAREBL_CHECK(tracked::live() == 0);});
+
+    run("list copy/move/swap", copy_move_swap<Farebl::list<std::string>>);
+    run("index_list copy/move/swap", copy_move_swap<Farebl::index_list<std::string>>);
+    run("static_list copy/move/swap", copy_move_swap<Farebl::static_list<std::string, 64>>);
+    run("indexed_list copy/move/swap", copy_move_swap<Farebl::indexed_list<std::string>>);
+
+    run("list element lifetimes", element_lifetimes<Farebl::list<tracked>>);
+    run("index_list element lifetimes", element_lifetimes<Farebl::index_list<tracked>>);
+    run("static_list element lifetimes", element_lifetimes<Farebl::static_list<tracked, 256>>);
+    run("indexed_list element lifetimes", element_lifetimes<Farebl::indexed_list<tracked>>);
+
+    run("list defragment", list_defragment);
+    run("list defragment over several blocks", list_defragment_blocks);
+    run("list parallel_sort", list_parallel_sort);
+    run("static_list when full", static_list_full);
+    return finish();
+}
@@ -0,0 +1,264 @@
+/*
+    Farebl::mapped_deque against std::deque: the file is reopened after the push/pop sequences
+    (with and without flush()) and must give the same contents; the damaged header, map
+    or free list must throw std::runtime_error on the open instead of the access out of
+    the mapping (or through the misaligned T*).
+*/
+#include <algorithm>    // for equal
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <cstdio>       // for remove
+#include <deque>        // for deque
+#include <fstream>      // for fstream
+#include <stdexcept>    // for out_of_range, runtime_error
+#include <string>       // for string, to_string
+#include <vector>       // for vector
+
+#include <unistd.h>     // for getpid
+
+#include "test_common.hpp"
+#include "mapped_deque.hpp"
+
+namespace {
+
+using namespace Farebl::test;
+
+struct record{
+    uint64_t key;
+    double value;
+
+    bool operator==(const record& other) const {return key == other.key && value == other.value;}
+};
+
+using small_mapped = Farebl::mapped_deque<record, 4>;
+
+// the file in the working directory of the test, removed when the test ends
+class temp_file{
+    std::string m_path;
+
+public:
+    explicit temp_file(const char* name): m_path(std::string(name) + "." + std::to_string(getpid()) + ".bin") {std::remove(m_path.c_str());}
+    ~temp_file() {std::remove(m_path.c_str());}
+
+    const std::string& path() const {return m_path;}
+};
+
+template <typename Mapped>
+void check_same(const Mapped& d, const std::deque<record>& ref){
+    FAREBL_CHECK(d.size() == ref.size());
+    if (d.size() != ref.size()) {return;}
+    bool same = true;
+    for (size_t i = 0; i < ref.size(); ++i) {same = same && d[i] == ref[i];}
+    FAREBL_CHECK(same);
+
+    std::vector<record> joined;
+    for (size_t i = 0; i < d.segment_count(); ++i){
+        auto segment = d.get_segment(i);
+        joined.insert(joined.end(), segment.begin(), segment.end());
+    }
+    FAREBL_CHECK(joined.size() == ref.size() && std::equal(joined.begin(), joined.end(), ref.begin()));
+}
+
+// the random push/pop at both ends, the file is reopened after every 500 steps
+void reopen(bool flush, uint64_t seed){
+    temp_file file("mapped_deque_reopen");
+    std::deque<record> ref;
+    random_sequence random(seed);
+    for (int round = 0; round < 20; ++round){
+        small_mapped d(file.path());
+        check_same(d, ref);
+        for (int step = 0; step < 500; ++step){
+            record value{random.next(), static_cast<double>(step)};
+            switch (random.below(5)){
+                case 0: case 1:
+                    d.push_back(value); ref.push_back(value);
+                    break;
+                case 2:
+                    d.push_front(value); ref.push_front(value);
+                    break;
+                case 3:
+                    if (!ref.empty()) {d.pop_back(); ref.pop_back();}
+                    break;
+                case 4:
+                    if (!ref.empty()) {d.pop_front(); ref.pop_front();}
+                    break;
+            }
+        }
+        if (round % 7 == 6) {d.clear(); ref.clear();}
+        check_same(d, ref);
+        if (flush) {d.flush();}
+    }
+    small_mapped d(file.path(), small_mapped::open_mode::open_existing);
+    check_same(d, ref);
+}
+
+void reopen_empty_and_create(){
+    temp_file file("mapped_deque_create");
+    {
+        small_mapped d(file.path());
+        FAREBL_CHECK(d.empty());
+        for (uint64_t i = 0; i < 10; ++i) d.push_back({i, 0.5});
+    }
+    {
+        small_mapped d(file.path());
+        FAREBL_CHECK(d.size() == 10 && d.front().key == 0 && d.back().key == 9);
+        while (!d.empty()) d.pop_front();
+    }
+    {
+        small_mapped d(file.path());
+        FAREBL_CHECK(d.empty());
+        d.push_front({1, 1.0});
+    }
+    small_mapped d(file.path(), small_mapped::open_mode::create);
+    FAREBL_CHECK(d.empty());
+    FAREBL_CHECK_THROWS(d.at(0), std::out_of_range);
+}
+
+// offsets of the fields of the header (mapped_deque.hpp): magic[8], version, value_size, then uint64_t
+enum header_field: std::streamoff{
+    bucket_size_field = 16,
+    map_offset_field = 24,
+    map_capacity_field = 32,
+    first_index_field = 40,
+    size_field = 48,
+    space_end_field = 56,
+    free_bucket_field = 64
+};
+
+uint64_t read_field(const std::string& path, header_field field){
+    std::fstream stream(path, std::ios::in | std::ios::binary);
+    uint64_t value = 0;
+    stream.seekg(field);
+    stream.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return value;
+}
+
+void write_field(const std::string& path, header_field field, uint64_t value){
+    std::fstream stream(path, std::ios::in | std::ios::out | std::ios::binary);
+    stream.seekp(field);
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// the valid file with the elements and the free buckets, then one field of its header is damaged
+void damaged_header(header_field field, uint64_t value){
+    temp_file file("mapped_deque_damaged");
+    {
+        small_mapped d(file.path());
+        for (uint64_t i = 0; i < 100; ++i) d.push_back({i, 0.0});
+        for (int i = 0; i < 30; ++i) d.pop_front();
+    }
+    uint64_t original = read_field(file.path(), field);
+    write_field(file.path(), field, value);
+    FAREBL_CHECK_THROWS(small_mapped(file.path()), std::runtime_error);
+    write_field(file.path(), field, original);
+    small_mapped d(file.path());
+    FAREBL_CHECK(d.size() == 70 && d.front().key == 30);
+}
+
+void damaged_headers(){
+    temp_file file("mapped_deque_fields");
+    uint64_t space_end;
+    uint64_t map_offset;
+    uint64_t free_bucket;
+    {
+        small_mapped d(file.path());
+        for (uint64_t i = 0; i < 100; ++i) d.push_back({i, 0.0});
+        for (int i = 0; i < 30; ++i) d.pop_front();
+    }
+    space_end = read_field(file.path(), space_end_field);
+    map_offset = read_field(file.path(), map_offset_field);
+    free_bucket = read_field(file.path(), free_bucket_field);
+    FAREBL_CHECK(free_bucket != 0);
+
+    damaged_header(bucket_size_field, 8);
+    damaged_header(first_index_field, uint64_t(1) << 40);
+    damaged_header(first_index_field, 0);           // the used slots move onto the empty slots
+    damaged_header(size_field, 100000);
+    damaged_header(size_field, ~uint64_t(0));
+    damaged_header(map_capacity_field, space_end);
+    damaged_header(map_offset_field, space_end + 8);
+    damaged_header(map_offset_field, map_offset + 1);
+    damaged_header(space_end_field, uint64_t(1) << 50);
+    damaged_header(space_end_field, 0);
+    damaged_header(free_bucket_field, space_end);
+    damaged_header(free_bucket_field, 3);
+}
+
+// the free list, which points to itself, would hang the next allocations
+void cyclic_free_list(){
+    temp_file file("mapped_deque_cycle");
+    uint64_t free_bucket;
+    {
+        small_mapped d(file.path());
+        for (uint64_t i = 0; i < 20; ++i) d.push_back({i, 0.0});
+        for (int i = 0; i < 20; ++i) d.pop_back();
+    }
+    free_bucket = read_field(file.path(), free_bucket_field);
+    FAREBL_CHECK(free_bucket != 0);
+    {
+        std::fstream stream(file.path(), std::ios::in | std::ios::out | std::ios::binary);
+        stream.seekp(static_cast<std::streamoff>(free_bucket));
+        stream.write(reinterpret_cast<const char*>(&free_bucket), sizeof(free_bucket));
+    }
+    FAREBL_CHECK_THROWS(small_mapped(file.path()), std::runtime_error);
+}
+
+void write_at(const std::string& path, uint64_t offset, uint64_t value){
+    std::fstream stream(path, std::ios::in | std::ios::out | std::ios::binary);
+    stream.seekp(static_cast<std::streamoff>(offset));
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// the bucket offset inside the used space, but not aligned for T: the map slot, the head and the next of the free list
+void misaligned_buckets(){
+    static_assert(alignof(record) > 4, "the offsets below are misaligned by 4");
+    temp_file file("mapped_deque_misaligned");
+    {
+        small_mapped d(file.path());
+        for (uint64_t i = 0; i < 100; ++i) d.push_back({i, 0.0});
+        for (int i = 0; i < 30; ++i) d.pop_front();
+    }
+    uint64_t map_offset = read_field(file.path(), map_offset_field);
+    uint64_t first_slot = read_field(file.path(), first_index_field) / 4;
+    uint64_t free_bucket = read_field(file.path(), free_bucket_field);
+    uint64_t used_bucket = 0;
+    {
+        std::fstream stream(file.path(), std::ios::in | std::ios::binary);
+        stream.seekg(static_cast<std::streamoff>(map_offset + first_slot * sizeof(uint64_t)));
+        stream.read(reinterpret_cast<char*>(&used_bucket), sizeof(used_bucket));
+    }
+    FAREBL_CHECK(used_bucket != 0 && free_bucket != 0);
+    uint64_t next_free = 0;
+    {
+        std::fstream stream(file.path(), std::ios::in | std::ios::binary);
+        stream.seekg(static_cast<std::streamoff>(free_bucket));
+        stream.read(reinterpret_cast<char*>(&next_free), sizeof(next_free));
+    }
+
+    write_at(file.path(), map_offset + first_slot * sizeof(uint64_t), used_bucket + 4);
+    FAREBL_CHECK_THROWS(small_mapped(file.path()), std::runtime_error);
+    write_at(file.path(), map_offset + first_slot * sizeof(uint64_t), used_bucket);
+
+    write_field(file.path(), free_bucket_field, used_bucket + 4);
+    FAREBL_CHECK_THROWS(small_mapped(file.path()), std::runtime_error);
+    write_field(file.path(), free_bucket_field, free_bucket);
+
+    write_at(file.path(), free_bucket, used_bucket + 4);
+    FAREBL_CHECK_THROWS(small_mapped(file.path()), std::runtime_error);
+    write_at(file.path(), free_bucket, next_free);
+
+    small_mapped d(file.path());
+    FAREBL_CHECK(d.size() == 70 && d.front().key == 30);
+}
+
+} // end namespace
+
+int main(){
+    run("mapped_deque reopen with flush()", [](){reopen(true, 1);});
+    run("mapped_deque reopen without flush()", [](){reopen(false, 2);});
+    run("mapped_deque reopen empty, create truncates", reopen_empty_and_create);
+    run("mapped_deque damaged header throws", damaged_headers);
+    run("mapped_deque cyclic free list throws", cyclic_free_list);
+    run("mapped_deque misaligned buckets throw", misaligned_buckets);
+    return finish();
+}
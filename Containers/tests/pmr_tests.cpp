@@ -0,0 +1,142 @@
+/*
+    The containers with std::pmr::polymorphic_allocator (pmr.hpp): the allocator doesn't
+    propagate on copy/move assignment and can't be assigned at all, so the assignment
+    must keep the own memory resource of the container: the nodes/buckets are stolen
+    only from the container with the same resource, else the elements are copied/moved.
+*/
+#include <cstddef>          // for size_t, max_align_t
+#include <memory_resource>  // for memory_resource, new_delete_resource
+#include <string>           // for string
+#include <utility>          // for move
+#include <vector>           // for vector
+
+#include "test_common.hpp"
+#include "pmr.hpp"
+
+namespace {
+
+using namespace Farebl::test;
+
+// the resource, which counts its live bytes (over new_delete_resource)
+class counting_resource: public std::pmr::memory_resource{
+    long m_live_bytes = 0;
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        m_live_bytes += static_cast<long>(bytes);
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        m_live_bytes -= static_cast<long>(bytes);
+        std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+public:
+    long live_bytes() const {return m_live_bytes;}
+};
+
+template <typename Container>
+void fill(Container& c, int count, int key){
+    for (int i = 0; i < count; ++i) c.push_back(long_string(key + i));
+}
+
+template <typename Container>
+std::vector<std::string> contents(const Container& c){
+    return std::vector<std::string>(c.begin(), c.end());
+}
+
+template <typename Container>
+void assignment_keeps_the_resource(){
+    counting_resource own;
+    counting_resource foreign;
+    {
+        Container target(&own);
+        fill(target, 10, 0);
+
+        Container same_resource(&own);
+        fill(same_resource, 30, 100);
+        Container other_resource(&foreign);
+        fill(other_resource, 50, 200);
+        std::vector<std::string> expected = contents(other_resource);
+
+        // copy from the other resource: the copies are allocated by the own one
+        long foreign_before = foreign.live_bytes();
+        target = other_resource;
+        FAREBL_CHECK(contents(target) == expected);
+        FAREBL_CHECK(target.get_allocator().resource() == &own);
+        FAREBL_CHECK(foreign.live_bytes() == foreign_before);
+
+        // move from the other resource: the elements are moved, the nodes aren't taken
+        target = std::move(other_resource);
+        FAREBL_CHECK(contents(target) == expected);
+        FAREBL_CHECK(target.get_allocator().resource() == &own);
+        FAREBL_CHECK(other_resource.get_allocator().resource() == &foreign);
+
+        // move from the same resource: the memory is taken as is
+        expected = contents(same_resource);
+        long own_before = own.live_bytes();
+        target = std::move(same_resource);
+        FAREBL_CHECK(contents(target) == expected);
+        FAREBL_CHECK(same_resource.empty());
+        FAREBL_CHECK(own.live_bytes() <= own_before);
+
+        Container copy(target);
+        FAREBL_CHECK(contents(copy) == expected);
+        copy = target;
+        FAREBL_CHECK(contents(copy) == expected);
+    }
+    FAREBL_CHECK(own.live_bytes() == 0);
+    FAREBL_CHECK(foreign.live_bytes() == 0);
+}
+
+void arena_and_pool(){
+    Farebl::pmr::monotonic_arena arena(1024);
+    {
+        Farebl::pmr::list<int> l(&arena);
+        Farebl::pmr::deque<int> d(&arena);
+        for (int i = 0; i < 1000; ++i) {l.push_back(i); d.push_back(i);}
+        Farebl::pmr::list<int> copy(&arena);
+        copy = l;
+        FAREBL_CHECK(copy.size() == 1000 && copy.back() == 999 && d[999] == 999);
+    }
+    arena.release();
+
+    Farebl::pmr::pool_resource pool({Farebl::pmr::list_node_bytes<std::string>});
+    {
+        Farebl::pmr::list<std::string> l(&pool);
+        fill(l, 100, 0);
+        Farebl::pmr::list<std::string> other(&pool);
+        other = std::move(l);
+        FAREBL_CHECK(other.size() == 100 && l.empty());
+    }
+}
+
+// the blocks of defragment() and their bookkeeping come from the resource of the list
+void defragment_uses_the_resource(){
+    counting_resource resource;
+    {
+        Farebl::pmr::list<std::string> l(&resource);
+        fill(l, 200, 0);
+        std::vector<std::string> expected = contents(l);
+        l.defragment();
+        FAREBL_CHECK(contents(l) == expected);
+        FAREBL_CHECK(resource.live_bytes() > 0);
+        l.pop_front();
+        l.push_back("new");
+        l.clear();
+    }
+    FAREBL_CHECK(resource.live_bytes() == 0);
+}
+
+} // end namespace
+
+int main(){
+    run("pmr::list assignment keeps the resource", assignment_keeps_the_resource<Farebl::pmr::list<std::string>>);
+    run("pmr::deque assignment keeps the resource", assignment_keeps_the_resource<Farebl::pmr::deque<std::string>>);
+    run("pmr containers on monotonic_arena and pool_resource", arena_and_pool);
+    run("pmr::list defragment uses the resource", defragment_uses_the_resource);
+    return finish();
+}
@@ -0,0 +1,124 @@
+/*
+    Farebl::record_deque against std::deque<std::string>: the random push_back/pop_front
+    of the records of any length (empty ones, ones across the bucket end, ones longer
+    than the bucket), the iteration over the buckets and the reuse of the memory.
+*/
+#include <cstddef>      // for size_t
+#include <deque>        // for deque
+#include <memory>       // for allocator
+#include <stdexcept>    // for length_error
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <utility>      // for move
+
+#include "test_common.hpp"
+#include "record_deque.hpp"
+
+namespace {
+
+using namespace Farebl::test;
+
+using small_records = Farebl::record_deque<std::allocator<char>, 64>;
+
+template <typename Records>
+void check_same(const Records& d, const std::deque<std::string>& ref){
+    FAREBL_CHECK(d.size() == ref.size());
+    FAREBL_CHECK(d.empty() == ref.empty());
+    size_t count = 0;
+    bool same = true;
+    auto ref_it = ref.begin();
+    for (std::string_view record: d){
+        same = same && ref_it != ref.end() && record == *ref_it;
+        if (ref_it != ref.end()) {++ref_it;}
+        ++count;
+    }
+    FAREBL_CHECK(same && count == ref.size());
+    if (!ref.empty()){
+        FAREBL_CHECK(d.front() == ref.front());
+        FAREBL_CHECK(d.back() == ref.back());
+    }
+}
+
+std::string make_record(random_sequence& random){
+    size_t length;
+    switch (random.below(8)){
+        case 0: length = 0; break;
+        case 1: length = 60 + random.below(200); break; // longer than the bucket of 64 bytes
+        default: length = random.below(40); break;
+    }
+    std::string result(length, ' ');
+    for (char& c: result) {c = static_cast<char>('a' + random.below(26));}
+    return result;
+}
+
+void differential(uint64_t seed, int steps){
+    small_records d;
+    std::deque<std::string> ref;
+    random_sequence random(seed);
+    for (int step = 0; step < steps; ++step){
+        switch (random.below(7)){
+            case 0: case 1: case 2: {
+                std::string record = make_record(random);
+                d.push_back(record);
+                ref.push_back(std::move(record));
+                break;
+            }
+            case 3: {
+                // the record is formatted straight into the bucket
+                std::string record = make_record(random);
+                char* destination = d.append_back(record.size());
+                for (size_t i = 0; i < record.size(); ++i) {destination[i] = record[i];}
+                ref.push_back(std::move(record));
+                break;
+            }
+            case 4: case 5:
+                if (!ref.empty()) {d.pop_front(); ref.pop_front();}
+                break;
+            case 6:
+                if (random.below(40) == 0) {d.clear(); ref.clear();}
+                else if (random.below(40) == 0) {d.shrink_to_fit();}
+                break;
+        }
+        if (step % 7 == 0) {check_same(d, ref);}
+    }
+    check_same(d, ref);
+}
+
+// the queue of the same length keeps the same buckets: no growth of memory_usage()
+void steady_memory(){
+    small_records d;
+    for (int i = 0; i < 100; ++i) {d.push_back(std::string(10, 'x'));}
+    size_t usage = 0;
+    for (int round = 0; round < 50; ++round){
+        for (int i = 0; i < 100; ++i) {d.pop_front(); d.push_back(std::string(10, 'y'));}
+        if (round == 5) {usage = d.memory_usage();}
+    }
+    FAREBL_CHECK(d.memory_usage() == usage);
+    FAREBL_CHECK(d.size() == 100 && d.front() == std::string(10, 'y'));
+    d.clear();
+    d.shrink_to_fit();
+    FAREBL_CHECK(d.memory_usage() == 0 && d.begin() == d.end());
+}
+
+void move_and_limits(){
+    small_records d;
+    d.push_back("first");
+    d.push_back(std::string(1000, 'z'));
+    d.push_back("");
+    small_records moved(std::move(d));
+    FAREBL_CHECK(d.empty() && d.begin() == d.end());
+    FAREBL_CHECK(moved.size() == 3 && moved.front() == "first" && moved.back().empty());
+    d.push_back("reused");
+    FAREBL_CHECK(d.size() == 1 && d.front() == "reused");
+    FAREBL_CHECK_THROWS(d.append_back(small_records::max_record_size + 1), std::length_error);
+}
+
+} // end namespace
+
+int main(){
+    run("record_deque differential", [](){differential(1, 30000);});
+    run("record_deque differential, another seed", [](){differential(2, 30000);});
+    run("record_deque reuses its buckets", steady_memory);
+    run("record_deque move and the record limit", move_and_limits);
+    return finish();
+}
@@ -0,0 +1,235 @@
+/*
+    The round trips of serialization.hpp through a pipe and a file: deque -> deque,
+    deque -> list, list -> deque, the appending read, the empty containers, the data
+    longer than one chunk of the pipe, the mismatch of the element size, the truncated data
+    and the count of the header, which the data doesn't have.
+*/
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t, uint32_t
+#include <cstdio>       // for remove
+#include <deque>        // for deque
+#include <memory>       // for allocator
+#include <stdexcept>    // for runtime_error
+#include <string>       // for string, to_string
+#include <thread>       // for thread
+#include <vector>       // for vector
+
+#include <fcntl.h>      // for open, O_RDWR, O_CREAT, O_TRUNC
+#include <unistd.h>     // for close, lseek, ftruncate, getpid, pipe, write
+
+#include "test_common.hpp"
+#include "serialization.hpp"
+
+namespace {
+
+using namespace Farebl::test;
+
+struct point{
+    double x;
+    double y;
+    uint32_t id;
+
+    bool operator==(const point& other) const {return x == other.x && y == other.y && id == other.id;}
+};
+
+// trivially copyable, but not default constructible
+class key{
+    uint64_t m_value;
+
+public:
+    explicit key(uint64_t value): m_value(value) {}
+    uint64_t value() const {return m_value;}
+};
+
+// the file in the working directory of the test, removed when the test ends
+class temp_file{
+    std::string m_path;
+    int m_fd;
+
+public:
+    explicit temp_file(const char* name):
+        m_path(std::string(name) + "." + std::to_string(getpid()) + ".bin"),
+        m_fd(::open(m_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644))
+    {}
+    ~temp_file() {::close(m_fd); std::remove(m_path.c_str());}
+
+    int fd() const {return m_fd;}
+    void rewind() const {lseek(m_fd, 0, SEEK_SET);}
+    void truncate(off_t size) const {(void)!ftruncate(m_fd, size);}
+};
+
+template <typename Container>
+std::vector<point> contents(const Container& c){
+    return std::vector<point>(c.begin(), c.end());
+}
+
+std::vector<point> make_points(size_t count, uint64_t seed){
+    random_sequence random(seed);
+    std::vector<point> result;
+    for (size_t i = 0; i < count; ++i){
+        result.push_back({static_cast<double>(random.below(1000)), static_cast<double>(random.below(1000)) / 8, static_cast<uint32_t>(i)});
+    }
+    return result;
+}
+
+template <size_t BucketSize>
+void deque_round_trip(){
+    using Deque = Farebl::deque<point, std::allocator<point>, BucketSize>;
+    for (size_t count: {size_t(0), size_t(1), BucketSize, 5 * BucketSize + 3, size_t(20000)}){
+        temp_file file("serialization_deque");
+        std::vector<point> points = make_points(count, count);
+        Deque source;
+        source.push_back({-1, -1, 0});
+        for (const point& p: points) {source.push_back(p);}
+        source.pop_front(); // the first segment is partial
+
+        Farebl::serialization::write(file.fd(), source);
+        file.rewind();
+        Deque target;
+        target.push_back({7, 7, 7});
+        Farebl::serialization::read(file.fd(), target);
+        std::vector<point> expected = points;
+        expected.insert(expected.begin(), point{7, 7, 7});
+        FAREBL_CHECK(contents(target) == expected);
+
+        // the data of the deque is read into the list
+        file.rewind();
+        Farebl::list<point> l;
+        Farebl::serialization::read(file.fd(), l);
+        FAREBL_CHECK(contents(l) == points);
+    }
+}
+
+void list_round_trip(){
+    for (size_t count: {size_t(0), size_t(3), size_t(10000)}){
+        temp_file file("serialization_list");
+        std::vector<point> points = make_points(count, count + 1);
+        Farebl::list<point> source(points.begin(), points.end());
+        Farebl::serialization::write(file.fd(), source);
+        file.rewind();
+        Farebl::deque<point> d;
+        Farebl::serialization::read(file.fd(), d);
+        FAREBL_CHECK(contents(d) == points);
+        file.rewind();
+        Farebl::list<point> l;
+        Farebl::serialization::read(file.fd(), l);
+        FAREBL_CHECK(contents(l) == points);
+    }
+}
+
+void pipe_round_trip(){
+    int fds[2];
+    FAREBL_CHECK(pipe(fds) == 0);
+    std::vector<point> points = make_points(500, 3);
+    Farebl::deque<point, std::allocator<point>, 16> source;
+    for (const point& p: points) {source.push_back(p);}
+    Farebl::serialization::write(fds[1], source);
+    Farebl::deque<point> target;
+    Farebl::serialization::read(fds[0], target);
+    FAREBL_CHECK(contents(target) == points);
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+// more than one chunk of detail::stream_chunk_bytes: the writer runs on its thread, the pipe buffer is small
+void long_pipe_round_trip(){
+    int fds[2];
+    FAREBL_CHECK(pipe(fds) == 0);
+    std::vector<point> points = make_points(3 * Farebl::serialization::detail::stream_chunk_bytes / sizeof(point) + 5, 9);
+    Farebl::deque<point> source;
+    for (const point& p: points) {source.push_back(p);}
+    std::thread writer([&](){Farebl::serialization::write(fds[1], source);});
+    Farebl::deque<point> target;
+    target.push_back({1, 2, 3});
+    Farebl::serialization::read(fds[0], target);
+    writer.join();
+    points.insert(points.begin(), point{1, 2, 3});
+    FAREBL_CHECK(contents(target) == points);
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+void list_of_not_default_constructible(){
+    temp_file file("serialization_key");
+    Farebl::deque<key> source;
+    for (uint64_t i = 0; i < 5000; ++i) {source.push_back(key(i * 7));}
+    Farebl::serialization::write(file.fd(), source);
+    file.rewind();
+    Farebl::list<key> l;
+    Farebl::serialization::read(file.fd(), l);
+    bool same = l.size() == 5000;
+    uint64_t i = 0;
+    for (const key& k: l) {same = same && k.value() == 7 * i++;}
+    FAREBL_CHECK(same);
+}
+
+// the header with the count, which isn't in the data: nothing is allocated for it
+void bad_count(){
+    using counted_deque = Farebl::deque<point, counting_allocator<point>>;
+    std::vector<point> points = make_points(10, 5);
+    for (uint64_t count: {uint64_t(11), uint64_t(1) << 40, ~uint64_t(0)}){
+        Farebl::serialization::Header header{count, sizeof(point)};
+        temp_file file("serialization_count");
+        FAREBL_CHECK(::write(file.fd(), &header, sizeof(header)) == sizeof(header));
+        FAREBL_CHECK(::write(file.fd(), points.data(), points.size() * sizeof(point)) == static_cast<ssize_t>(points.size() * sizeof(point)));
+
+        file.rewind();
+        counted_deque d;
+        d.push_back({1, 2, 3});
+        size_t calls = allocation_counts::calls;
+        FAREBL_CHECK_THROWS(Farebl::serialization::read(file.fd(), d), std::runtime_error);
+        FAREBL_CHECK(allocation_counts::calls == calls);
+        FAREBL_CHECK(d.size() == 1 && d.front() == (point{1, 2, 3}));
+
+        file.rewind();
+        Farebl::list<point> l;
+        FAREBL_CHECK_THROWS(Farebl::serialization::read(file.fd(), l), std::runtime_error);
+        FAREBL_CHECK(l.empty());
+
+        // the length of the pipe isn't known: at most one chunk is reserved before the data ends
+        int fds[2];
+        FAREBL_CHECK(pipe(fds) == 0);
+        FAREBL_CHECK(::write(fds[1], &header, sizeof(header)) == sizeof(header));
+        FAREBL_CHECK(::write(fds[1], points.data(), points.size() * sizeof(point)) == static_cast<ssize_t>(points.size() * sizeof(point)));
+        ::close(fds[1]);
+        size_t bytes = allocation_counts::bytes;
+        FAREBL_CHECK_THROWS(Farebl::serialization::read(fds[0], d), std::runtime_error);
+        FAREBL_CHECK(allocation_counts::bytes - bytes <= 2 * Farebl::serialization::detail::stream_chunk_bytes);
+        FAREBL_CHECK(d.size() == 1 && d.front() == (point{1, 2, 3}));
+        ::close(fds[0]);
+    }
+}
+
+void bad_data(){
+    temp_file file("serialization_bad");
+    Farebl::deque<point> source;
+    for (const point& p: make_points(1000, 4)) {source.push_back(p);}
+    Farebl::serialization::write(file.fd(), source);
+
+    file.rewind();
+    Farebl::deque<uint32_t> wrong_type;
+    FAREBL_CHECK_THROWS(Farebl::serialization::read(file.fd(), wrong_type), std::runtime_error);
+    FAREBL_CHECK(wrong_type.empty());
+
+    // the truncated data: the deque isn't changed
+    file.truncate(static_cast<off_t>(sizeof(Farebl::serialization::Header) + 100 * sizeof(point)));
+    file.rewind();
+    Farebl::deque<point> target;
+    target.push_back({1, 2, 3});
+    FAREBL_CHECK_THROWS(Farebl::serialization::read(file.fd(), target), std::runtime_error);
+    FAREBL_CHECK(target.size() == 1 && target.front() == (point{1, 2, 3}));
+}
+
+} // end namespace
+
+int main(){
+    run("serialization deque round trip, bucket 4", deque_round_trip<4>);
+    run("serialization deque round trip, bucket 1000", deque_round_trip<1000>);
+    run("serialization list round trip", list_round_trip);
+    run("serialization through a pipe", pipe_round_trip);
+    run("serialization through a pipe, longer than one chunk", long_pipe_round_trip);
+    run("serialization into the list of not default constructible elements", list_of_not_default_constructible);
+    run("serialization of the wrong or truncated data", bad_data);
+    run("serialization of the count, which isn't in the data", bad_count);
+    return finish();
+}
@@ -0,0 +1,110 @@
+/*
+    Farebl::slot_map against std::map<handle index, value>: the random insert/erase,
+    the stale handles of the erased elements, the iteration over the runs of holes
+    (checked against the reference) and the element lifetimes.
+*/
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint32_t
+#include <iterator>     // for next
+#include <map>          // for map
+#include <string>       // for string
+#include <utility>      // for pair
+#include <vector>       // for vector
+
+#include "test_common.hpp"
+#include "slot_map.hpp"
+
+namespace {
+
+using namespace Farebl::test;
+
+using string_map = Farebl::slot_map<std::string>;
+using handle = string_map::handle;
+
+void check_same(const string_map& m, const std::map<uint32_t, std::pair<handle, std::string>>& ref){
+    FAREBL_CHECK(m.size() == ref.size());
+    FAREBL_CHECK(m.empty() == ref.empty());
+    // the iteration visits the live slots in the order of the indices
+    auto ref_it = ref.begin();
+    bool same = true;
+    size_t count = 0;
+    for (auto it = m.begin(); it != m.end(); ++it, ++count){
+        same = same && ref_it != ref.end() && it.get_handle() == ref_it->second.first && *it == ref_it->second.second;
+        if (ref_it != ref.end()) {++ref_it;}
+    }
+    FAREBL_CHECK(same && count == ref.size());
+    for (const auto& entry: ref){
+        const std::string* value = m.get(entry.second.first);
+        same = same && value != nullptr && *value == entry.second.second;
+    }
+    FAREBL_CHECK(same);
+}
+
+void differential(uint64_t seed, int steps){
+    string_map m;
+    std::map<uint32_t, std::pair<handle, std::string>> ref;
+    std::vector<handle> stale;
+    random_sequence random(seed);
+
+    for (int step = 0; step < steps; ++step){
+        // the size walks up and down: the runs of holes grow, merge and are reused
+        bool grow = (step / 2000) % 2 == 0;
+        if (random.below(10) < (grow ? 7u : 3u)){
+            std::string value = long_string(random.next() % 1000);
+            handle h = (random.below(2) == 0) ? m.insert(value) : m.emplace(value);
+            FAREBL_CHECK(ref.count(h.index) == 0);
+            ref[h.index] = {h, value};
+        }
+        else if (!ref.empty()){
+            auto it = ref.lower_bound(static_cast<uint32_t>(random.below(m.slot_count())));
+            if (it == ref.end()) {it = ref.begin();}
+            handle h = it->second.first;
+            if (random.below(2) == 0){
+                FAREBL_CHECK(m.erase(h));
+            }
+            else{
+                auto map_it = m.begin();
+                while (map_it.get_handle() != h) {++map_it;}
+                auto next = m.erase(map_it);
+                auto ref_next = std::next(it);
+                FAREBL_CHECK(ref_next == ref.end() ? next == m.end() : next.get_handle() == ref_next->second.first);
+            }
+            stale.push_back(h);
+            ref.erase(it);
+        }
+        if (step % 97 == 0){
+            check_same(m, ref);
+            bool all_stale = true;
+            for (handle h: stale) {all_stale = all_stale && !m.contains(h) && m.get(h) == nullptr && !m.erase(h);}
+            FAREBL_CHECK(all_stale);
+        }
+    }
+    check_same(m, ref);
+
+    m.clear();
+    FAREBL_CHECK(m.empty() && m.begin() == m.end());
+    for (const auto& entry: ref) {FAREBL_CHECK(!m.contains(entry.second.first));}
+}
+
+void element_lifetimes(){
+    {
+        Farebl::slot_map<tracked> m;
+        std::vector<Farebl::slot_map<tracked>::handle> handles;
+        for (int i = 0; i < 1000; ++i) {handles.push_back(m.emplace(i));}
+        for (size_t i = 0; i < handles.size(); i += 3) {m.erase(handles[i]);}
+        for (int i = 0; i < 100; ++i) {m.insert(tracked(-i));}
+        FAREBL_CHECK(tracked::live() == static_cast<long>(m.size()));
+        FAREBL_CHECK(m.slot_count() == 1000);
+        FAREBL_CHECK(m[handles[1]].value() == 1);
+    }
+    FAREBL_CHECK(tracked::live() == 0);
+}
+
+} // end namespace
+
+int main(){
+    run("slot_map differential", [](){differential(1, 20000);});
+    run("slot_map differential, another seed", [](){differential(2, 20000);});
+    run("slot_map element lifetimes", element_lifetimes);
+    return finish();
+}
@@ -0,0 +1,156 @@
+/*
+    Farebl::small_deque against std::deque: the random push/pop at both ends across the spill
+    and the return to the inline storage, the copy/move in both states, the element lifetimes.
+*/
+#include <cstddef>      // for size_t
+#include <deque>        // for deque
+#include <memory>       // for allocator
+#include <stdexcept>    // for out_of_range
+#include <string>       // for string
+#include <utility>      // for move
+
+#include "test_common.hpp"
+#include "small_deque.hpp"
+
+namespace {
+
+using namespace Farebl::test;
+
+template <typename T>
+T make(uint64_t key);
+
+template <>
+int make<int>(uint64_t key) {return static_cast<int>(key % 100000);}
+
+template <>
+std::string make<std::string>(uint64_t key) {return long_string(key % 100000);}
+
+template <>
+tracked make<tracked>(uint64_t key) {return tracked(static_cast<int>(key % 100000));}
+
+
+template <typename Small>
+void check_same(const Small& d, const std::deque<typename Small::value_type>& ref){
+    FAREBL_CHECK(same_elements(d, ref));
+    if (!ref.empty()){
+        FAREBL_CHECK(d.front() == ref.front());
+        FAREBL_CHECK(d.back() == ref.back());
+        FAREBL_CHECK(d[ref.size() / 2] == ref[ref.size() / 2]);
+    }
+}
+
+template <typename T, size_t InlineN>
+void differential(uint64_t seed, int steps){
+    using Small = Farebl::small_deque<T, InlineN, std::allocator<T>, 4>;
+    Small d;
+    std::deque<T> ref;
+    random_sequence random(seed);
+    bool was_spilled = false;
+    bool was_unspilled = false;
+
+    for (int step = 0; step < steps; ++step){
+        T value = make<T>(random.next());
+        // the size walks around InlineN: the spill and the return happen many times
+        bool grow = ref.size() < InlineN / 2 || (ref.size() < 3 * InlineN && random.below(2) == 0);
+        switch (random.below(4) + (grow ? 0 : 4)){
+            case 0: d.push_back(value); ref.push_back(value); break;
+            case 1: d.push_front(value); ref.push_front(value); break;
+            case 2: FAREBL_CHECK(d.emplace_back(value) == value); ref.push_back(value); break;
+            case 3: d.push_back(d.empty() ? value : d.front()); ref.push_back(ref.empty() ? value : ref.front()); break;
+            case 4: case 5: if (!ref.empty()) {d.pop_back(); ref.pop_back();} break;
+            case 6: if (!ref.empty()) {d.pop_front(); ref.pop_front();} break;
+            case 7:
+                if (!d.is_inline()) {was_spilled = true;}
+                d.shrink_to_fit();
+                if (d.is_inline() && was_spilled) {was_unspilled = true;}
+                FAREBL_CHECK(d.is_inline() == (ref.size() <= InlineN));
+                break;
+        }
+        FAREBL_CHECK(d.size() == ref.size());
+        if (step % 13 == 0) {check_same(d, ref);}
+    }
+    check_same(d, ref);
+    FAREBL_CHECK(was_unspilled);
+}
+
+template <typename T>
+void copy_move(size_t count){
+    using Small = Farebl::small_deque<T, 8>;
+    std::deque<T> ref;
+    Small d;
+    for (size_t i = 0; i < count; ++i) {d.push_front(make<T>(i)); ref.push_front(make<T>(i));}
+    FAREBL_CHECK(d.is_inline() == (count <= 8));
+
+    Small copy(d);
+    check_same(copy, ref);
+    check_same(d, ref);
+    FAREBL_CHECK(copy.is_inline() == d.is_inline());
+
+    Small assigned;
+    for (int i = 0; i < 20; ++i) assigned.push_back(make<T>(1000 + i));
+    assigned = d;
+    check_same(assigned, ref);
+    Small& self = assigned;
+    assigned = self;
+    check_same(assigned, ref);
+
+    Small moved(std::move(copy));
+    check_same(moved, ref);
+    FAREBL_CHECK(copy.empty() && copy.is_inline());
+    copy.push_back(make<T>(7));
+    FAREBL_CHECK(copy.size() == 1 && copy.front() == make<T>(7));
+
+    Small move_assigned;
+    move_assigned.push_back(make<T>(3));
+    move_assigned = std::move(moved);
+    check_same(move_assigned, ref);
+    FAREBL_CHECK(moved.empty());
+
+    move_assigned.clear();
+    FAREBL_CHECK(move_assigned.empty() && move_assigned.is_inline());
+}
+
+void element_lifetimes(){
+    {
+        Farebl::small_deque<tracked, 4> d;
+        for (int i = 0; i < 30; ++i) {d.push_back(tracked(i)); d.emplace_front(-i);}
+        Farebl::small_deque<tracked, 4> copy(d);
+        for (int i = 0; i < 57; ++i) d.pop_back();
+        d.shrink_to_fit();
+        FAREBL_CHECK(d.is_inline() && d.size() == 3);
+        Farebl::small_deque<tracked, 4> moved(std::move(copy));
+        copy = d;
+        FAREBL_CHECK(tracked::live() == static_cast<long>(d.size() + copy.size() + moved.size()));
+    }
+    FAREBL_CHECK(tracked::live() == 0);
+}
+
+void inline_size_and_bounds(){
+    // the inline storage and the spilled deque share the place
+    static_assert(
+        sizeof(Farebl::small_deque<int, 16>) < sizeof(Farebl::deque<int>) + 16 * sizeof(int),
+        "the spilled deque doesn't take the place of its own"
+    );
+    Farebl::small_deque<int, 4> d;
+    FAREBL_CHECK_THROWS(d.at(0), std::out_of_range);
+    for (int i = 0; i < 4; ++i) d.push_back(i);
+    FAREBL_CHECK(d.is_inline() && d.at(3) == 3);
+    d.emplace_back(4);
+    FAREBL_CHECK(!d.is_inline() && d.at(4) == 4);
+    FAREBL_CHECK_THROWS(d.at(5), std::out_of_range);
+}
+
+} // end namespace
+
+int main(){
+    run("small_deque<int, 4> differential", [](){differential<int, 4>(1, 20000);});
+    run("small_deque<string, 8> differential", [](){differential<std::string, 8>(2, 10000);});
+    run("small_deque<tracked, 5> differential", [](){differential<tracked, 5>(3, 10000);});
+    run("small_deque<tracked> differential destroys all", [](){FAREBL_CHECK(tracked::live() == 0);});
+    run("small_deque copy/move inline", [](){copy_move<std::string>(5);});
+    run("small_deque copy/move spilled", [](){copy_move<std::string>(50);});
+    run("small_deque copy/move of tracked", [](){copy_move<tracked>(30);});
+    run("small_deque element lifetimes", element_lifetimes);
+    run("small_deque inline size and at()", inline_size_and_bounds);
+    return finish();
+}
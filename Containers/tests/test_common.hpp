@@ -0,0 +1,172 @@
+#ifndef FAREBL_TEST_COMMON_H
+#define FAREBL_TEST_COMMON_H
+
+#include <algorithm>    // for equal
+#include <atomic>       // for atomic
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <cstdio>       // for fprintf, printf, fflush
+#include <exception>    // for exception
+#include <memory>       // for allocator
+#include <string>       // for string, to_string
+#include <utility>      // for move
+
+namespace Farebl {
+namespace test {
+
+/*
+    Minimal harness of the tests: FAREBL_CHECK records the failure and continues,
+    run() calls the test function and reports the escaped exception, finish() is
+    the exit code of main() (ctest treats non-zero as the failed test).
+    The checks don't use assert(), so they work in the Release build too.
+*/
+inline int failed_checks = 0;
+inline int failed_tests = 0;
+
+inline void report_failure(const char* expression, const char* file, int line){
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    ++failed_checks;
+}
+
+template <typename Func>
+void run(const char* name, Func func){
+    int failed_before = failed_checks;
+    try{
+        func();
+    }
+    catch(const std::exception& e){
+        std::fprintf(stderr, "%s: unexpected exception: %s\n", name, e.what());
+        ++failed_checks;
+    }
+    catch(...){
+        std::fprintf(stderr, "%s: unexpected exception\n", name);
+        ++failed_checks;
+    }
+    if (failed_checks != failed_before){
+        std::fprintf(stderr, "FAILED: %s\n", name);
+        ++failed_tests;
+    }
+    else{
+        std::printf("passed: %s\n", name);
+    }
+    std::fflush(stdout);
+}
+
+inline int finish(){
+    if (failed_tests != 0){
+        std::fprintf(stderr, "%d test(s) failed, %d check(s)\n", failed_tests, failed_checks);
+        return 1;
+    }
+    return 0;
+}
+
+template <typename Lhs, typename Rhs>
+bool same_elements(const Lhs& lhs, const Rhs& rhs){
+    return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+// the same elements in the reverse order (through the reverse iterators of lhs)
+template <typename Lhs, typename Rhs>
+bool same_reversed(const Lhs& lhs, const Rhs& rhs){
+    return std::equal(lhs.rbegin(), lhs.rend(), rhs.rbegin(), rhs.rend());
+}
+
+// splitmix64: the deterministic pseudo-random sequence of the differential tests
+class random_sequence{
+    uint64_t m_state;
+
+public:
+    explicit random_sequence(uint64_t seed): m_state(seed){}
+
+    uint64_t next(){
+        uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // uniform enough in [0, bound) for the tests; bound > 0
+    size_t below(size_t bound) {return static_cast<size_t>(next() % bound);}
+};
+
+// the string, which doesn't fit the small string buffer (the element with the heap memory)
+inline std::string long_string(uint64_t key){
+    return std::to_string(key) + std::string(24, 'x');
+}
+
+/*
+    Element, which counts its live instances: the container must destroy every element,
+    which it constructed (live() == 0 after the container is destroyed).
+    The count is atomic: the parallel algorithms construct and destroy the elements on their threads.
+*/
+class tracked{
+    inline static std::atomic<long> live_count_{0};
+    int m_value;
+
+public:
+    tracked(int value = 0): m_value(value) {++live_count_;}
+    tracked(const tracked& other): m_value(other.m_value) {++live_count_;}
+    tracked(tracked&& other) noexcept: m_value(other.m_value) {++live_count_;}
+    tracked& operator=(const tracked& other) = default;
+    tracked& operator=(tracked&& other) noexcept = default;
+    ~tracked() {--live_count_;}
+
+    int value() const {return m_value;}
+
+    bool operator==(const tracked& other) const {return m_value == other.m_value;}
+    bool operator!=(const tracked& other) const {return m_value != other.m_value;}
+    bool operator<(const tracked& other) const {return m_value < other.m_value;}
+
+    static long live() {return live_count_;}
+};
+
+/*
+    std::allocator, which counts the allocate() calls and their bytes of all its rebinds
+    (the buckets and the bucket array of the deque, the nodes of the list): the tests read
+    the difference of the counts around the operation, which must (not) allocate.
+*/
+struct allocation_counts{
+    inline static size_t calls = 0;
+    inline static size_t bytes = 0;
+};
+
+template <typename T>
+class counting_allocator{
+public:
+    using value_type = T;
+
+    counting_allocator() = default;
+    template <typename U>
+    counting_allocator(const counting_allocator<U>&) {}
+
+    T* allocate(size_t count){
+        T* result = std::allocator<T>().allocate(count);
+        ++allocation_counts::calls;
+        allocation_counts::bytes += count * sizeof(T);
+        return result;
+    }
+    void deallocate(T* ptr, size_t count) {std::allocator<T>().deallocate(ptr, count);}
+
+    template <typename U>
+    bool operator==(const counting_allocator<U>&) const {return true;}
+    template <typename U>
+    bool operator!=(const counting_allocator<U>&) const {return false;}
+};
+
+} // end namespace test
+} // end namespace Farebl
+
+#define FAREBL_CHECK(condition)                                                      \
+    do{                                                                              \
+        if (!(condition)) {Farebl::test::report_failure(#condition, __FILE__, __LINE__);} \
+    } while (false)
+
+#define FAREBL_CHECK_THROWS(expression, exception_type)                              \
+    do{                                                                              \
+        bool thrown_ = false;                                                        \
+        try {(void)(expression);}                                                    \
+        catch(const exception_type&) {thrown_ = true;}                               \
+        if (!thrown_) {Farebl::test::report_failure(#expression " throws " #exception_type, __FILE__, __LINE__);} \
+    } while (false)
+
+#endif // FAREBL_TEST_COMMON_H